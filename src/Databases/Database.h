@@ -24,17 +24,24 @@
 #include <FileFormats/csv.h>
 #include <FileFormats/iceberg.h>
 #include <FileFormats/parquet.h>
+#include <Session/CorpusPack.h>
+#include <Session/CrashTriage.h>
 #include <time.h>
 #include <wait.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
 // Base class for target databases
@@ -46,11 +53,10 @@ public:
   DatabaseHandler() = default;
   ~DatabaseHandler() = default;
 
-#define RADAMSA_BUFFER_SIZE 1024 * 1024 // 1 MB buffer for Radamsa mutations
-
-  // Buffers and corpus
-  char *radamsa_output =
-      new char[RADAMSA_BUFFER_SIZE]; // allocate buffer for Radamsa mutations
+  // Buffers and corpus. The format fuzzer grows the mutation buffer to fit
+  // its corpus; radamsa_output stays valid meanwhile (see MutationBuffer).
+  MutationBuffer mutation_output{kMinMutationBytes};
+  char *radamsa_output = mutation_output.data(); // Radamsa mutations
   corpus_buffer metadata_corpus;     // corpus for Iceberg fuzzer
   corpus_buffer manifest_corpus;
   corpus_buffer input_corpus; // corpus for other format fuzzers (CSV, Parquet)
@@ -58,12 +64,41 @@ public:
   // Database and fuzzing state
   size_t crash_size = 0;            // size of the crash file
   size_t execs = 0;                 // number of queries executed
+  size_t max_inflight = 1;          // concurrent queries (--inflight)
+  size_t mutators = 0;              // mutator processes (--mutators)
+  size_t batch = 1;                 // mutations per query round (--batch)
+  connection_options http_options;  // --http, --no-keepalive, --nagle, auth
+  readiness_options readiness;      // startup probe (--health-*, --ready-*)
+  CoverageMap *coverage = nullptr;  // edge map (--coverage), owned by main
+  uint64_t master_seed = 0;         // --seed, or drawn once at startup
+  std::optional<mutation_origin> replay; // --replay: the one iteration to run
+  size_t shard_index = 0;           // corpus shard loaded (--jobs)
+  size_t shard_count = 1;
+  std::string corpus_cache;         // preprocessed corpus (--corpus-cache)
+  size_t compress_corpus = 0; // --compress-corpus: MiB of inflated seeds kept
   std::vector<std::string> queries; // queries to execute
 
   // Target process and connection
   CURL *curl = nullptr;
   pid_t target_pid; // child pid
 
+  // Format fuzzer, created by the first fuzz() call and kept across target
+  // restarts (--continue) so corpus position, RNG, slots and the Iceberg
+  // sequence carry over.
+  std::unique_ptr<FileFuzzerBase> fuzzer;
+
+  // The target's stderr, teed to ours; its tail is the sanitizer report
+  // crash triage buckets on. Re-opened by every ForkTarget().
+  StderrCapture target_stderr;
+
+  // Set when the corpus was loaded from a pack: corpus entries point into
+  // its read-only mapping.
+  std::unique_ptr<CorpusPack> corpus_pack;
+
+  // Called with the new pid whenever the fuzzer itself restarts the target
+  // (--batch bisection), so main's SIGINT handler signals the right one.
+  std::function<void(pid_t)> target_restarted;
+
   // Configuration
   std::string file_format;          // file-format to fuzz
   std::vector<char *> execv_args;   // args to launch target binary
@@ -84,58 +119,227 @@ public:
   bool add_column_filters = false;
   std::string table_expr_for_column_filters;
 
+  // --parquet-modes: parquet_mode bits the Parquet fuzzer draws from.
+  unsigned parquet_modes = kParquetDefaultModes;
+  // --csv-modes: csv_mode bits the CSV fuzzer draws from.
+  unsigned csv_modes = kCsvDefaultModes;
+  // --parquet-scale: MiB per synthesized Parquet file (0 = mutate seeds),
+  // and the CSV report of what each one cost the target.
+  size_t parquet_scale = 0;
+  std::string scale_report;
+
+protected:
+  // Backends get their format fuzzer through here, so it is configured
+  // once and then reused by every later fuzz() call.
+  template <typename Fuzzer> Fuzzer &format_fuzzer() {
+    if (!fuzzer) {
+      fuzzer = std::make_unique<Fuzzer>(this->target_pid,
+                                        this->fuzzer_mutation_path);
+      fuzzer->max_inflight = this->max_inflight;
+      fuzzer->mutators = this->mutators;
+      fuzzer->batch = this->batch;
+      fuzzer->seed_cache_bytes = this->compress_corpus << 20;
+      fuzzer->restart_target = [this]() {
+        RestartTarget();
+        if (target_restarted) {
+          target_restarted(target_pid);
+        }
+        return curl;
+      };
+      fuzzer->http_options = this->http_options;
+      fuzzer->coverage = this->coverage;
+      fuzzer->output = &this->mutation_output;
+      fuzzer->master_seed = this->master_seed;
+      fuzzer->replay = replay ? &*replay : nullptr;
+    }
+    return static_cast<Fuzzer &>(*fuzzer);
+  }
+
+public:
+
   // Abstract interfaces
   // launches target db (override in derived classes)
   virtual pid_t ForkTarget() = 0;
 
-  // calls a file-format fuzzer (override in derived classes)
+  // calls a file-format fuzzer (override in derived classes). Returns -1 on
+  // a failed query (possible crash), -2 when the target hung and was killed.
   virtual int8_t fuzz() = 0;
 
-  // Load seed corpus
-  inline void _load_corpus(std::string &corpus_dir) {
-    FileFuzzerBase fuzzer_base;
+  // Crash-and-continue: the caller has reaped the old target. Drop the
+  // fuzzer's connections and the curl handle, launch a new target and
+  // resume the same fuzzer against it.
+  inline pid_t RestartTarget() {
+    if (fuzzer) {
+      fuzzer->detach();
+    }
+    curl_easy_cleanup(curl);
+    curl = nullptr;
+    crash_size = 0;
+    ForkTarget();
+    if (fuzzer) {
+      fuzzer->attach(target_pid);
+    }
+    return target_pid;
+  }
+
+  // How corpus entries are rewritten on load (Iceberg metadata locations).
+  static FileFuzzerBase::corpus_info
+  make_corpus_info(const std::string &format,
+                   const std::optional<std::string> &bucket,
+                   const std::string &mutation_path,
+                   const std::string &cache_dir = "") {
     // local_root is the table root; the URL builder appends "/metadata/...".
-    std::filesystem::path metadata_dir(this->fuzzer_mutation_path);
+    std::filesystem::path metadata_dir(mutation_path);
     if (!metadata_dir.has_filename()) // tolerate a trailing separator
       metadata_dir = metadata_dir.parent_path();
-    fuzzer_base._corpus_info = {this->file_format, this->s3_bucket,
-                                metadata_dir.parent_path().string()};
+    FileFuzzerBase::corpus_info info{format, bucket,
+                                     metadata_dir.parent_path().string()};
+    // only Iceberg metadata is preprocessed, so only it is worth caching
+    if (format == "iceberg" && !cache_dir.empty()) {
+      std::error_code ec;
+      std::filesystem::create_directories(cache_dir, ec);
+      if (ec) {
+        std::cerr << "\033[1;33m[WARN]\033[0m Corpus cache " << cache_dir
+                  << " unavailable (" << ec.message()
+                  << "), preprocessing every file" << std::endl;
+      } else {
+        info.cache_dir = cache_dir;
+      }
+    }
+    return info;
+  }
+
+  // Threads for loading the corpus: the cores, split among --jobs workers
+  // (which load their shards at the same time).
+  static size_t corpus_load_threads(size_t shard_count = 1) {
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, cores / std::max<size_t>(1, shard_count));
+  }
 
+  // The corpus files under `corpus_dir` for `format`, sorted by path within
+  // each kind.
+  static std::vector<pack_source> corpus_sources(const std::string &corpus_dir,
+                                                 const std::string &format) {
+    std::vector<pack_source> sources;
     for (const auto &entry :
          std::filesystem::recursive_directory_iterator(corpus_dir)) {
       if (entry.is_regular_file()) {
-        if (this->file_format != "iceberg") {
-          auto return_stat = fuzzer_base.load_corpus(entry.path());
-          // check for empty corpus entries
-          if (return_stat.corpus != nullptr && return_stat.size != 0) {
-            this->input_corpus.emplace_back(return_stat);
-          } else
-            continue;
+        if (format != "iceberg") {
+          sources.push_back({pack_kind::input, entry.path()});
         }
         // Iceberg corpus loading
         else {
           // JSON corpus for metadata layer fuzzing
           if (entry.path().extension() == ".json") {
-            auto return_stat = fuzzer_base.load_corpus(entry.path());
-            // check for empty corpus entries
-            if (return_stat.corpus != nullptr && return_stat.size != 0) {
-              this->metadata_corpus.emplace_back(return_stat);
-            } else
-              continue;
+            sources.push_back({pack_kind::metadata, entry.path()});
           } else {
             // Avro corpus for manifest-list fuzzing
             if (entry.path().extension() == ".avro") {
-              auto return_stat = fuzzer_base.load_corpus(entry.path());
-              // check for empty corpus entries
-              if (return_stat.corpus != nullptr && return_stat.size != 0) {
-                this->manifest_corpus.emplace_back(return_stat);
-              } else
-                continue;
+              sources.push_back({pack_kind::manifest, entry.path()});
             }
           }
         }
       }
     }
+    std::sort(sources.begin(), sources.end(),
+              [](const pack_source &a, const pack_source &b) {
+                return a.kind != b.kind ? a.kind < b.kind : a.path < b.path;
+              });
+    return sources;
+  }
+
+  // Load seed corpus, from a directory or a corpus pack (fuzzberg pack).
+  // With --jobs, each worker loads only its shard (every shard_count-th
+  // entry of each kind, in sorted path order) so RSS doesn't grow with the
+  // number of workers; a corpus kind with fewer entries than workers is
+  // loaded in full by every worker. Files are read and preprocessed on a
+  // thread pool, through the corpus cache if there is one.
+  inline void _load_corpus(std::string &corpus_dir, size_t shard_index = 0,
+                           size_t shard_count = 1) {
+    this->shard_index = shard_index;
+    this->shard_count = shard_count;
+    auto info = make_corpus_info(this->file_format, this->s3_bucket,
+                                 this->fuzzer_mutation_path,
+                                 this->corpus_cache);
+
+    // Of `count` entries of one kind, those this worker loads.
+    auto shard_of = [&](size_t count) {
+      std::vector<size_t> picked;
+      const bool sharded = count >= shard_count;
+      for (size_t i = 0; i < count; ++i) {
+        if (!sharded || i % shard_count == shard_index)
+          picked.push_back(i);
+      }
+      return picked;
+    };
+    auto keep = [](corpus_buffer &corpus, const corpus_stat &return_stat) {
+      // check for empty corpus entries
+      if (return_stat.corpus != nullptr && return_stat.size != 0) {
+        corpus.emplace_back(return_stat);
+      }
+    };
+    auto corpus_of = [&](pack_kind kind) -> corpus_buffer & {
+      return kind == pack_kind::metadata   ? this->metadata_corpus
+             : kind == pack_kind::manifest ? this->manifest_corpus
+                                           : this->input_corpus;
+    };
+    const pack_kind kinds[] = {pack_kind::input, pack_kind::metadata,
+                               pack_kind::manifest};
+
+    if (CorpusPack::is_pack(corpus_dir)) {
+      if (this->compress_corpus) {
+        std::cout << "\033[1;33m[INFO]\033[0m A corpus pack is shared "
+                     "through the page cache; --compress-corpus is ignored"
+                  << std::endl;
+      }
+      corpus_pack = std::make_unique<CorpusPack>(corpus_dir);
+      check_pack(corpus_dir, info);
+      // Iceberg metadata is packed without this session's locations (with
+      // --jobs, each worker has a table of its own): they are written into
+      // a copy of each entry here, through the corpus cache if there is
+      // one. Everything else stays a view into the pack.
+      FileFuzzerBase fuzzer_base;
+      fuzzer_base._corpus_info = info;
+      for (pack_kind kind : kinds) {
+        std::vector<size_t> entries;
+        for (size_t i = 0; i < corpus_pack->size(); ++i) {
+          if (corpus_pack->kind(i) == kind)
+            entries.push_back(i);
+        }
+        std::vector<corpus_stat> shard;
+        for (size_t i : shard_of(entries.size())) {
+          shard.push_back(corpus_pack->entry(entries[i]));
+        }
+        if (kind == pack_kind::metadata) {
+          shard = fuzzer_base.prepare_metadata(
+              shard, corpus_load_threads(shard_count));
+        }
+        for (const auto &entry : shard) {
+          keep(corpus_of(kind), entry);
+        }
+      }
+    } else {
+      FileFuzzerBase fuzzer_base;
+      fuzzer_base._corpus_info = info;
+      fuzzer_base._corpus_info.compress = this->compress_corpus > 0;
+      auto sources = corpus_sources(corpus_dir, this->file_format);
+      for (pack_kind kind : kinds) {
+        std::vector<std::filesystem::path> paths;
+        for (const auto &source : sources) {
+          if (source.kind == kind)
+            paths.push_back(source.path);
+        }
+        std::vector<std::filesystem::path> shard;
+        for (size_t i : shard_of(paths.size())) {
+          shard.push_back(paths[i]);
+        }
+        for (const auto &return_stat : fuzzer_base.load_corpus(
+                 shard, corpus_load_threads(shard_count))) {
+          keep(corpus_of(kind), return_stat);
+        }
+      }
+    }
+
     if(this->file_format == "iceberg") {
       std::cout << "\033[1;32m[+]\033[0m Loaded \033[1;36m" 
           << this->metadata_corpus.size()
@@ -149,33 +353,58 @@ public:
           << "\033[0m files in the corpus."
           << std::endl;
     }
+    if (this->compress_corpus) {
+      size_t inflated = 0, stored = 0;
+      for (auto *corpus : {&input_corpus, &metadata_corpus, &manifest_corpus}) {
+        for (const auto &corpus_stat : *corpus) {
+          inflated += corpus_stat.size;
+          stored += corpus_stat.stored ? corpus_stat.stored : corpus_stat.size;
+        }
+      }
+      std::cout << "\033[1;32m[+]\033[0m Corpus stored in \033[1;36m"
+                << std::fixed << std::setprecision(1) << stored / 1048576.0
+                << "\033[0m MiB (" << inflated / 1048576.0
+                << " MiB inflated)" << std::defaultfloat << std::endl;
+    }
   }
 
-  inline void _write_crash(char *crash_string, std::string &crash_dir) {
+  inline void _write_crash(char *crash_string, std::string &crash_dir,
+                           const char *kind = "crash",
+                           const nlohmann::json *replay_log = nullptr) {
     FileFuzzerBase fuzzer_base;
-    return fuzzer_base.write_crash(crash_string, this->crash_size, crash_dir);
+    return fuzzer_base.write_crash(crash_string, this->crash_size, crash_dir,
+                                   kind, replay_log);
   }
 
   inline void cleanup() {
-    delete[] radamsa_output;
+    fuzzer.reset(); // releases its handles before curl goes away
+    target_stderr.stop();
+    mutation_output.release();
     radamsa_output = nullptr;
     curl_easy_cleanup(curl);
     curl = nullptr;
-    if (file_format == "iceberg") {
-      for (auto &corpus_stat : metadata_corpus) {
-        delete[] corpus_stat.corpus;
-        corpus_stat.corpus = nullptr;
-      }
-      for (auto &corpus_stat : manifest_corpus) {
-        delete[] corpus_stat.corpus;
-        corpus_stat.corpus = nullptr;
-      }
-    } else {
-      for (auto &corpus_stat : input_corpus) {
-        delete[] corpus_stat.corpus;
+    for (auto *corpus : {&input_corpus, &metadata_corpus, &manifest_corpus}) {
+      for (auto &corpus_stat : *corpus) {
+        if (corpus_stat.owned)
+          delete[] corpus_stat.corpus;
         corpus_stat.corpus = nullptr;
       }
     }
+    corpus_pack.reset(); // after the views into it are gone
+  }
+
+private:
+  // Refuse a pack of another format. Iceberg locations are the session's
+  // whatever the pack was built with: they are rewritten on load.
+  inline void check_pack(const std::string &path,
+                         const FileFuzzerBase::corpus_info &info) {
+    const std::string format = corpus_pack->info().value("format", "");
+    if (format != info.format) {
+      std::cerr << "Error: corpus pack " << path << " was built for format "
+                << format << "; re-run fuzzberg pack with this session's -f"
+                << std::endl;
+      exit(1);
+    }
   }
 };
 
@@ -23,22 +23,29 @@
 
 namespace fuzzberg {
 pid_t DuckDB::ForkTarget() {
+  target_stderr.open();
   pid_t pid = fork();
   if (pid < 0) {
     perror("fork failed");
     exit(1);
   } else if (pid == 0) {
+    target_stderr.child();
     execv(execv_args[0], execv_args.data());
     perror("execv failed");
     exit(1);
   }
 
   // Parent
+  target_stderr.parent();
   FileFuzzerBase fuzzer_base;
-  auto init_code = fuzzer_base.curlinit(db_url); // Test connection to target
+  // Test connection to target
+  auto init_code = fuzzer_base.wait_until_ready(db_url, pid, this->readiness,
+                                                this->http_options);
   if (init_code != CURLE_OK) {
     std::cerr << "\nConnection to local server failed, fuzzer exiting..\n"
               << std::endl;
+    kill(pid, SIGKILL); // don't leave a half-started target behind
+    waitpid(pid, nullptr, 0);
     exit(1);
   } else {
     std::cout << "Start fuzzing...\n";
@@ -52,13 +59,15 @@ pid_t DuckDB::ForkTarget() {
 int8_t DuckDB::fuzz() {
   // CSV Fuzzer
   if (file_format == "csv") {
-    CSVFuzzer csv_fuzzer(this->target_pid, this->fuzzer_mutation_path);
+    auto &csv_fuzzer = format_fuzzer<CSVFuzzer>();
+    csv_fuzzer.modes = this->csv_modes;
     auto status =
         csv_fuzzer.Fuzz(this->queries, this->db_url, this->input_corpus,
                         this->radamsa_output, this->execs, this->curl);
 
-    if (status == -1) {
-      return -1;
+    if (status < 0) {
+      crash_size = csv_fuzzer.crash_input_size;
+      return status;
     }
   }
 
@@ -24,22 +24,29 @@
 namespace fuzzberg {
 
 pid_t FireboltCore::ForkTarget() {
+  target_stderr.open();
   pid_t pid = fork();
   if (pid < 0) {
     perror("fork failed");
     exit(1);
   } else if (pid == 0) { // Child process
+    target_stderr.child();
     execv(execv_args[0], execv_args.data());
     perror("execv failed");
     exit(1);
   }
 
   // Parent
+  target_stderr.parent();
   FileFuzzerBase fuzzer_base;
-  auto init_code = fuzzer_base.curlinit(db_url); // Test connection to target
+  // Test connection to target
+  auto init_code = fuzzer_base.wait_until_ready(db_url, pid, this->readiness,
+                                                this->http_options);
   if (init_code != CURLE_OK) {
     std::cerr << "\nConnection to local server failed, fuzzer exiting..\n"
               << std::endl;
+    kill(pid, SIGKILL); // don't leave a half-started target behind
+    waitpid(pid, nullptr, 0);
     exit(1);
   } else {
     this->curl = curl_easy_init(); // re-use CURL handle to speed up fuzzing
@@ -52,67 +59,73 @@ pid_t FireboltCore::ForkTarget() {
 int8_t FireboltCore::fuzz() {
   // CSV Fuzzer
   if (file_format == "csv") {
-    CSVFuzzer csv_fuzzer(this->target_pid, this->fuzzer_mutation_path);
+    auto &csv_fuzzer = format_fuzzer<CSVFuzzer>();
+    csv_fuzzer.modes = this->csv_modes;
     auto status =
         csv_fuzzer.Fuzz(this->queries, this->db_url, this->input_corpus,
                         this->radamsa_output, this->execs, this->curl);
-    if (status == -1) {
-      return -1;
+    if (status < 0) {
+      crash_size = csv_fuzzer.crash_input_size;
+      return status;
     }
   }
   // Parquet Fuzzer
   else if (file_format == "parquet") {
-    ParquetFuzzer parquet_fuzzer(this->target_pid, this->fuzzer_mutation_path);
+    auto &parquet_fuzzer = format_fuzzer<ParquetFuzzer>();
+    parquet_fuzzer.modes = this->parquet_modes;
+    parquet_fuzzer.scale_bytes = uint64_t{this->parquet_scale} << 20;
+    parquet_fuzzer.scale_report = this->scale_report;
     auto status =
         parquet_fuzzer.Fuzz(this->queries, this->db_url, this->input_corpus,
                             this->radamsa_output, execs, this->curl);
-    if (status == -1) {
+    if (status < 0) {
       crash_size = parquet_fuzzer.crash_input_size;
-      return -1;
+      return status;
     }
   }
   // Iceberg Fuzzer
   else if (file_format == "iceberg") {
-    IcebergFuzzer iceberg_fuzzer(this->target_pid, this->fuzzer_mutation_path);
+    auto &iceberg_fuzzer = format_fuzzer<IcebergFuzzer>();
     // Plumb optional per-iteration column-filter generation through to
     // the fuzzer. Off by default; enabled via `add_column_filters: true`
     // in queries.json (see main.cpp).
     iceberg_fuzzer.add_column_filters = this->add_column_filters;
     iceberg_fuzzer.table_expr_for_column_filters =
         this->table_expr_for_column_filters;
-
-    // Propagate crash_input_size out of the iceberg fuzzer so
-    // _write_crash later writes the actual offending mutation bytes.
-    // Without this, only the parquet path copied crash_input_size
-    // into the DatabaseHandler's crash_size; iceberg's crash
-    // artifacts were always zero-length.
-    auto record_and_return = [&](int8_t status) {
-      if (status == -1) {
-        this->crash_size = iceberg_fuzzer.crash_input_size;
-      }
-      return status;
-    };
+    if (replay) {
+      iceberg_fuzzer.replay_from(*replay, this->metadata_corpus);
+    }
 
     // For Iceberg fuzzing, we start the loop here as there is sequential
-    // fuzzing logic involved
+    // fuzzing logic involved. Each sequence advances iceberg_fuzzer.sequence,
+    // so after a target restart the loop resumes behind the failed step.
     while (1) {
-      auto status = iceberg_fuzzer.fuzz_metadata_random(
-          this->queries, this->db_url, this->radamsa_output, this->execs,
-          this->curl, this->metadata_corpus);
-      if (record_and_return(status) == -1) {
-        return -1;
+      int8_t status = 0;
+      switch (iceberg_fuzzer.sequence) {
+      case 1:
+        status = iceberg_fuzzer.fuzz_metadata_random(
+            this->queries, this->db_url, this->radamsa_output, this->execs,
+            this->curl, this->metadata_corpus);
+        break;
+      case 2:
+        status = iceberg_fuzzer.fuzz_metadata_structured(
+            this->queries, this->db_url, this->radamsa_output, this->execs,
+            this->curl);
+        break;
+      default:
+        status = iceberg_fuzzer.fuzz_manifest_list_structured(
+            this->queries, this->db_url, this->manifest_corpus,
+            this->radamsa_output, this->execs, this->curl);
+        break;
       }
-      status = iceberg_fuzzer.fuzz_metadata_structured(
-          this->queries, this->db_url, this->radamsa_output, this->execs,
-          this->curl);
-      if (record_and_return(status) == -1) {
-        return -1;
+      // Propagate crash_input_size out of the iceberg fuzzer so
+      // _write_crash later writes the actual offending mutation bytes.
+      if (status < 0) {
+        this->crash_size = iceberg_fuzzer.crash_input_size;
+        return status;
       }
-      status = iceberg_fuzzer.fuzz_manifest_list_structured(
-          this->queries, this->db_url, this->manifest_corpus,
-          this->radamsa_output, this->execs, this->curl);
-      if (record_and_return(status) == -1) {
-        return -1;
+      if (replay) {
+        return 0; // the replayed step is done
       }
     }
   } else {
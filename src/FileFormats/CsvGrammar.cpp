@@ -0,0 +1,800 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+
+#include "CsvGrammar.h"
+
+extern "C" {
+#include <radamsa.h>
+}
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iterator>
+
+namespace fuzzberg {
+
+namespace {
+
+constexpr size_t kSniffBytes = 64 << 10; // the dialect comes from the first
+constexpr size_t kSniffRows = 100;       // rows of a seed
+constexpr size_t kMaxFields = size_t{1} << 20;
+constexpr char kDelimiters[] = {',', ';', '\t', '|'};
+constexpr char kQuotes[] = {'"', '\''};
+
+// Splits rows into fields the way most readers do: a field that starts
+// with the quote runs to the closing quote, and whatever follows that up
+// to the delimiter still belongs to it. An unterminated quote runs to the
+// end of the data.
+class csv_scanner {
+public:
+  csv_scanner(const char *data, size_t size, const csv_dialect &dialect)
+      : _data(data), _size(size), _dialect(dialect) {}
+
+  // The next field (its column is left alone) and whether it ends its
+  // row; false at the end of the data.
+  bool next(csv_field &field, bool &last) {
+    if (_pos >= _size && !_pending) {
+      return false;
+    }
+    size_t i = _pos;
+    field.offset = static_cast<uint32_t>(_pos);
+    field.quoted = i < _size && _dialect.quote && _data[i] == _dialect.quote;
+    if (field.quoted) {
+      i = skip_quoted(i + 1);
+    }
+    while (i < _size && _data[i] != _dialect.delimiter && _data[i] != '\n' &&
+           _data[i] != '\r') {
+      ++i;
+    }
+    field.size = static_cast<uint32_t>(i - _pos);
+    // a delimiter is always followed by a field, if only an empty one
+    _pending = i < _size && _data[i] == _dialect.delimiter;
+    last = !_pending;
+    if (_pending) {
+      ++i;
+    } else if (i < _size) {
+      i += (_data[i] == '\r' && i + 1 < _size && _data[i + 1] == '\n') ? 2 : 1;
+    }
+    _pos = i;
+    return true;
+  }
+
+  size_t pos() const { return _pos; }
+
+private:
+  // Past the quote that closes a quoted field starting before `i`.
+  size_t skip_quoted(size_t i) const {
+    const char quote = _dialect.quote;
+    const char escape = _dialect.escape;
+    while (i < _size) {
+      if (_data[i] == escape && escape != quote) {
+        i += 2;
+      } else if (_data[i] == quote) {
+        if (escape != quote || i + 1 >= _size || _data[i + 1] != quote) {
+          return i + 1;
+        }
+        i += 2;
+      } else {
+        ++i;
+      }
+    }
+    return _size;
+  }
+
+  const char *_data;
+  size_t _size;
+  const csv_dialect &_dialect;
+  size_t _pos = 0;
+  bool _pending = false;
+};
+
+// The first rows of a seed under a candidate dialect.
+struct csv_sample {
+  std::vector<std::vector<csv_field>> rows;
+  size_t columns = 0;    // the most common number of fields in a row
+  size_t consistent = 0; // rows with that many
+  size_t quoted = 0;     // quoted fields
+};
+
+csv_sample sample_rows(const char *data, size_t size,
+                       const csv_dialect &dialect) {
+  csv_sample sample;
+  // Whole rows only: a row cut by the sample size would not count.
+  const size_t limit = std::min(size, kSniffBytes);
+  csv_scanner scanner(data, size, dialect);
+  std::vector<csv_field> row;
+  csv_field field;
+  bool last = false;
+  while (sample.rows.size() < kSniffRows && scanner.next(field, last)) {
+    row.push_back(field);
+    sample.quoted += field.quoted;
+    if (last) {
+      sample.rows.push_back(std::move(row));
+      row.clear();
+      if (scanner.pos() >= limit) {
+        break;
+      }
+    }
+  }
+  std::vector<size_t> counts;
+  for (const auto &r : sample.rows) {
+    if (counts.size() <= r.size()) {
+      counts.resize(r.size() + 1);
+    }
+    ++counts[r.size()];
+  }
+  for (size_t n = 0; n < counts.size(); ++n) {
+    if (counts[n] > sample.consistent) {
+      sample.consistent = counts[n];
+      sample.columns = n;
+    }
+  }
+  return sample;
+}
+
+// The content of a field: without its quotes, escapes undone.
+std::string field_value(const char *data, const csv_field &field,
+                        const csv_dialect &dialect) {
+  const char *p = data + field.offset;
+  size_t n = field.size;
+  if (!field.quoted) {
+    return std::string(p, n);
+  }
+  std::string value;
+  for (size_t i = 1; i < n; ++i) {
+    if (p[i] == dialect.escape && i + 1 < n &&
+        (dialect.escape != dialect.quote || p[i + 1] == dialect.quote)) {
+      value.push_back(p[++i]);
+    } else if (p[i] == dialect.quote) {
+      // the closing quote; what follows it is kept as the reader would
+      value.append(p + i + 1, n - i - 1);
+      break;
+    } else {
+      value.push_back(p[i]);
+    }
+  }
+  return value;
+}
+
+bool all_digits(const std::string &s, size_t from, size_t to) {
+  if (from >= to || to > s.size()) {
+    return false;
+  }
+  for (size_t i = from; i < to; ++i) {
+    if (s[i] < '0' || s[i] > '9') {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool is_date(const std::string &s) {
+  return s.size() >= 10 && all_digits(s, 0, 4) && s[4] == '-' &&
+         all_digits(s, 5, 7) && s[7] == '-' && all_digits(s, 8, 10);
+}
+
+csv_type classify(const std::string &s) {
+  std::string lower(s);
+  std::transform(lower.begin(), lower.end(), lower.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  if (lower == "true" || lower == "false") {
+    return csv_type::boolean;
+  }
+  if (is_date(s)) {
+    if (s.size() == 10) {
+      return csv_type::date;
+    }
+    if (s.size() >= 19 && (s[10] == ' ' || s[10] == 'T') &&
+        all_digits(s, 11, 13) && s[13] == ':' && all_digits(s, 14, 16) &&
+        s[16] == ':' && all_digits(s, 17, 19)) {
+      return csv_type::timestamp;
+    }
+    return csv_type::text;
+  }
+  // [sign] digits [. digits] [e [sign] digits]
+  size_t i = (!s.empty() && (s[0] == '-' || s[0] == '+')) ? 1 : 0;
+  const size_t start = i;
+  while (i < s.size() && s[i] >= '0' && s[i] <= '9') {
+    ++i;
+  }
+  size_t digits = i - start;
+  if (i == s.size()) {
+    return digits ? csv_type::integer : csv_type::text;
+  }
+  if (s[i] == '.') {
+    const size_t from = ++i;
+    while (i < s.size() && s[i] >= '0' && s[i] <= '9') {
+      ++i;
+    }
+    digits += i - from;
+  }
+  if (digits && i < s.size() && (s[i] == 'e' || s[i] == 'E')) {
+    ++i;
+    if (i < s.size() && (s[i] == '-' || s[i] == '+')) {
+      ++i;
+    }
+    return all_digits(s, i, s.size()) ? csv_type::real : csv_type::text;
+  }
+  return (digits && i == s.size()) ? csv_type::real : csv_type::text;
+}
+
+// Each column's type from the rows after `first`: the one all of its
+// non-empty values have, widening integer to real and date to timestamp.
+std::vector<csv_type> column_types(const char *data, const csv_sample &sample,
+                                   const csv_dialect &dialect, size_t first) {
+  std::vector<unsigned> seen(sample.columns, 0);
+  for (size_t r = first; r < sample.rows.size(); ++r) {
+    const auto &row = sample.rows[r];
+    for (size_t c = 0; c < row.size() && c < seen.size(); ++c) {
+      const std::string value = field_value(data, row[c], dialect);
+      if (!value.empty()) {
+        seen[c] |= 1u << static_cast<unsigned>(classify(value));
+      }
+    }
+  }
+  auto bit = [](csv_type type) { return 1u << static_cast<unsigned>(type); };
+  std::vector<csv_type> types;
+  for (unsigned mask : seen) {
+    csv_type type = csv_type::text;
+    if (mask == 0 || (mask & bit(csv_type::text))) {
+      type = csv_type::text;
+    } else if ((mask & ~(bit(csv_type::integer) | bit(csv_type::real))) == 0) {
+      type = (mask & bit(csv_type::real)) ? csv_type::real : csv_type::integer;
+    } else if (mask == bit(csv_type::boolean)) {
+      type = csv_type::boolean;
+    } else if ((mask & ~(bit(csv_type::date) | bit(csv_type::timestamp))) ==
+               0) {
+      type = (mask & bit(csv_type::timestamp)) ? csv_type::timestamp
+                                                : csv_type::date;
+    }
+    types.push_back(type);
+  }
+  return types;
+}
+
+// A first row of non-empty text over columns that are not all text, or
+// whose values do not come up again below it.
+bool has_header(const char *data, const csv_sample &sample,
+                const csv_dialect &dialect) {
+  if (sample.rows.size() < 2) {
+    return false;
+  }
+  const auto &first = sample.rows[0];
+  for (const auto &field : first) {
+    const std::string value = field_value(data, field, dialect);
+    if (value.empty() || classify(value) != csv_type::text) {
+      return false;
+    }
+  }
+  for (csv_type type : dialect.columns) {
+    if (type != csv_type::text) {
+      return true;
+    }
+  }
+  for (size_t c = 0; c < first.size(); ++c) {
+    const std::string name = field_value(data, first[c], dialect);
+    for (size_t r = 1; r < sample.rows.size(); ++r) {
+      if (c < sample.rows[r].size() &&
+          field_value(data, sample.rows[r][c], dialect) == name) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+csv_dialect sniff_dialect(const char *data, size_t size) {
+  // The candidate that splits the most rows into the same number of
+  // fields (more than one) wins; then the one with more quoted fields.
+  csv_dialect best;
+  csv_sample best_sample;
+  size_t best_score = 0;
+  for (char delimiter : kDelimiters) {
+    for (char quote : kQuotes) {
+      csv_dialect candidate;
+      candidate.delimiter = delimiter;
+      candidate.quote = candidate.escape = quote;
+      csv_sample sample = sample_rows(data, size, candidate);
+      const size_t score =
+          sample.columns > 1 ? sample.consistent * sample.columns : 0;
+      if (score > best_score ||
+          (score == best_score && sample.quoted > best_sample.quoted)) {
+        best = candidate;
+        best_sample = std::move(sample);
+        best_score = score;
+      }
+    }
+  }
+  if (best_sample.quoted == 0) {
+    best.quote = best.escape = '"';
+  }
+
+  // Backslash escapes if quoted fields hold \" more often than "".
+  size_t backslashed = 0, doubled = 0;
+  for (const auto &row : best_sample.rows) {
+    for (const auto &field : row) {
+      const char *p = data + field.offset;
+      for (size_t i = 1; field.quoted && i + 1 < field.size; ++i) {
+        if (p[i + 1] == best.quote) {
+          backslashed += p[i] == '\\';
+          doubled += p[i] == best.quote;
+        }
+      }
+    }
+  }
+  if (backslashed > doubled) {
+    best.escape = '\\';
+  }
+  best_sample = sample_rows(data, size, best);
+
+  const char *newline = static_cast<const char *>(
+      memchr(data, '\n', std::min(size, kSniffBytes)));
+  best.crlf = newline && newline > data && newline[-1] == '\r';
+  best.columns = column_types(data, best_sample, best, 0);
+  best.header = has_header(data, best_sample, best);
+  if (best.header) {
+    best.columns = column_types(data, best_sample, best, 1);
+  }
+  return best;
+}
+
+// `value` as a field: quoted, with quotes and escapes escaped, if it has
+// to be (or `force`) and the dialect quotes at all.
+std::string encode(const std::string &value, const csv_dialect &dialect,
+                   bool force) {
+  if (!dialect.quote) {
+    return value;
+  }
+  bool needs = force;
+  for (char c : value) {
+    needs |= c == dialect.delimiter || c == dialect.quote || c == '\n' ||
+             c == '\r' || c == dialect.escape;
+  }
+  if (!needs) {
+    return value;
+  }
+  std::string field(1, dialect.quote);
+  for (char c : value) {
+    if (c == dialect.quote || c == dialect.escape) {
+      field.push_back(dialect.escape);
+    }
+    field.push_back(c);
+  }
+  field.push_back(dialect.quote);
+  return field;
+}
+
+// Boundary and odd values of a type, as text.
+std::string boundary_value(csv_type type, RandomStream &rng) {
+  static const char *const kIntegers[] = {
+      "0", "-0", "+0", "-1", "1", "127", "128", "-129", "255", "256",
+      "32767", "32768", "-32769", "2147483647", "2147483648", "-2147483648",
+      "-2147483649", "4294967295", "4294967296", "9223372036854775807",
+      "9223372036854775808", "-9223372036854775808", "-9223372036854775809",
+      "18446744073709551615", "18446744073709551616", "007", " 1", "1 ",
+      "1,000", "1_000", "0x10", "1e3", "--1", "+-1", "\xd9\xa1\xd9\xa2"};
+  static const char *const kReals[] = {
+      "0.0", "-0.0", ".5", "5.", "-.5", "1e308", "1.7976931348623157e308",
+      "1.7976931348623159e308", "1e309", "-1e309", "4.9e-324", "2.5e-324",
+      "2.2250738585072014e-308", "1e-400", "NaN", "nan", "-nan", "inf",
+      "-inf", "Infinity", "-Infinity", "1.0e", "1e+", "0.1e-2147483649",
+      "3.4028235e38", "3.4028236e38", "1,5", "0.30000000000000004",
+      "123456789012345678901234567890.123456789"};
+  static const char *const kBooleans[] = {
+      "true", "false", "TRUE", "False", "t",   "f",      "1", "0",
+      "yes",  "no",    "on",   "off",   "tru", "falsee", "2", "-1"};
+  static const char *const kDates[] = {
+      "0000-01-01", "0001-01-01", "9999-12-31", "10000-01-01", "-0001-12-31",
+      "1970-01-01", "1969-12-31", "2000-02-29", "2100-02-29", "2024-02-30",
+      "2024-13-01", "2024-00-10", "2024-01-00", "2024-01-32", "2024-1-1",
+      "2024/01/01", "01/02/2024", "20240101", "1582-10-10", "2038-01-19",
+      "292278994-08-17"};
+  static const char *const kTimestamps[] = {
+      "1970-01-01 00:00:00", "1969-12-31 23:59:59.999999",
+      "9999-12-31 23:59:59.999999999", "0001-01-01T00:00:00",
+      "2024-06-30 23:59:60", "2024-01-01 24:00:00", "2024-01-01 23:60:00",
+      "2024-01-01 00:00:00+14:00", "2024-01-01 00:00:00-12:59",
+      "2024-01-01 00:00:00+25:00", "2024-01-01 00:00:00Z",
+      "2024-01-01 00:00:00.1234567890123", "2024-01-01 00:00",
+      "2024-01-01T", "2038-01-19 03:14:08", "2262-04-11 23:47:16.854775808",
+      "1677-09-21 00:12:43.145224191", "1970-01-01 00:00:00 UTC"};
+  static const char *const kTexts[] = {
+      "", " ", "NULL", "null", "\\N", "NA", "N/A", "#N/A", "-", "nil",
+      "\xef\xbb\xbf", "\xc0\xaf", "\xff\xfe", "\xf0\x9f\x98\x80",
+      "\xed\xa0\x80", "\xf4\x90\x80\x80", "%s%s%n", "=1+1", "\\", "'",
+      "\t", "a\tb", "\x7f", "\x1b[0m"};
+
+  switch (type) {
+  case csv_type::integer:
+    if (rng.below(4) == 0) { // more digits than any integer type holds
+      return (rng.below(2) ? "-" : "") +
+             std::string(20 + rng.below(300), '9');
+    }
+    return kIntegers[rng.below(std::size(kIntegers))];
+  case csv_type::real:
+    if (rng.below(4) == 0) {
+      return "0." + std::string(1 + rng.below(800), '1') + "e" +
+             std::to_string(static_cast<int>(rng.below(700)) - 350);
+    }
+    return kReals[rng.below(std::size(kReals))];
+  case csv_type::boolean:
+    return kBooleans[rng.below(std::size(kBooleans))];
+  case csv_type::date:
+    return kDates[rng.below(std::size(kDates))];
+  case csv_type::timestamp:
+    return kTimestamps[rng.below(std::size(kTimestamps))];
+  default:
+    if (rng.below(4) == 0) { // long runs, NULs and invalid UTF-8 included
+      const char fill[] = {'a', '\0', '\xff', '\xe2', ' ', '"'};
+      return std::string(size_t{1} << rng.below(17),
+                         fill[rng.below(std::size(fill))]);
+    }
+    return kTexts[rng.below(std::size(kTexts))];
+  }
+}
+
+struct csv_edit {
+  size_t offset;
+  size_t removed; // seed bytes replaced by `text`
+  std::string text;
+};
+
+// The fields of row `r`: [first, end).
+void row_fields(const csv_index &index, size_t r, size_t &first,
+                size_t &end) {
+  first = index.rows[r];
+  end = r + 1 < index.rows.size() ? index.rows[r + 1] : index.fields.size();
+}
+
+// Where row `r` starts, where its last field ends, and where the next row
+// starts (past its line ending).
+void row_bounds(const csv_index &index, size_t r, size_t &start,
+                size_t &content_end, size_t &end) {
+  size_t first, last;
+  row_fields(index, r, first, last);
+  const csv_field &tail = index.fields[last - 1];
+  start = index.fields[first].offset;
+  content_end = tail.offset + tail.size;
+  end = r + 1 < index.rows.size() ? index.fields[index.rows[r + 1]].offset
+                                  : index.end;
+}
+
+// A field to edit; data rows only, except now and then.
+size_t pick_field(const csv_index &index, RandomStream &rng) {
+  const size_t first = (index.dialect.header && index.rows.size() > 1 &&
+                        rng.below(8) != 0)
+                           ? index.rows[1]
+                           : 0;
+  return first + rng.below(index.fields.size() - first);
+}
+
+csv_type column_type(const csv_index &index, const csv_field &field) {
+  return field.column < index.dialect.columns.size()
+             ? index.dialect.columns[field.column]
+             : csv_type::text;
+}
+
+// A value for `field`: a boundary of its column's type, now and then of
+// another type.
+csv_edit value_edit(const csv_index &index, const csv_field &field,
+                    RandomStream &rng) {
+  csv_type type = column_type(index, field);
+  if (rng.below(4) == 0) {
+    type = static_cast<csv_type>(rng.below(6));
+  }
+  return {field.offset, field.size,
+          encode(boundary_value(type, rng), index.dialect, field.quoted)};
+}
+
+csv_edit quote_edit(const char *data, const csv_index &index,
+                    const csv_field &field, RandomStream &rng) {
+  const csv_dialect &d = index.dialect;
+  if (!d.quote) {
+    return value_edit(index, field, rng);
+  }
+  const std::string q(1, d.quote);
+  std::string value = field_value(data, field, d);
+  const size_t at = rng.below(value.size() + 1);
+  std::string text;
+  switch (rng.below(7)) {
+  case 0: // quoted, although it need not be
+    text = encode(value, d, true);
+    break;
+  case 1: // an escaped quote inside
+    value.insert(at, q);
+    text = encode(value, d, true);
+    break;
+  case 2: // a quote escaped the other way
+    text = q + value.substr(0, at) + (d.escape == d.quote ? "\\" : q) + q +
+           value.substr(at) + q;
+    break;
+  case 3: // never closed: the reader runs on into the next rows
+    text = field.quoted ? encode(value, d, true) : q + value;
+    if (field.quoted) {
+      text.pop_back();
+    }
+    break;
+  case 4: // a bare quote in an unquoted field
+    value.insert(at, q);
+    text = value;
+    break;
+  case 5: // text after the closing quote
+    text = encode(value, d, true) + (rng.below(2) ? " " : "x");
+    break;
+  default: // empty, but quoted
+    text = q + q;
+  }
+  return {field.offset, field.size, std::move(text)};
+}
+
+csv_edit newline_edit(const char *data, const csv_index &index,
+                      const csv_field &field, RandomStream &rng) {
+  const char *const kBreaks[] = {"\n", "\r\n", "\r", "\n\n"};
+  std::string value = field_value(data, field, index.dialect);
+  value.insert(rng.below(value.size() + 1), kBreaks[rng.below(4)]);
+  // now and then unquoted, which splits the row
+  return {field.offset, field.size,
+          rng.below(8) ? encode(value, index.dialect, true) : value};
+}
+
+// A column more or less, and other row shapes.
+csv_edit drift_edit(const csv_index &index, RandomStream &rng) {
+  const csv_dialect &d = index.dialect;
+  const size_t r = rng.below(index.rows.size());
+  size_t first, last, start, content_end, end;
+  row_fields(index, r, first, last);
+  row_bounds(index, r, start, content_end, end);
+  const std::string delimiter(1, d.delimiter);
+  switch (rng.below(5)) {
+  case 0: // one field more
+    return {content_end, 0,
+            delimiter + encode(boundary_value(static_cast<csv_type>(
+                                                  rng.below(6)),
+                                              rng),
+                               d, false)};
+  case 1: // one field less
+    if (last - first > 1) {
+      const size_t k = first + 1 + rng.below(last - first - 1);
+      const csv_field &before = index.fields[k - 1];
+      const size_t from = before.offset + before.size;
+      const csv_field &gone = index.fields[k];
+      return {from, gone.offset + gone.size - from, ""};
+    }
+    return {start, content_end - start, ""}; // the only one, emptied
+  case 2: { // many more, empty
+    const size_t columns = std::max<size_t>(d.columns.size(), 1);
+    const size_t extra = rng.below(8) ? 1 + rng.below(2 * columns)
+                                      : size_t{1} << rng.below(16);
+    std::string text;
+    for (size_t i = 0; i < extra; ++i) {
+      text += delimiter;
+    }
+    return {content_end, 0, std::move(text)};
+  }
+  case 3: // joined with the next row
+    return {content_end, end - content_end, delimiter};
+  default: // an empty row before it
+    return {start, 0, d.crlf ? "\r\n" : "\n"};
+  }
+}
+
+csv_edit row_edit(const char *data, const csv_index &index, size_t size,
+                  size_t capacity, RandomStream &rng) {
+  const csv_dialect &d = index.dialect;
+  const std::string newline = d.crlf ? "\r\n" : "\n";
+  const size_t r = rng.below(index.rows.size());
+  size_t start, content_end, end;
+  row_bounds(index, r, start, content_end, end);
+  switch (rng.below(5)) {
+  case 0: { // repeated, up to a few thousand times
+    const std::string row =
+        std::string(data + start, content_end - start) + newline;
+    size_t copies = size_t{1} << rng.below(12);
+    copies = std::min(copies, capacity / 2 / row.size());
+    std::string text;
+    text.reserve(row.size() * copies);
+    for (size_t i = 0; i < copies; ++i) {
+      text += row;
+    }
+    return {start, 0, std::move(text)};
+  }
+  case 1: // dropped
+    return {start, end - start, ""};
+  case 2: { // the first row (the header) again
+    size_t first_start, first_content_end, first_end;
+    row_bounds(index, 0, first_start, first_content_end, first_end);
+    return {start, 0,
+            std::string(data + first_start, first_content_end - first_start) +
+                newline};
+  }
+  case 3: { // the file cut short inside it
+    const size_t at = start + rng.below(content_end - start + 1);
+    return {at, size - at, ""};
+  }
+  default: { // another line ending, or none
+    const char *const kEndings[] = {"\n", "\r\n", "\r", "", "\n\r"};
+    return {content_end, end - content_end,
+            kEndings[rng.below(std::size(kEndings))]};
+  }
+  }
+}
+
+// Another delimiter between two fields of a row.
+csv_edit delimiter_edit(const csv_index &index, RandomStream &rng) {
+  const size_t r = rng.below(index.rows.size());
+  size_t first, last;
+  row_fields(index, r, first, last);
+  if (last - first < 2) {
+    return drift_edit(index, rng);
+  }
+  const size_t k = first + 1 + rng.below(last - first - 1);
+  const char *const kOthers[] = {",", ";", "\t", "|", " ", ", ", ",,", ""};
+  std::string text = kOthers[rng.below(std::size(kOthers))];
+  if (rng.below(4) == 0) {
+    text = std::string(1, index.dialect.delimiter) + " "; // padded
+  }
+  return {index.fields[k].offset - 1, 1, std::move(text)};
+}
+
+// Radamsa over one field only.
+csv_edit radamsa_edit(const char *data, const csv_index &index,
+                      const csv_field &field, RandomStream &rng) {
+  if (field.size == 0) {
+    return value_edit(index, field, rng);
+  }
+  std::string out(2 * field.size + 256, '\0');
+  const size_t size =
+      radamsa(reinterpret_cast<uint8_t *>(
+                  const_cast<char *>(data + field.offset)),
+              field.size, reinterpret_cast<uint8_t *>(out.data()), out.size(),
+              rng.seed32());
+  out.resize(std::min(size, out.size()));
+  return {field.offset, field.size, std::move(out)};
+}
+
+} // namespace
+
+bool index_csv(const char *data, size_t size, csv_index &index) {
+  index = {};
+  index.dialect = sniff_dialect(data, size);
+  // Offsets are 32 bits; past that the seed is copied as it is.
+  const size_t limit = std::min<size_t>(size, UINT32_MAX);
+  csv_scanner scanner(data, limit, index.dialect);
+  csv_field field;
+  bool last = false;
+  uint32_t column = 0;
+  size_t whole = 0; // fields in whole rows
+  while (scanner.next(field, last)) {
+    if (column == 0) {
+      index.rows.push_back(static_cast<uint32_t>(index.fields.size()));
+    }
+    field.column = column++ & 0x7fffffff;
+    index.fields.push_back(field);
+    if (last) {
+      column = 0;
+      if (limit < size && scanner.pos() == limit) {
+        break; // cut by the limit, not the end of a row
+      }
+      index.end = scanner.pos();
+      whole = index.fields.size();
+      // whole rows only; the rest of a huge seed is copied as it is
+      if (whole >= kMaxFields) {
+        break;
+      }
+    }
+  }
+  index.fields.resize(whole);
+  while (!index.rows.empty() && index.rows.back() >= whole) {
+    index.rows.pop_back();
+  }
+  index.fields.shrink_to_fit();
+  index.rows.shrink_to_fit();
+  return !index.fields.empty();
+}
+
+size_t mutate_csv(const char *data, size_t size, const csv_index &index,
+                  RandomStream &rng, char *out, size_t capacity) {
+  std::vector<csv_edit> edits;
+  const size_t count = 1 + rng.below(3);
+  for (size_t i = 0; i < count; ++i) {
+    const csv_field &field = index.fields[pick_field(index, rng)];
+    switch (rng.below(14)) {
+    case 0:
+    case 1:
+    case 2:
+    case 3:
+    case 4:
+      edits.push_back(value_edit(index, field, rng));
+      break;
+    case 5:
+    case 6:
+      edits.push_back(quote_edit(data, index, field, rng));
+      break;
+    case 7:
+      edits.push_back(newline_edit(data, index, field, rng));
+      break;
+    case 8:
+    case 9:
+      edits.push_back(drift_edit(index, rng));
+      break;
+    case 10:
+      edits.push_back(row_edit(data, index, size, capacity, rng));
+      break;
+    case 11:
+      edits.push_back(delimiter_edit(index, rng));
+      break;
+    default:
+      edits.push_back(radamsa_edit(data, index, field, rng));
+    }
+  }
+
+  // Seed bytes between the edits, in file order; an edit overlapping an
+  // earlier one is dropped. Whatever exceeds `capacity` is cut.
+  std::stable_sort(edits.begin(), edits.end(),
+                   [](const csv_edit &a, const csv_edit &b) {
+                     return a.offset < b.offset;
+                   });
+  size_t used = 0;
+  auto put = [&](const char *bytes, size_t n) {
+    n = std::min(n, capacity - used);
+    memcpy(out + used, bytes, n);
+    used += n;
+  };
+  size_t at = 0;
+  for (const auto &edit : edits) {
+    if (edit.offset < at) {
+      continue;
+    }
+    put(data + at, edit.offset - at);
+    put(edit.text.data(), edit.text.size());
+    at = edit.offset + edit.removed;
+  }
+  put(data + at, size - at);
+  return used;
+}
+
+std::string csv_dialect_name(const csv_dialect &dialect) {
+  static const char *const kTypeNames[] = {"text", "integer", "real",
+                                           "boolean", "date", "timestamp"};
+  auto shown = [](char c) {
+    return c == '\t' ? std::string("'\\t'") : "'" + std::string(1, c) + "'";
+  };
+  std::string name = shown(dialect.delimiter);
+  if (dialect.quote) {
+    name += " quoted by " + shown(dialect.quote);
+    if (dialect.escape != dialect.quote) {
+      name += " escaped by " + shown(dialect.escape);
+    }
+  }
+  if (dialect.header) {
+    name += ", header";
+  }
+  name += ", " + std::to_string(dialect.columns.size()) + " columns (";
+  for (size_t c = 0; c < dialect.columns.size(); ++c) {
+    name += (c ? ", " : "") +
+            std::string(kTypeNames[static_cast<size_t>(dialect.columns[c])]);
+  }
+  return name + ")";
+}
+
+} // namespace fuzzberg
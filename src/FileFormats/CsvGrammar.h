@@ -0,0 +1,98 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Random.h"
+
+// Structure-aware CSV mutations. Radamsa over a whole CSV file mostly
+// breaks the row structure, and readers reject it on the first line. Each
+// seed is instead tokenized once, before fuzzing, with its dialect sniffed
+// from the first rows: delimiter, quote, escape, header and a type per
+// column. A mutation then edits a few fields or rows:
+// - values: boundary values of the column's type (or of another type),
+//   long and odd text, radamsa over one field
+// - quoting: quotes added, doubled, escaped the other way, left open
+// - newlines embedded in quoted (and now and then unquoted) fields
+// - rows with a column more or less, empty, duplicated, dropped, or with
+//   another delimiter or line ending
+// Everything else is copied from the seed as it is, so most mutations
+// still parse, and the reader gets to type detection and conversion.
+
+namespace fuzzberg {
+
+enum class csv_type : uint8_t {
+  text,
+  integer,
+  real,
+  boolean,
+  date,
+  timestamp,
+};
+
+struct csv_dialect {
+  char delimiter = ',';
+  char quote = '"';  // 0 if fields are never quoted
+  char escape = '"'; // the quote itself for doubled quotes, or a backslash
+  bool header = false;
+  bool crlf = false; // rows end in "\r\n"
+  std::vector<csv_type> columns; // each column's type, from the first rows
+};
+
+// A field as it is in the seed, quotes included. There is one per field
+// of every indexed seed, so it is kept to 12 bytes: only the first 4 GiB
+// of a seed are indexed.
+struct csv_field {
+  uint32_t offset = 0;
+  uint32_t size = 0;
+  uint32_t column : 31;
+  uint32_t quoted : 1;
+
+  csv_field() : column(0), quoted(0) {}
+};
+static_assert(sizeof(csv_field) == 12, "csv_field is one per seed field");
+
+struct csv_index {
+  csv_dialect dialect;
+  std::vector<csv_field> fields; // in file order
+  std::vector<uint32_t> rows;    // each row's first field
+  size_t end = 0; // end of the last indexed row; the rest is copied as is
+};
+
+// Sniff the dialect of the `size` bytes at `data` and index its rows, up
+// to about a million fields (12 MiB of index). False if there is no field.
+bool index_csv(const char *data, size_t size, csv_index &index);
+
+// Write the seed of `index`, with one to three edits drawn from `rng`, to
+// `out` (at most `capacity` bytes); returns its size.
+size_t mutate_csv(const char *data, size_t size, const csv_index &index,
+                  RandomStream &rng, char *out, size_t capacity);
+
+// "';' quoted by '\"', header, 3 columns (integer, text, date)"
+std::string csv_dialect_name(const csv_dialect &dialect);
+
+} // namespace fuzzberg
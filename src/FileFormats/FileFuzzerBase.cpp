@@ -20,37 +20,362 @@
 */
 
 #include "FileFuzzerBase.h"
+#include "ParquetIndex.h"
+
+#include <Session/TargetProcess.h>
 
 #include <atomic>
 #include <ctime>
+#include <numeric>
+#include <sys/uio.h>
+#include <thread>
 #include <unistd.h>
 
 namespace fuzzberg {
 
-// Generate a random seed
-uint32_t FileFuzzerBase::seed_generator() {
-  uint32_t init_seed;
-  std::mt19937 gen;
-  std::FILE *f = std::fopen("/dev/urandom", "rb");
-  if (f) {
-    if (fread(&init_seed, 1, 4, f) == 4) {
-      gen.seed(init_seed);
+FileFuzzerBase::~FileFuzzerBase() = default;
+
+namespace {
+// `<dir>/.<name>.next`: same directory, so rename() stays atomic
+std::string staging_path(const std::filesystem::path &path) {
+  return (path.parent_path() / ("." + path.filename().string() + ".next"))
+      .string();
+}
+} // namespace
+
+QueryDispatcher &FileFuzzerBase::dispatcher(CURL *curl,
+                                            const std::string &db_url) {
+  if (!_dispatcher)
+    _dispatcher = std::make_unique<QueryDispatcher>(
+        curl, db_url, this->max_inflight, this->http_options);
+  return *_dispatcher;
+}
+
+void FileFuzzerBase::open_mutation_slots(
+    const std::string &primary_path, const std::vector<std::string> &queries,
+    char *radamsa_buffer) {
+  _slots.clear();
+  _slots.push_back({0, primary_path, staging_path(primary_path), queries,
+                    radamsa_buffer, 0});
+  // With coverage feedback every edge has to be attributed to one input,
+  // and a replay regenerates exactly one mutation into the primary file, so
+  // only one mutation is in flight (its queries still run concurrently).
+  if (coverage || replay)
+    return;
+
+  std::filesystem::path path(primary_path);
+  std::string name = path.filename().string();
+  std::string alt_name =
+      path.stem().string() + ".1" + path.extension().string();
+  std::string alt_path = (path.parent_path() / alt_name).string();
+
+  mutation_slot slot{1, alt_path, staging_path(alt_path), queries, nullptr,
+                     0};
+  bool rewritten = false;
+  for (auto &query : slot.queries) {
+    std::string original = query;
+    replace_all(query, "/" + name, "/" + alt_name);
+    rewritten |= (query != original);
+  }
+  if (!rewritten) {
+    // Without a query reading the second file, both slots would test the
+    // same one.
+    std::cerr << "\033[1;33m[WARN] No query references " << name
+              << "; not pipelining mutations.\033[0m" << std::endl;
+    return;
+  }
+  _spare_buffer.emplace(_capacity);
+  slot.buffer = _spare_buffer->data();
+  _slots.push_back(std::move(slot));
+}
+
+void FileFuzzerBase::start_mutators(const corpus_buffer &corpus) {
+  if (mutators == 0 || coverage || replay)
+    return;
+  // Four cells per mutator keep it busy while the loop is in a slow query.
+  _pool = std::make_unique<MutatorPool>(
+      mutators, 4, _capacity, _iteration,
+      [this, &corpus](uint64_t iteration, char *out, size_t capacity,
+                      mutation_tail *tail) {
+        return mutate(iteration, corpus, out, capacity, tail);
+      });
+}
+
+void FileFuzzerBase::next_mutation(uint64_t iteration,
+                                   const corpus_buffer &corpus,
+                                   mutation_slot &slot) {
+  slot.tail = {};
+  if (_pool) {
+    slot.size = _pool->take(iteration, slot.buffer, slot.tail);
+    return;
+  }
+  slot.size = mutate(iteration, corpus, slot.buffer, _capacity,
+                     coverage ? nullptr : &slot.tail);
+}
+
+void FileFuzzerBase::fit_capacity(size_t size) {
+  if (size <= _largest) {
+    return;
+  }
+  _largest = size;
+  const buffer_policy policy = mutation_policy();
+  if (size >= policy.maximum) {
+    std::cerr << "\033[1;33m[WARN] A " << size << "-byte seed exceeds the "
+              << policy.maximum << "-byte mutation limit of this format; "
+              << "its mutations are cut there\033[0m" << std::endl;
+  }
+  const size_t capacity = policy.capacity_for(size);
+  if (capacity <= _capacity) {
+    return;
+  }
+  _capacity = capacity;
+  if (output) {
+    output->grow(_capacity);
+  }
+  if (_spare_buffer) {
+    _spare_buffer->grow(_capacity);
+  }
+  for (auto &buffer : _batch_buffers) {
+    buffer.grow(_capacity);
+  }
+}
+
+void FileFuzzerBase::fit_capacity(const corpus_buffer &corpus) {
+  for (const auto &entry : corpus) {
+    fit_capacity(entry.size);
+  }
+}
+
+size_t FileFuzzerBase::materialize(const mutation_slot &slot, char *out) {
+  if (out != slot.buffer)
+    std::memcpy(out, slot.buffer, slot.size);
+  if (slot.tail.size)
+    std::memcpy(out + slot.size, slot.tail.data, slot.tail.size);
+  return slot.size + slot.tail.size;
+}
+
+int8_t FileFuzzerBase::fuzz_batches(const std::string &primary_path,
+                                    const std::vector<std::string> &queries,
+                                    std::string &db_url, corpus_buffer &corpus,
+                                    char *&radamsa_buffer, size_t &execs,
+                                    CURL *curl) {
+  std::vector<size_t> all(batch);
+  std::iota(all.begin(), all.end(), 0);
+
+  if (_batch.empty()) {
+    start_mutators(corpus);
+    std::filesystem::path path(primary_path);
+    std::string name = path.filename().string();
+    std::string glob = path.stem().string() + "_*" + path.extension().string();
+    bool rewritten = false;
+    for (size_t i = 0; i < batch; ++i) {
+      char index[24]; // "_" and any size_t
+      snprintf(index, sizeof(index), "_%03zu", i);
+      std::string file_path =
+          (path.parent_path() /
+           (path.stem().string() + index + path.extension().string()))
+              .string();
+      _batch_buffers.emplace_back(_capacity);
+      _batch.push_back({static_cast<int>(i), file_path,
+                        staging_path(file_path), {},
+                        _batch_buffers[i].data(), 0});
+    }
+    // The queries live on the first batch file: one glob covers all of them.
+    _batch[0].queries = queries;
+    for (auto &query : _batch[0].queries) {
+      std::string original = query;
+      replace_all(query, "/" + name, "/" + glob);
+      rewritten |= (query != original);
+    }
+    if (!rewritten) {
+      std::cerr << "Error: --batch needs queries that read " << name
+                << " (they are rewritten to read " << glob << ")"
+                << std::endl;
+      kill(this->_target_pid, SIGKILL);
+      exit(1);
+    }
+    std::cout << "\033[1;32m[INFO] Batching " << batch
+              << " mutations per round into " << glob << "\033[0m"
+              << std::endl;
+  }
+
+  while (1) {
+    for (auto &file : _batch) {
+      const size_t iteration = _iteration++;
+      file.origin = {iteration, 0, 0, corpus.size(), 0};
+      next_mutation(iteration, corpus, file);
+    }
+    CURLcode rc = run_batch(all, db_url, execs, curl);
+    if (rc == CURLE_OK)
+      continue;
 
+    // Find out how the target failed, then bisect the batch.
+    bool hang = (rc == CURLE_OPERATION_TIMEDOUT);
+    bool alive = true;
+    int status = 0;
+    if (hang) {
+      kill(this->_target_pid, SIGKILL);
+      waitpid(this->_target_pid, &status, 0);
+      alive = false;
+    } else if (wait_for_exit(this->_target_pid, status, kCrashExitGraceMs)) {
+      alive = false;
     } else {
-      // Seeding without /dev/random
-      gen.seed(static_cast<uint32_t>(time(NULL)) ^ getpid() ^ clock());
+      // Still serving: a harness error, not a finding. Let the caller
+      // sort it out as for a single mutation.
+      return slot_failed(_batch[0], rc, radamsa_buffer);
     }
-    std::fclose(f);
-  } else {
-    gen.seed(static_cast<uint32_t>(time(NULL)) ^ getpid() ^ clock());
+    std::cout << "\n\033[1;33m[INFO] Batch of " << batch
+              << (hang ? " hung" : " crashed")
+              << " the target, bisecting\033[0m" << std::endl;
+
+    std::vector<size_t> candidates = all;
+    while (candidates.size() > 1) {
+      size_t half = candidates.size() / 2;
+      std::vector<size_t> first(candidates.begin(), candidates.begin() + half);
+      std::vector<size_t> second(candidates.begin() + half, candidates.end());
+      candidates = batch_fails(first, hang, db_url, execs, curl, alive)
+                       ? std::move(first)
+                       : std::move(second);
+    }
+
+    // Run the culprit alone on a fresh target and leave its failure to the
+    // caller, so the crash report and artifact belong to it alone.
+    mutation_slot &culprit = _batch[candidates[0]];
+    if (!alive)
+      curl = restart_target();
+    rc = run_batch(candidates, db_url, execs, curl);
+    if (rc != CURLE_OK) {
+      crash_input_size = materialize(culprit, radamsa_buffer);
+      crash_origin = culprit.origin;
+      std::cout << "\033[1;33m[INFO] Culprit: iteration "
+                << culprit.origin.iteration << "\033[0m" << std::endl;
+      if (rc == CURLE_OPERATION_TIMEDOUT) {
+        std::cerr << "Target timed out, killing child" << std::endl;
+        kill(this->_target_pid, SIGKILL);
+        return -2;
+      }
+      return -1;
+    }
+    std::cerr << "\033[1;33m[WARN] The batch failure did not reproduce with "
+                 "a single file; continuing\033[0m"
+              << std::endl;
+  }
+  return 0;
+}
+
+CURLcode FileFuzzerBase::run_batch(const std::vector<size_t> &subset,
+                                   std::string &db_url, size_t &execs,
+                                   CURL *curl) {
+  std::vector<bool> in_subset(_batch.size(), false);
+  for (size_t i : subset)
+    in_subset[i] = true;
+  for (size_t i = 0; i < _batch.size(); ++i) {
+    if (in_subset[i])
+      publish_mutation(_batch[i]);
+    else
+      unlink(_batch[i].path.c_str()); // not matched by the glob
+  }
+  auto &queue = dispatcher(curl, db_url);
+  for (auto const &query : _batch[0].queries) {
+    execs++;
+    queue.submit(query, 0);
+  }
+  return queue.wait_slot(0);
+}
+
+bool FileFuzzerBase::batch_fails(const std::vector<size_t> &subset, bool hang,
+                                 std::string &db_url, size_t &execs,
+                                 CURL *&curl, bool &alive) {
+  if (!alive) {
+    curl = restart_target();
+    alive = true;
+  }
+  CURLcode rc = run_batch(subset, db_url, execs, curl);
+  if (rc == CURLE_OK)
+    return false;
+  int status = 0;
+  if (rc == CURLE_OPERATION_TIMEDOUT) {
+    kill(this->_target_pid, SIGKILL);
+    waitpid(this->_target_pid, &status, 0);
+    alive = false;
+    return hang;
+  }
+  if (wait_for_exit(this->_target_pid, status, kCrashExitGraceMs)) {
+    alive = false;
+    return !hang;
+  }
+  return false; // rejected the query, still serving
+}
+
+void FileFuzzerBase::detach() { _dispatcher.reset(); }
+
+void FileFuzzerBase::attach(pid_t target_pid) {
+  _dispatcher.reset();
+  this->_target_pid = target_pid;
+}
+
+int8_t FileFuzzerBase::slot_failed(mutation_slot &failed, CURLcode rc,
+                                   char *&radamsa_buffer) {
+  // The crash artifact is written from radamsa_buffer. With two slots in
+  // flight we blame the one whose queries failed first: a target that
+  // died on it refuses the other slot's queries too. The other mutation
+  // is still on disk for manual repro.
+  int first = failed.id;
+  if (_dispatcher && _dispatcher->first_failure(first) && first != failed.id)
+    rc = _dispatcher->wait_slot(first);
+  mutation_slot &slot = (first == failed.id) ? failed : _slots[first];
+  crash_input_size = materialize(slot, radamsa_buffer);
+  crash_origin = slot.origin;
+  if (_slots.size() > 1) {
+    std::cout << "\n[INFO] " << _slots.size()
+              << " mutations were in flight; the other one is kept in: "
+              << _slots[slot.id == 0 ? 1 : 0].path << std::endl;
+  }
+  if (rc == CURLE_OPERATION_TIMEDOUT) {
+    std::cerr << "Target timed out, killing child" << std::endl;
+    kill(this->_target_pid, SIGKILL);
+    return -2;
   }
+  return -1;
+}
+
+int8_t FileFuzzerBase::finish_replay(QueryDispatcher &queue,
+                                     mutation_slot &slot,
+                                     char *&radamsa_buffer) {
+  auto ret_code = queue.wait_slot(slot.id);
+  if (ret_code != CURLE_OK)
+    return slot_failed(slot, ret_code, radamsa_buffer);
+  return 0;
+}
+
+void FileFuzzerBase::reset_coverage() {
+  if (coverage)
+    coverage->reset();
+}
 
-  uint32_t seed = gen();
-  return seed;
+void FileFuzzerBase::collect_coverage(const char *data, size_t size,
+                                      corpus_buffer &corpus, const char *ext) {
+  if (!coverage || size == 0)
+    return;
+  int novelty = coverage->has_new_bits();
+  if (novelty == 0)
+    return;
+  char *seed = new char[size + 1];
+  std::memcpy(seed, data, size);
+  seed[size] = '\0';
+  corpus.push_back({size, seed});
+  fit_capacity(size);
+  coverage->save(data, size, ext);
+  std::cout << "\033[1;32m[+]\033[0m "
+            << (novelty == 2 ? "New edges" : "New hit counts")
+            << ", queued input " << coverage->queued() << " (edges: \033[1;36m"
+            << coverage->edges() << "\033[0m, corpus: " << corpus.size()
+            << ")" << std::endl;
 }
 
 void FileFuzzerBase::write_crash(char *crash_string, size_t crash_size,
-                                 std::string &crash_dir) {
+                                 std::string &crash_dir, const char *kind,
+                                 const nlohmann::json *replay_log) {
   std::filesystem::directory_entry _crash_dir(crash_dir);
 
   if (!_crash_dir.exists()) {
@@ -67,7 +392,8 @@ void FileFuzzerBase::write_crash(char *crash_string, size_t crash_size,
     // crash signals.
     static std::atomic<unsigned> _crash_counter{0};
     auto crash_path = _crash_dir.path()
-        / ("crash-" + std::to_string(static_cast<long>(time(nullptr)))
+        / (std::string(kind) + "-"
+           + std::to_string(static_cast<long>(time(nullptr)))
            + "-" + std::to_string(getpid())
            + "-" + std::to_string(_crash_counter++) + ".bin");
     std::string crash_file = crash_path.string();
@@ -78,6 +404,13 @@ void FileFuzzerBase::write_crash(char *crash_string, size_t crash_size,
                   << "\n";
       }
       std::fclose(crash_fp);
+      if (replay_log) {
+        std::ofstream log(crash_file + ".replay.json");
+        log << replay_log->dump(2) << "\n";
+        if (log)
+          std::cout << "Replay with: --replay " << crash_file << ".replay.json"
+                    << "\n";
+      }
     } else {
       FILE *tmp_crash = std::fopen("/tmp/crash.txt", "w");
       if (tmp_crash) {
@@ -116,52 +449,205 @@ void FileFuzzerBase::write_radamsa_mutation(char *&buffer,
   }
 }
 
-corpus_stat FileFuzzerBase::load_corpus(const std::filesystem::path &path) {
-  size_t size = std::filesystem::file_size(path.string());
+void FileFuzzerBase::publish_mutation(const mutation_slot &slot) {
+  // O_TMPFILE + linkat() can't replace an existing name, so the staging
+  // file is a dot-file next to the slot, renamed over it once complete.
+  int fd = ::open(slot.staging.c_str(),
+                  O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    std::cerr << "Could not create mutation file: " << slot.staging
+              << std::endl;
+    perror("open");
+    exit(1);
+  }
+  // The tail (e.g. a Parquet footer) is written from the seed itself.
+  struct iovec parts[2] = {{slot.buffer, slot.size},
+                           {const_cast<char *>(slot.tail.data),
+                            slot.tail.size}};
+  struct iovec *part = parts;
+  int count = slot.tail.size ? 2 : 1;
+  while (count > 0) {
+    ssize_t n = ::writev(fd, part, count);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0 || (n == 0 && part->iov_len > 0)) {
+      std::cout << "\nMutated data could not be written, please check if "
+                   "filepath exists\n"
+                << std::endl;
+      exit(1);
+    }
+    // drop what was written: whole parts, then the front of a partial one
+    size_t written = static_cast<size_t>(n);
+    while (count > 0 && written >= part->iov_len) {
+      written -= part->iov_len;
+      ++part;
+      --count;
+    }
+    if (count > 0) {
+      part->iov_base = static_cast<char *>(part->iov_base) + written;
+      part->iov_len -= written;
+    }
+  }
+  close(fd);
+  if (std::rename(slot.staging.c_str(), slot.path.c_str()) != 0) {
+    perror("rename");
+    exit(1);
+  }
+}
 
-  char *input = new char[size];
+namespace {
 
-  std::FILE *input_corp = std::fopen(path.string().c_str(), "r");
-  if (!input_corp) {
-    std::cerr << "Failed to open corpus file: " << path.string() << std::endl;
-    delete[] input;
-    exit(1);
+// Bump whenever load_corpus() changes what it makes of a metadata file, so
+// entries cached by older builds are not reused.
+constexpr const char *kCorpusCacheVersion = "iceberg-metadata-1";
+
+uint64_t fnv1a(const char *data, size_t size,
+               uint64_t hash = 0xcbf29ce484222325ULL) {
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 0x100000001b3ULL;
   }
-  size_t read_bytes = std::fread(input, 1, size, input_corp);
-  std::fclose(input_corp);
+  return hash;
+}
 
-  if (read_bytes != size) {
-    std::cerr << "Failed to read entire corpus file: " << path.string()
-              << std::endl;
-    delete[] input;
-    exit(1);
+// <cache_dir>/<hash>-<size>.json. The hash covers the file's content and
+// everything the rewrite depends on.
+std::string corpus_cache_path(const FileFuzzerBase::corpus_info &info,
+                              const char *data, size_t size) {
+  std::string settings = std::string(kCorpusCacheVersion) + '\0' +
+                         info.s3_bucket.value_or("") + '\0' +
+                         info.local_root;
+  uint64_t hash = fnv1a(settings.data(), settings.size());
+  hash = fnv1a(data, size, hash);
+  char name[64];
+  snprintf(name, sizeof(name), "%016llx-%zu.json",
+           static_cast<unsigned long long>(hash), size);
+  return (std::filesystem::path(info.cache_dir) / name).string();
+}
+
+// A cached entry: the rewritten, NUL-terminated metadata, or {0, nullptr}
+// for a file that was rejected (the cache file is then empty).
+bool read_cached(const std::string &path, corpus_stat &stat) {
+  std::FILE *fp = std::fopen(path.c_str(), "rb");
+  if (!fp)
+    return false;
+  std::error_code ec;
+  size_t size = std::filesystem::file_size(path, ec);
+  bool ok = !ec;
+  stat = {0, nullptr};
+  if (ok && size > 0) {
+    stat.corpus = new char[size + 1];
+    ok = std::fread(stat.corpus, 1, size, fp) == size;
+    stat.corpus[size] = '\0';
+    stat.size = size;
+    if (!ok) {
+      delete[] stat.corpus;
+      stat = {0, nullptr};
+    }
   }
+  std::fclose(fp);
+  return ok;
+}
 
-  /* For fuzzing Iceberg Metadata: modify necessary fields here
-  to avoid repeated parsing in hot paths during fuzzing */
+// Best effort: a failed write only costs the next launch a re-parse.
+// Written under a unique name and renamed, so concurrent workers (and
+// readers) never see a partial entry.
+void write_cached(const std::string &path, const char *data, size_t size) {
+  std::string tmp = path + "." + std::to_string(getpid()) + "." +
+                    std::to_string(std::hash<std::thread::id>{}(
+                        std::this_thread::get_id()));
+  std::FILE *fp = std::fopen(tmp.c_str(), "wb");
+  if (!fp)
+    return;
+  bool ok = std::fwrite(data, 1, size, fp) == size;
+  ok = (std::fclose(fp) == 0) && ok;
+  if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0)
+    std::remove(tmp.c_str());
+}
 
-  if (this->_corpus_info.format.compare("iceberg") == 0 &&
-      path.extension() == ".json") {
-    nlohmann::json metadata_json;
-    // *input is non-null terminated, so specify exact length to read in
-    // nlohmann::json::parse
-    metadata_json = nlohmann::json::parse(input, input + size, nullptr, false);
-
-    if (metadata_json.is_discarded() ||
-        !(metadata_json.contains("current-snapshot-id"))) {
-      std::cerr << "Parsing failed, moving to the next corpus" << "\n"
-                << std::endl;
-      delete[] input;
-      return (corpus_stat{0, nullptr});
+// Run `work(i)` for every i < count on up to `threads` threads; each claims
+// the next index not yet taken.
+template <typename Work>
+void parallel_for(size_t count, size_t threads, const Work &work) {
+  std::atomic<size_t> next{0};
+  auto run = [&]() {
+    for (size_t i; (i = next.fetch_add(1)) < count;) {
+      work(i);
+    }
+  };
+  std::vector<std::thread> pool;
+  for (size_t t = 1; t < std::min(threads, count); ++t) {
+    pool.emplace_back(run);
+  }
+  run();
+  for (auto &thread : pool) {
+    thread.join();
+  }
+}
+
+} // namespace
+
+std::vector<corpus_stat>
+FileFuzzerBase::load_corpus(const std::vector<std::filesystem::path> &paths,
+                            size_t threads) {
+  std::vector<corpus_stat> stats(paths.size());
+  // load_corpus(path) only reads _corpus_info, so threads can share it
+  parallel_for(paths.size(), threads,
+               [&](size_t i) { stats[i] = load_corpus(paths[i]); });
+  return stats;
+}
+
+std::vector<corpus_stat>
+FileFuzzerBase::prepare_metadata(const std::vector<corpus_stat> &entries,
+                                 size_t threads) {
+  std::vector<corpus_stat> stats(entries.size());
+  parallel_for(entries.size(), threads, [&](size_t i) {
+    stats[i] = prepare_metadata(entries[i].corpus, entries[i].size);
+  });
+  return stats;
+}
+
+corpus_stat FileFuzzerBase::prepare_metadata(const char *input, size_t size) {
+  std::string cache_path;
+  if (!this->_corpus_info.cache_dir.empty()) {
+    cache_path = corpus_cache_path(this->_corpus_info, input, size);
+    corpus_stat cached;
+    if (read_cached(cache_path, cached)) {
+      if (this->_corpus_info.compress)
+        deflate_seed(cached);
+      return cached;
     }
+  }
+
+  nlohmann::json metadata_json;
+  // *input is non-null terminated, so specify exact length to read in
+  // nlohmann::json::parse
+  metadata_json = nlohmann::json::parse(input, input + size, nullptr, false);
 
-    // Start modifying the JSON object. Two backends are supported:
-    //   --bucket file       → write file:// URLs anchored at the
-    //                         fuzzer's local mutation directory.
-    //   --bucket <name>     → write s3://<name>/... URLs (original
-    //                         behavior).
-    // The file:// path matters for in-tree CI runs that don't want a
-    // real or mocked S3 backend.
+  if (metadata_json.is_discarded() ||
+      !(metadata_json.contains("current-snapshot-id"))) {
+    std::cerr << "Parsing failed, moving to the next corpus" << "\n"
+              << std::endl;
+    if (!cache_path.empty())
+      write_cached(cache_path, "", 0); // rejected: skip it next time too
+    return (corpus_stat{0, nullptr});
+  }
+
+  if (metadata_json.contains("metadata-log")) {
+    metadata_json.erase("metadata-log");
+  }
+  if (metadata_json.contains("snapshot-log")) {
+    metadata_json.erase("snapshot-log");
+  }
+
+  // Start modifying the JSON object. Two backends are supported:
+  //   --bucket file       → write file:// URLs anchored at the
+  //                         fuzzer's local mutation directory.
+  //   --bucket <name>     → write s3://<name>/... URLs (original
+  //                         behavior).
+  // The file:// path matters for in-tree CI runs that don't want a
+  // real or mocked S3 backend.
+  if (this->_corpus_info.s3_bucket) {
     const bool local_mode = (*this->_corpus_info.s3_bucket == "file");
     const std::string location =
         local_mode ? ("file://" + this->_corpus_info.local_root)
@@ -173,35 +659,76 @@ corpus_stat FileFuzzerBase::load_corpus(const std::filesystem::path &path) {
             : ("s3://" + *this->_corpus_info.s3_bucket +
                "/metadata/manifest_list.avro");
     metadata_json["location"] = location;
-    if (metadata_json.contains("metadata-log")) {
-      metadata_json.erase("metadata-log");
-    }
-    if (metadata_json.contains("snapshot-log")) {
-      metadata_json.erase("snapshot-log");
-    }
     for (auto &snap : metadata_json["snapshots"]) {
       if (snap.is_object()) {
         snap["manifest-list"] = manifest_list_url;
       }
     }
+  }
+
+  std::string dumped_json =
+      metadata_json.dump(-1,    // no prettifying
+                         ' ',   // indent char (unused)
+                         false, // ensure_ascii false
+                         nlohmann::json::error_handler_t::replace);
+
+  char *updated_metadata = new char[dumped_json.size() + 1];
+  memcpy(updated_metadata, dumped_json.data(), dumped_json.size());
+  updated_metadata[dumped_json.size()] = '\0'; // Add null terminator
+  if (!cache_path.empty())
+    write_cached(cache_path, dumped_json.data(), dumped_json.size());
+  corpus_stat stat = {dumped_json.size(), updated_metadata};
+  if (this->_corpus_info.compress)
+    deflate_seed(stat);
+  return stat;
+}
+
+corpus_stat FileFuzzerBase::load_corpus(const std::filesystem::path &path) {
+  size_t size = std::filesystem::file_size(path.string());
+
+  char *input = new char[size];
+
+  std::FILE *input_corp = std::fopen(path.string().c_str(), "r");
+  if (!input_corp) {
+    std::cerr << "Failed to open corpus file: " << path.string() << std::endl;
+    delete[] input;
+    exit(1);
+  }
+  size_t read_bytes = std::fread(input, 1, size, input_corp);
+  std::fclose(input_corp);
+
+  if (read_bytes != size) {
+    std::cerr << "Failed to read entire corpus file: " << path.string()
+              << std::endl;
+    delete[] input;
+    exit(1);
+  }
+
+  /* For fuzzing Iceberg Metadata: modify necessary fields here
+  to avoid repeated parsing in hot paths during fuzzing */
 
-    std::string dumped_json =
-        metadata_json.dump(-1,    // no prettifying
-                           ' ',   // indent char (unused)
-                           false, // ensure_ascii false
-                           nlohmann::json::error_handler_t::replace);
+  if (this->_corpus_info.format.compare("iceberg") == 0 &&
+      path.extension() == ".json") {
+    corpus_stat stat = prepare_metadata(input, size);
+    delete[] input; // the entry is a rewritten copy
+    return stat;
+  }
 
-    char *updated_metadata = new char[dumped_json.size() + 1];
-    memcpy(updated_metadata, dumped_json.data(), dumped_json.size());
-    updated_metadata[dumped_json.size()] = '\0'; // Add null terminator
-    // The raw file bytes were owned by `input` (new[]); the rewritten
-    // copy lives in `updated_metadata`. Release `input` here, otherwise
-    // every iceberg metadata corpus entry leaks `size` bytes at startup.
+  // Parquet seeds are mutated between their magic and footer: drop the ones
+  // without a valid layout here rather than skipping them every iteration
+  parquet_layout layout;
+  if (this->_corpus_info.format == "parquet" &&
+      !parse_parquet_layout(input, size, layout)) {
+    std::cerr << "Not a valid Parquet file (magic or footer length), moving "
+                 "to the next corpus: "
+              << path.string() << std::endl;
     delete[] input;
-    return (corpus_stat{dumped_json.size(), updated_metadata});
+    return (corpus_stat{0, nullptr});
   }
 
   corpus_stat stat = {size, input};
+  if (this->_corpus_info.compress)
+    deflate_seed(stat);
   return stat;
 }
 
@@ -33,13 +33,19 @@ extern "C" {
 #include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <nlohmann/json.hpp>
 #include <optional>
-#include <random>
 #include <string>
 
 #include "HTTPHandler.h"
+#include "MutationBuffer.h"
+#include "MutatorPool.h"
+#include "Random.h"
+#include "SeedCache.h"
+#include <Session/Coverage.h>
 
 // Base class for file format fuzzers
 
@@ -48,51 +54,299 @@ namespace fuzzberg {
 struct corpus_stat {
   size_t size;
   char *corpus = nullptr;
+  bool owned = true; // new[]-allocated; false for views into a corpus pack
+  size_t stored = 0; // deflated bytes in `corpus`, 0 if stored inflated
 };
 
 using query_set = std::vector<std::string>;
 using corpus_buffer = std::vector<corpus_stat>;
 
+inline void replace_all(std::string &str, const std::string &from,
+                        const std::string &to) {
+  if (from.empty())
+    return;
+  size_t pos = 0;
+  while ((pos = str.find(from, pos)) != std::string::npos) {
+    str.replace(pos, from.size(), to);
+    pos += to.size();
+  }
+}
+
+// Mutation modes a format draws from (--parquet-modes, --csv-modes) and
+// their names.
+using mode_name = std::pair<const char *, unsigned>;
+
+// A comma-separated list of mode names to a mask of their bits; false on
+// an unknown name or an empty list.
+template <size_t N>
+bool parse_mode_list(const std::string &list, const mode_name (&names)[N],
+                     unsigned &modes) {
+  modes = 0;
+  size_t begin = 0;
+  while (begin <= list.size()) {
+    size_t end = list.find(',', begin);
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+    const std::string name = list.substr(begin, end - begin);
+    bool known = false;
+    for (const auto &[mode, bit] : names) {
+      if (name == mode) {
+        modes |= bit;
+        known = true;
+      }
+    }
+    if (!known) {
+      return false;
+    }
+    begin = end + 1;
+  }
+  return modes != 0;
+}
+
+// And back, for the replay log.
+template <size_t N>
+std::string mode_list_name(unsigned modes, const mode_name (&names)[N]) {
+  std::string list;
+  for (const auto &[mode, bit] : names) {
+    if (modes & bit) {
+      list += (list.empty() ? "" : ",") + std::string(mode);
+    }
+  }
+  return list;
+}
+
+// Where a mutation came from: with the master seed, enough to regenerate
+// it (--replay).
+struct mutation_origin {
+  uint64_t iteration = 0;
+  uint64_t step = 0;      // Iceberg sequence 2: metadata field (1-based)
+  int sequence = 0;       // Iceberg sequence (1-3), 0 for CSV / Parquet
+  size_t corpus_size = 0; // entries in the corpus the seed was drawn from
+  size_t seed_index = 0;  // Iceberg: metadata seed of the current round
+};
+
+// A file the mutation is published to, plus the queries that read it. Two
+// slots (A/B) alternate, so the next mutation is generated and published
+// while the target is still reading the previous one.
+struct mutation_slot {
+  int id = 0;
+  std::string path;
+  std::string staging; // written here first, then renamed over `path`
+  std::vector<std::string> queries; // queries rewritten to read `path`
+  char *buffer = nullptr;           // mutation bytes, kept for crash reports
+  size_t size = 0;
+  mutation_tail tail;     // the file ends with these after `buffer`
+  mutation_origin origin; // iteration that produced `buffer`
+};
+
 class FileFuzzerBase : public HTTPHandler {
 public:
   FileFuzzerBase() = default;
-  ~FileFuzzerBase() = default;
+  virtual ~FileFuzzerBase();
 
   // Extra metadata for corpus loading (required for Iceberg fuzzer)
   struct corpus_info {
     std::string format;
     std::optional<std::string> s3_bucket = std::nullopt;
-    // When set, iceberg load_corpus rewrites the metadata `location`
-    // and manifest-list pointers to point at this local directory
-    // using the `file://` scheme, so the target can drive a fuzzing
-    // round without an object-store backend.
+    // Without a bucket, Iceberg metadata keeps its locations (a corpus
+    // pack; the session points them at its table on load). With bucket
+    // "file", its `location` and manifest-list pointers are rewritten to
+    // this local directory using the `file://` scheme, so the target can
+    // drive a fuzzing round without an object-store backend.
     std::string local_root;
+    // When set, the Iceberg metadata rewrite is cached in this directory,
+    // keyed by the file's content and the settings above, so a later
+    // launch reads the result instead of parsing and re-dumping the JSON.
+    std::string cache_dir;
+    // Store entries deflated (--compress-corpus); read them through seed().
+    bool compress = false;
   } _corpus_info;
 
   size_t execs = 0;            // number of queries executed
   size_t crash_input_size = 0; // size of the input that caused crash
+  mutation_origin crash_origin; // and where it came from
+  // --replay: run only this iteration, then return 0 or the failure
+  const mutation_origin *replay = nullptr;
+  size_t max_inflight = 1;     // concurrent queries against the target
+  connection_options http_options; // protocol, keep-alive, Nagle, auth
+  CoverageMap *coverage = nullptr; // --coverage feedback, owned by main
+  uint64_t master_seed = 0;        // all iteration streams derive from it
+  size_t mutators = 0; // --mutators: processes generating ahead, 0 = inline
+  size_t batch = 1;    // --batch: mutations (files) per query round
+  size_t seed_cache_bytes = 0; // --compress-corpus: inflated seeds kept
+  // The DatabaseHandler's radamsa buffer (slot 0, crash reports), grown
+  // with mutation_capacity().
+  MutationBuffer *output = nullptr;
+  // Replace the (already reaped) target with a new one and return the new
+  // curl handle; set by the DatabaseHandler, used by batch bisection.
+  std::function<CURL *()> restart_target;
 
   corpus_stat load_corpus(const std::filesystem::path &input_corpus_path);
+  // Load `paths` on up to `threads` threads; results are in `paths` order.
+  std::vector<corpus_stat>
+  load_corpus(const std::vector<std::filesystem::path> &paths,
+              size_t threads);
+  // The load-time rewrite of one Iceberg metadata file: parsed and
+  // checked, its logs dropped and, with a bucket set, its locations
+  // pointed at the session's table. A new owned entry, or {0, nullptr}
+  // if the file is rejected.
+  corpus_stat prepare_metadata(const char *data, size_t size);
+  // The same for each of `entries` (a corpus pack's views), on up to
+  // `threads` threads.
+  std::vector<corpus_stat>
+  prepare_metadata(const std::vector<corpus_stat> &entries, size_t threads);
+  // `kind` prefixes the artifact name: crash-<ts>-<pid>-<n>.bin, hang-...
+  // `replay_log`, if given, is written next to it as <artifact>.replay.json
   void write_crash(char *crash_string, size_t crash_size,
-                   std::string &crash_dir);
+                   std::string &crash_dir, const char *kind = "crash",
+                   const nlohmann::json *replay_log = nullptr);
 
-  // Radamsa mutation buffer size
-  static constexpr size_t RADAMSA_BUFFER_SIZE =
-      1024 * 1024; // 1 MB buffer (we define this inside Database.h too as the
-                   // crash writing function needs it)
+  // Crash-and-continue: drop the connection to a dead target (before its
+  // curl handle is freed), then point the fuzzer at the restarted one.
+  // Everything else (RNG, iteration, slots, sequence position) is kept, so
+  // the next Fuzz() call resumes where the failing one stopped.
+  void detach();
+  void attach(pid_t target_pid);
 
-protected:
-  // Override this in child format-fuzzers
+  // Bytes one mutation may take (the `capacity` mutate() is given): the
+  // format's buffer_policy applied to the largest corpus entry so far.
+  size_t mutation_capacity() const { return _capacity; }
+
+  // Override this in child format-fuzzers. Returns -1 when a query failed
+  // (possible crash) and -2 when the target hung and was killed; the
+  // offending input is left in radamsa_buffer / crash_input_size.
   virtual int8_t Fuzz(std::vector<std::string> &queries, std::string &db_url,
                       corpus_buffer &input_corpus, char *&radamsa_buffer,
                       size_t &execs, CURL *curl) {
     return 0;
   }
 
+  // Formats whose mutations depend only on (master_seed, iteration) and the
+  // corpus override this: write the mutation of `iteration` into `out` (at
+  // most `capacity` bytes) and return its size. It runs in the fuzz loop or,
+  // with --mutators, in a mutator process, so it must not touch anything
+  // but the RNG. Given a `tail`, it may leave trailing seed bytes there
+  // instead of copying them into `out`; without one the file is all `out`.
+  virtual size_t mutate(uint64_t iteration, const corpus_buffer &corpus,
+                        char *out, size_t capacity,
+                        mutation_tail *tail = nullptr) {
+    return 0;
+  }
+
+  // The whole mutation file of `slot` (buffer, then tail) in `out`, which
+  // may be the slot's own buffer; returns its size.
+  static size_t materialize(const mutation_slot &slot, char *out);
+
+protected:
   pid_t _target_pid; 
+  size_t _iteration = 0; // mutation counter, survives target restarts
+  RandomStream _rng;     // stream of the current iteration
+
+  // The bytes of a corpus entry, inflated if it is stored compressed.
+  // Valid until the next call; NUL-terminated when the entry was.
+  const char *seed(const corpus_stat &stat) {
+    return _seeds.get(stat, seed_cache_bytes);
+  }
+
+  // How large this format's mutations may grow; see buffer_policy.
+  virtual buffer_policy mutation_policy() const { return {}; }
+
+  // Grow mutation_capacity(), and every mutation buffer with it, to fit
+  // the mutations of a `size`-byte seed / of all of `corpus`. Call before
+  // the mutator pool forks: its cells are sized once. A seed the format's
+  // maximum cannot hold is reported; its mutations are cut at the maximum.
+  void fit_capacity(size_t size);
+  void fit_capacity(const corpus_buffer &corpus);
 
+  // Start drawing from the stream of (master_seed, iteration, step).
+  void begin_iteration(uint64_t iteration, uint64_t step = 0) {
+    _rng = RandomStream::derive(master_seed, iteration, step);
+  }
+
+  // Rewrite an open file in place; Iceberg's metadata and manifest files
+  // (CSV and Parquet publish through slots).
   void write_radamsa_mutation(char *&buffer, FILE *&mutated_file_ptr,
                               size_t length);
-  uint32_t seed_generator();
+
+  // Atomically replace the slot's file with its buffer and tail (one
+  // gathered write): the target opening `slot.path` sees the previous
+  // mutation or this one, never a partial or truncated file.
+  void publish_mutation(const mutation_slot &slot);
+
+  // Lazily created on the DatabaseHandler's curl handle; owns the extra
+  // handles needed for --inflight > 1.
+  QueryDispatcher &dispatcher(CURL *curl, const std::string &db_url);
+
+  // Slot 0 is `primary_path` (the format fuzzer's file) and mutates into
+  // radamsa_buffer (`output`). A second slot is added next to it as
+  // `<stem>.1<ext>`, with its own buffer, and the queries are rewritten to
+  // read that file instead; unless coverage or replay needs one input at a
+  // time, or no query names the primary file.
+  void open_mutation_slots(const std::string &primary_path,
+                           const std::vector<std::string> &queries,
+                           char *radamsa_buffer);
+
+  // A query of `slot` failed: make the slot's mutation the crash candidate
+  // in radamsa_buffer. On timeout the target is killed and -2 is returned,
+  // otherwise -1.
+  int8_t slot_failed(mutation_slot &slot, CURLcode rc, char *&radamsa_buffer);
+
+  // --replay: the regenerated mutation's queries have been submitted; wait
+  // for them and report like a fuzzing round would.
+  int8_t finish_replay(QueryDispatcher &queue, mutation_slot &slot,
+                       char *&radamsa_buffer);
+
+  // --coverage: clear the edge map before an input's queries are sent, and
+  // classify it once they have all completed. An input that reached new
+  // coverage is copied (NUL-terminated, like the JSON corpus) into
+  // `corpus`, so later rounds mutate it too, and saved to the queue dir.
+  // Both are no-ops without --coverage.
+  void reset_coverage();
+  // `ext` names the queue file (id-NNNNNN<ext>), so --replay can tell
+  // which corpus an Iceberg entry belongs to.
+  void collect_coverage(const char *data, size_t size, corpus_buffer &corpus,
+                        const char *ext);
+
+  // Start the --mutators pool on `corpus`, unless the corpus can grow
+  // (coverage) or only one iteration runs (replay).
+  void start_mutators(const corpus_buffer &corpus);
+  // The mutation of `iteration` into `slot` (buffer, size and tail), from
+  // the pool if there is one, generated here otherwise. With --coverage the
+  // mutation is kept whole in the buffer, since it may become a seed.
+  void next_mutation(uint64_t iteration, const corpus_buffer &corpus,
+                     mutation_slot &slot);
+
+  // --batch K: each round publishes K mutations (iterations) as
+  // <stem>_000<ext> ... next to `primary_path`, and the queries, rewritten
+  // to read <stem>_*<ext>, scan them all at once. When a round fails the
+  // batch is bisected on restarted targets; the single culprit is then run
+  // alone against a fresh target and reported like an ordinary mutation.
+  int8_t fuzz_batches(const std::string &primary_path,
+                      const std::vector<std::string> &queries,
+                      std::string &db_url, corpus_buffer &corpus,
+                      char *&radamsa_buffer, size_t &execs, CURL *curl);
+
+  std::vector<mutation_slot> _slots;
+
+private:
+  // Publish only the batch files in `subset`, query them and wait.
+  CURLcode run_batch(const std::vector<size_t> &subset, std::string &db_url,
+                     size_t &execs, CURL *curl);
+  // One bisection step: restart the target if needed, run `subset`, and
+  // tell whether it failed the same way (`hang`) the whole batch did.
+  bool batch_fails(const std::vector<size_t> &subset, bool hang,
+                   std::string &db_url, size_t &execs, CURL *&curl,
+                   bool &alive);
+
+  std::vector<mutation_slot> _batch;
+  std::vector<MutationBuffer> _batch_buffers;
+
+  std::unique_ptr<MutatorPool> _pool;
+  SeedCache _seeds;
+  std::unique_ptr<QueryDispatcher> _dispatcher;
+  std::optional<MutationBuffer> _spare_buffer; // slot 1 mutation buffer
+  size_t _capacity = kMinMutationBytes;
+  size_t _largest = 0; // largest seed fit_capacity() has seen
 };
 } // namespace fuzzberg
\ No newline at end of file
@@ -21,66 +21,329 @@
 
 #include "HTTPHandler.h"
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
 namespace fuzzberg {
 
-CURLcode HTTPHandler::send_query(CURL *curl, const std::string &query,
-                                 const std::string &db_url,
-                                 const std::string &auth_token) {
-  curl_off_t post_size = query.length();
-  if (!auth_token.empty()) {
-    struct curl_slist *list = NULL;
+struct curl_slist *
+HTTPHandler::make_headers(const connection_options &options) {
+  struct curl_slist *list = NULL;
+  if (!options.auth_token.empty()) {
     std::string header_prefix = "F-Authorization: Bearer ";
-    std::string auth_header = header_prefix + auth_token;
+    std::string auth_header = header_prefix + options.auth_token;
     list = curl_slist_append(list, auth_header.c_str());
-    curl_easy_setopt(curl, CURLOPT_BUFFERSIZE, 102400L);
-    curl_easy_setopt(curl, CURLOPT_URL, db_url.c_str());
-    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1L);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, query.c_str());
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, post_size);
-    curl_easy_setopt(curl, CURLOPT_MAXREDIRS, 50L);
-    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, list);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 15L); // 15 second timeout
+  }
+  return list;
+}
 
-  } else {
-    curl_easy_setopt(curl, CURLOPT_BUFFERSIZE, 102400L);
-    curl_easy_setopt(curl, CURLOPT_URL, db_url.c_str());
-    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1L);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, query.c_str());
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, post_size);
-    curl_easy_setopt(curl, CURLOPT_MAXREDIRS, 50L);
-    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 15L); // 15 second timeout
+void HTTPHandler::prepare_handle(CURL *curl, const std::string &db_url,
+                                 const connection_options &options,
+                                 struct curl_slist *headers) {
+  long http_version = CURL_HTTP_VERSION_1_1;
+  switch (options.version) {
+  case connection_options::http_version::automatic:
+    // TLS targets may negotiate h2 via ALPN; 2TLS means HTTP/1.1 on plain
+    // http://, but spell that out instead of relying on it.
+    if (db_url.rfind("https://", 0) == 0)
+      http_version = CURL_HTTP_VERSION_2TLS;
+    break;
+  case connection_options::http_version::http1_1:
+    break;
+  case connection_options::http_version::h2c:
+    http_version = CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE;
+    break;
   }
+
+  curl_easy_setopt(curl, CURLOPT_BUFFERSIZE, 102400L);
+  curl_easy_setopt(curl, CURLOPT_URL, db_url.c_str());
+  curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1L);
+  curl_easy_setopt(curl, CURLOPT_MAXREDIRS, 50L);
+  curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, http_version);
+  curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+  curl_easy_setopt(curl, CURLOPT_TIMEOUT, options.timeout_sec);
+  curl_easy_setopt(curl, CURLOPT_TCP_NODELAY, options.tcp_nodelay ? 1L : 0L);
+  curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, options.keep_alive ? 1L : 0L);
+  curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, options.keep_alive ? 0L : 1L);
+  // the fuzzer only talks to its own target; skip signal-based DNS timeouts
+  // so curl never races our SIGINT/SIGALRM handling
+  curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+}
+
+CURLcode HTTPHandler::send_query(CURL *curl, const std::string &query,
+                                 const std::string &db_url,
+                                 const std::string &auth_token) {
+  // Blocking one-off path (setup and probes); the fuzz loops go through
+  // QueryDispatcher's prepared requests instead.
+  connection_options options;
+  options.auth_token = auth_token;
+  struct curl_slist *list = make_headers(options);
+  prepare_handle(curl, db_url, options, list);
+  curl_easy_setopt(curl, CURLOPT_POSTFIELDS, query.c_str());
+  curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE,
+                   static_cast<curl_off_t>(query.length()));
   // we free the curl handle during Database object cleanup (e.g. when fuzzing
   // is interrupted, or crash is detected)
-  return (curl_easy_perform(curl));
+  CURLcode ret = curl_easy_perform(curl);
+  curl_easy_setopt(curl, CURLOPT_HTTPHEADER, NULL);
+  curl_slist_free_all(list);
+  return ret;
 }
 
-CURLcode HTTPHandler::curlinit(const std::string &db_url) {
+namespace {
+size_t discard_response(char *, size_t size, size_t nmemb, void *) {
+  return size * nmemb;
+}
+
+// One readiness attempt on a fresh handle.
+CURLcode probe_target(const std::string &db_url,
+                      const readiness_options &readiness,
+                      const connection_options &options,
+                      struct curl_slist *headers) {
+  CURL *probe = curl_easy_init();
+  if (!probe) {
+    std::cout << "\nCurl init failed, exiting..\n" << std::endl;
+    exit(1);
+  }
+  curl_easy_setopt(probe, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(probe, CURLOPT_CONNECTTIMEOUT_MS, 1000L);
+  curl_easy_setopt(probe, CURLOPT_WRITEFUNCTION, discard_response);
+  if (!readiness.health_url.empty()) {
+    curl_easy_setopt(probe, CURLOPT_URL, readiness.health_url.c_str());
+    curl_easy_setopt(probe, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(probe, CURLOPT_TIMEOUT, options.timeout_sec);
+  } else if (!readiness.health_query.empty()) {
+    curl_easy_setopt(probe, CURLOPT_URL, db_url.c_str());
+    curl_easy_setopt(probe, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(probe, CURLOPT_POSTFIELDS,
+                     readiness.health_query.c_str());
+    curl_easy_setopt(probe, CURLOPT_TIMEOUT, options.timeout_sec);
+  } else {
+    curl_easy_setopt(probe, CURLOPT_URL, db_url.c_str());
+    curl_easy_setopt(probe, CURLOPT_CONNECT_ONLY, 1L);
+  }
+
+  CURLcode ret = curl_easy_perform(probe);
+  if (ret == CURLE_OK && (!readiness.health_url.empty() ||
+                          !readiness.health_query.empty())) {
+    // the listener is up, but the engine may still be initializing
+    long http_code = 0;
+    curl_easy_getinfo(probe, CURLINFO_RESPONSE_CODE, &http_code);
+    if (http_code < 200 || http_code >= 300)
+      ret = CURLE_HTTP_RETURNED_ERROR;
+  }
+  curl_easy_cleanup(probe);
+  return ret;
+}
+} // namespace
+
+CURLcode HTTPHandler::wait_until_ready(const std::string &db_url,
+                                       pid_t target_pid,
+                                       const readiness_options &readiness,
+                                       const connection_options &options) {
   std::cout << "\nChecking connection to server...\n\n" << std::endl;
-  sleep(8);
-  CURL *curl_init = curl_easy_init();
-  if (curl_init) {
-    CURLcode ret;
-    curl_easy_setopt(curl_init, CURLOPT_URL, db_url.c_str());
-    curl_easy_setopt(curl_init, CURLOPT_CONNECT_ONLY, 1L);
-    ret = curl_easy_perform(curl_init);
+  struct curl_slist *headers = make_headers(options);
+
+  using clock = std::chrono::steady_clock;
+  const auto start = clock::now();
+  const auto deadline = start + std::chrono::milliseconds(readiness.deadline_ms);
+  long delay_ms = readiness.initial_delay_ms;
+  size_t attempts = 0;
+  CURLcode ret = CURLE_COULDNT_CONNECT;
+
+  while (true) {
+    // A target that dies during startup will never answer; don't wait out
+    // the whole deadline for it.
+    int status = 0;
+    if (target_pid > 0 && waitpid(target_pid, &status, WNOHANG) == target_pid) {
+      std::cout << "\nDB server exited during startup, exiting..\n"
+                << std::endl;
+      ret = CURLE_COULDNT_CONNECT;
+      break;
+    }
+
+    ++attempts;
+    ret = probe_target(db_url, readiness, options, headers);
     if (ret == CURLE_OK) {
-      std::cout << "\nConnected..." << std::endl;
+      auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+          clock::now() - start);
+      std::cout << "\nConnected after " << elapsed.count() << " ms ("
+                << attempts << " probes)..." << std::endl;
       // create a database if target expects one for query executions (e.g.
-      // in URL: http:://localhost:<port>/?database=fuzzberg)
-      /* send_query(curl_init, "create database if not exists fuzzberg",
-                  db_url, "");*/
-      curl_easy_cleanup(curl_init);
-    } else {
-      std::cout << "\nDB server not starting, exiting..\n" << std::endl;
+      // in URL: http:://localhost:<port>/?database=fuzzberg): use
+      // --health-query "create database if not exists fuzzberg"
+      break;
     }
-    return ret;
-  } else {
-    std::cout << "\nCurl init failed, exiting..\n" << std::endl;
+
+    if (clock::now() + std::chrono::milliseconds(delay_ms) > deadline) {
+      std::cout << "\nDB server not ready after " << readiness.deadline_ms
+                << " ms (" << curl_easy_strerror(ret) << "), exiting..\n"
+                << std::endl;
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    delay_ms = std::min(delay_ms * 2, readiness.max_delay_ms);
+  }
+
+  curl_slist_free_all(headers);
+  return ret;
+}
+
+namespace {
+size_t collect_response(char *data, size_t size, size_t nmemb, void *out) {
+  static_cast<std::string *>(out)->append(data, size * nmemb);
+  return size * nmemb;
+}
+} // namespace
+
+QueryDispatcher::QueryDispatcher(CURL *primary, const std::string &db_url,
+                                 size_t max_inflight,
+                                 const connection_options &options)
+    : _db_url(db_url) {
+  _multi = curl_multi_init();
+  if (!_multi) {
+    std::cout << "\nCurl multi init failed, exiting..\n" << std::endl;
     exit(1);
   }
+  if (options.version == connection_options::http_version::h2c) {
+    curl_multi_setopt(_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+  }
+  // One header list for the whole session, freed in the destructor.
+  _headers = make_headers(options);
+
+  size_t handles = max_inflight > 0 ? max_inflight : 1;
+  for (size_t i = 0; i < handles; ++i) {
+    auto request = std::make_unique<prepared_request>();
+    request->handle = (i == 0 && primary) ? primary : curl_easy_init();
+    request->owned = (request->handle != primary);
+    if (!request->handle) {
+      std::cout << "\nCurl init failed, exiting..\n" << std::endl;
+      exit(1);
+    }
+    prepare_handle(request->handle, _db_url, options, _headers);
+    curl_easy_setopt(request->handle, CURLOPT_WRITEFUNCTION, collect_response);
+    curl_easy_setopt(request->handle, CURLOPT_WRITEDATA, &request->response);
+    curl_easy_setopt(request->handle, CURLOPT_PRIVATE, request.get());
+    _idle.push_back(request.get());
+    _requests.push_back(std::move(request));
+  }
+}
+
+QueryDispatcher::~QueryDispatcher() {
+  // Transfers still running here belong to a round that is being abandoned
+  // (crash or timeout on another slot); just detach them.
+  for (auto &request : _requests) {
+    if (request->running)
+      curl_multi_remove_handle(_multi, request->handle);
+    if (request->owned) {
+      curl_easy_cleanup(request->handle);
+    } else {
+      // the primary handle outlives us: drop pointers into our state
+      curl_easy_setopt(request->handle, CURLOPT_HTTPHEADER, NULL);
+      curl_easy_setopt(request->handle, CURLOPT_WRITEFUNCTION, NULL);
+      curl_easy_setopt(request->handle, CURLOPT_WRITEDATA, stdout);
+      curl_easy_setopt(request->handle, CURLOPT_POSTFIELDS, NULL);
+      curl_easy_setopt(request->handle, CURLOPT_PRIVATE, NULL);
+    }
+  }
+  curl_multi_cleanup(_multi);
+  curl_slist_free_all(_headers);
+}
+
+void QueryDispatcher::submit(const std::string &query, int slot) {
+  _queue.push_back({query, slot});
+  _outstanding[slot]++;
+  start_pending();
+}
+
+void QueryDispatcher::start_pending() {
+  while (!_idle.empty() && !_queue.empty()) {
+    prepared_request *request = _idle.back();
+    _idle.pop_back();
+
+    request->query = std::move(_queue.front().query);
+    request->slot = _queue.front().slot;
+    request->response.clear();
+    _queue.pop_front();
+
+    // the only per-query options: the body
+    curl_easy_setopt(request->handle, CURLOPT_POSTFIELDS,
+                     request->query.c_str());
+    curl_easy_setopt(request->handle, CURLOPT_POSTFIELDSIZE_LARGE,
+                     static_cast<curl_off_t>(request->query.size()));
+    curl_multi_add_handle(_multi, request->handle);
+    request->running = true;
+    _running++;
+  }
+}
+
+void QueryDispatcher::step(bool block) {
+  int running = 0;
+  curl_multi_perform(_multi, &running);
+
+  bool completed = false;
+  int queued = 0;
+  CURLMsg *msg = nullptr;
+  while ((msg = curl_multi_info_read(_multi, &queued))) {
+    if (msg->msg != CURLMSG_DONE)
+      continue;
+    CURL *handle = msg->easy_handle;
+    CURLcode rc = msg->data.result;
+    curl_multi_remove_handle(_multi, handle);
+
+    prepared_request *done = nullptr;
+    curl_easy_getinfo(handle, CURLINFO_PRIVATE, &done);
+    std::cout << "\nQuery : " << done->query << "\n\n";
+    if (rc == CURLE_OK)
+      std::cout << done->response << std::endl;
+    else
+      std::cout << "Error: " << curl_easy_strerror(rc) << std::endl;
+
+    if (rc != CURLE_OK && _status.find(done->slot) == _status.end()) {
+      _status[done->slot] = rc;
+      _failure_order.push_back(done->slot);
+    }
+    _outstanding[done->slot]--;
+    done->running = false;
+    _running--;
+    _idle.push_back(done);
+    completed = true;
+  }
+
+  start_pending();
+  if (block && !completed && _running > 0)
+    curl_multi_poll(_multi, nullptr, 0, 100, nullptr);
+}
+CURLcode QueryDispatcher::wait_slot(int slot) {
+  while (_outstanding[slot] > 0)
+    step();
+  CURLcode rc = CURLE_OK;
+  auto status = _status.find(slot);
+  if (status != _status.end()) {
+    rc = status->second;
+    _status.erase(status);
+    _failure_order.erase(
+        std::find(_failure_order.begin(), _failure_order.end(), slot));
+  }
+  return rc;
+}
+
+bool QueryDispatcher::first_failure(int &slot) const {
+  if (_failure_order.empty())
+    return false;
+  slot = _failure_order.front();
+  return true;
+}
+
+CURLcode QueryDispatcher::wait_all() {
+  CURLcode first = CURLE_OK;
+  for (auto &[slot, outstanding] : _outstanding) {
+    CURLcode rc = wait_slot(slot);
+    if (first == CURLE_OK)
+      first = rc;
+  }
+  return first;
 }
 
 } // namespace fuzzberg
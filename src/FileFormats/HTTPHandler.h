@@ -25,20 +25,128 @@
 #include <wait.h>
 
 #include <cstring>
+#include <deque>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace fuzzberg {
+
+// Connection settings for a fuzzing session. They are applied once per curl
+// handle; only the request body changes from one query to the next.
+struct connection_options {
+  enum class http_version {
+    automatic, // h2 over TLS for https://, HTTP/1.1 otherwise
+    http1_1,
+    h2c, // cleartext HTTP/2 with prior knowledge (one multiplexed connection)
+  };
+  http_version version = http_version::automatic;
+  bool keep_alive = true;  // reuse connections between queries
+  bool tcp_nodelay = true; // disable Nagle's algorithm
+  long timeout_sec = 15;   // per-query timeout
+  std::string auth_token;  // sent as "F-Authorization: Bearer <token>"
+};
+
+// How to decide that a freshly (re)started target accepts queries. By
+// default a TCP connect to the target URL is enough.
+struct readiness_options {
+  std::string health_query;   // POSTed to the target URL; needs a 2xx reply
+  std::string health_url;     // GET this URL instead; needs a 2xx reply
+  long deadline_ms = 60000;   // overall startup budget
+  long initial_delay_ms = 25; // first backoff step, doubled per attempt
+  long max_delay_ms = 1000;   // backoff cap
+};
+
 class HTTPHandler {
 public:
   HTTPHandler() = default;
   ~HTTPHandler() = default;
 
-  CURLcode curlinit(const std::string &db_url);
+  // Probe the target with exponential backoff until it is ready. Fails
+  // early if `target_pid` exits (it is reaped) or the deadline passes.
+  CURLcode wait_until_ready(const std::string &db_url, pid_t target_pid,
+                            const readiness_options &readiness,
+                            const connection_options &options = {});
   CURLcode send_query(CURL *curl_handle, const std::string &query,
                       const std::string &db_url,
                       const std::string &auth_token = "");
+
+protected:
+  // Header list for `options`; the caller owns it (curl_slist_free_all).
+  static struct curl_slist *make_headers(const connection_options &options);
+
+  // Configure everything except the request body on `curl`. Shared by the
+  // blocking and the async (QueryDispatcher) paths.
+  static void prepare_handle(CURL *curl, const std::string &db_url,
+                             const connection_options &options,
+                             struct curl_slist *headers);
+};
+
+// Pipelined query dispatch on the curl multi interface. Keeps up to
+// `max_inflight` queries running against the target at once, each on its
+// own easy handle (and therefore its own keep-alive connection, or stream
+// with h2c). Queries are tagged with a slot id so a fuzzer can wait for
+// everything that reads one mutation file before overwriting it, while
+// other slots keep running.
+//
+// Each handle is a prepared request: URL, headers, protocol, socket and
+// timeout options are set once here, and a query only swaps the body.
+class QueryDispatcher : public HTTPHandler {
+public:
+  // `primary` (the DatabaseHandler's handle) is reused as the first easy
+  // handle and is not cleaned up by the dispatcher.
+  QueryDispatcher(CURL *primary, const std::string &db_url,
+                  size_t max_inflight, const connection_options &options = {});
+  ~QueryDispatcher();
+
+  void submit(const std::string &query, int slot);
+
+  // Drive transfers until every query submitted for `slot` has completed.
+  // Returns the first failure among them, CURLE_OK if all succeeded.
+  CURLcode wait_slot(int slot);
+  // Same, for every outstanding query of every slot.
+  CURLcode wait_all();
+  // Start and advance transfers without waiting, so queries just submitted
+  // reach the target while the caller works on the next mutation.
+  void progress() { step(false); }
+  // The slot whose queries failed first among those not yet reaped by
+  // wait_slot(), if any. A target that died on one slot's query refuses
+  // the other slot's afterwards, so that one is the crash candidate.
+  bool first_failure(int &slot) const;
+
+  size_t max_inflight() const { return _requests.size(); }
+
+private:
+  struct pending_query {
+    std::string query;
+    int slot;
+  };
+  struct prepared_request {
+    CURL *handle = nullptr;
+    bool owned = false;   // created (and freed) by the dispatcher
+    bool running = false; // attached to the multi handle
+    std::string query;    // request body; must outlive the transfer
+    std::string response;
+    int slot = 0;
+  };
+
+  CURLM *_multi = nullptr;
+  std::string _db_url;
+  struct curl_slist *_headers = nullptr;
+
+  std::vector<std::unique_ptr<prepared_request>> _requests;
+  std::vector<prepared_request *> _idle;
+  std::deque<pending_query> _queue;
+  size_t _running = 0;
+  std::map<int, size_t> _outstanding; // per slot: queued + running
+  std::map<int, CURLcode> _status;    // per slot: first failure
+  std::vector<int> _failure_order;    // slots in `_status`, oldest first
+
+  void start_pending();
+  void step(bool block = true); // `block`: poll if nothing completed
 };
 } // namespace fuzzberg
@@ -0,0 +1,102 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+
+#include "MutationBuffer.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+namespace fuzzberg {
+
+namespace {
+
+size_t page_round(size_t n) {
+  static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return (n + page - 1) / page * page;
+}
+
+} // namespace
+
+size_t buffer_policy::capacity_for(size_t largest) const {
+  // largest * growth, saturating, for seeds anywhere near SIZE_MAX
+  size_t want = largest > (maximum - slack) / growth
+                    ? maximum
+                    : largest * growth + slack;
+  return std::clamp(want, minimum, maximum);
+}
+
+MutationBuffer::MutationBuffer(size_t capacity) {
+  // PROT_NONE reserves addresses only: no memory is charged until grow()
+  // makes a range writable.
+  void *mem = mmap(nullptr, kMaxMutationBytes, PROT_NONE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (mem == MAP_FAILED) {
+    perror("mmap");
+    exit(1);
+  }
+  _data = static_cast<char *>(mem);
+  grow(capacity);
+}
+
+MutationBuffer::~MutationBuffer() { release(); }
+
+MutationBuffer::MutationBuffer(MutationBuffer &&other) noexcept
+    : _data(other._data), _capacity(other._capacity) {
+  other._data = nullptr;
+  other._capacity = 0;
+}
+
+void MutationBuffer::grow(size_t capacity) {
+  if (capacity <= _capacity) {
+    return;
+  }
+  if (capacity > kMaxMutationBytes) {
+    std::cerr << "Mutation buffer of " << capacity << " bytes requested; at "
+              << "most " << kMaxMutationBytes << " are reserved" << std::endl;
+    exit(1);
+  }
+  // At least double, so a corpus growing one seed at a time does not
+  // mprotect() on every new entry.
+  const size_t target = page_round(
+      std::min(std::max(capacity, 2 * _capacity), kMaxMutationBytes));
+  if (mprotect(_data + _capacity, target - _capacity,
+               PROT_READ | PROT_WRITE) != 0) {
+    perror("mprotect");
+    exit(1);
+  }
+  _capacity = target;
+}
+
+void MutationBuffer::release() {
+  if (_data) {
+    munmap(_data, kMaxMutationBytes);
+  }
+  _data = nullptr;
+  _capacity = 0;
+}
+
+} // namespace fuzzberg
@@ -0,0 +1,83 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+
+#pragma once
+
+#include <cstddef>
+
+// Mutation buffers. Mutations used to go into fixed 1 MB buffers, so a
+// larger seed was truncated to its first megabyte of output, or skipped
+// altogether when its Parquet footer did not fit. A MutationBuffer
+// reserves address space for the largest mutation any format may produce
+// (kMaxMutationBytes) up front and commits only the front of it; growing
+// commits more in place. Its address never changes, so slots, the crash
+// path and the DatabaseHandler keep plain pointers into it, and committed
+// pages the mutations never reach cost no memory. Fresh pages read as
+// zero, and nothing is zeroed between mutations: every user writes the
+// bytes it reports.
+
+namespace fuzzberg {
+
+constexpr size_t kMinMutationBytes = size_t{1} << 20; // the old fixed size
+constexpr size_t kMaxMutationBytes = size_t{1} << 30;
+
+// How large a format's mutations may grow, given its largest seed.
+struct buffer_policy {
+  size_t minimum = kMinMutationBytes;
+  size_t growth = 2; // times the seed, for what radamsa inserts
+  size_t slack = size_t{64} << 10; // plus this much, for tiny seeds
+  size_t maximum = kMaxMutationBytes;
+
+  // Capacity for mutations of a seed of `largest` bytes, within
+  // [minimum, maximum].
+  size_t capacity_for(size_t largest) const;
+};
+
+class MutationBuffer {
+public:
+  // Reserve kMaxMutationBytes and commit `capacity` of them; exits if the
+  // address space or the memory is not available.
+  explicit MutationBuffer(size_t capacity = 0);
+  ~MutationBuffer();
+
+  MutationBuffer(MutationBuffer &&other) noexcept;
+  MutationBuffer(const MutationBuffer &) = delete;
+  MutationBuffer &operator=(const MutationBuffer &) = delete;
+  MutationBuffer &operator=(MutationBuffer &&) = delete;
+
+  char *data() const { return _data; }
+  // Bytes that may be written at data().
+  size_t capacity() const { return _capacity; }
+
+  // Commit at least `capacity` bytes (never shrinks). data() stays put;
+  // exits past kMaxMutationBytes or if the memory cannot be committed.
+  void grow(size_t capacity);
+
+  // Unmap the buffer; data() is null afterwards.
+  void release();
+
+private:
+  char *_data = nullptr;
+  size_t _capacity = 0;
+};
+
+} // namespace fuzzberg
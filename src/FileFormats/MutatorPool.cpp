@@ -0,0 +1,179 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#include "MutatorPool.h"
+
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+namespace fuzzberg {
+
+namespace {
+
+// Spin briefly, then yield, then sleep: a ring is rarely empty (or full)
+// for long, but a stalled side must not burn a core.
+void backoff(unsigned &round) {
+  if (round < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("yield");
+#else
+    sched_yield();
+#endif
+  } else if (round < 128) {
+    sched_yield();
+  } else {
+    struct timespec nap = {0, 50 * 1000}; // 50us
+    nanosleep(&nap, nullptr);
+  }
+  ++round;
+}
+
+size_t round_up(size_t n, size_t to) { return (n + to - 1) / to * to; }
+
+} // namespace
+
+MutatorPool::MutatorPool(size_t processes, size_t depth, size_t capacity,
+                         uint64_t first, const mutate_fn &mutate)
+    : _processes(processes), _depth(depth), _capacity(capacity),
+      _first(first), _next(first) {
+  _cell_stride = round_up(sizeof(cell_header) + capacity, 4096);
+  _ring_stride = round_up(sizeof(ring_header), 4096) + depth * _cell_stride;
+  _shared_size = processes * _ring_stride;
+  // MAP_NORESERVE: cells are touched only as large as the mutations are
+  void *mem = mmap(nullptr, _shared_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (mem == MAP_FAILED) {
+    perror("mmap");
+    exit(1);
+  }
+  _shared = static_cast<char *>(mem);
+  for (size_t k = 0; k < processes; ++k) {
+    new (ring(k)) ring_header();
+  }
+
+  const pid_t parent = getpid();
+  for (size_t k = 0; k < processes; ++k) {
+    pid_t pid = fork();
+    if (pid < 0) {
+      perror("fork failed");
+      exit(1);
+    }
+    if (pid == 0) {
+      // Die with the fuzzer, and leave Ctrl+C to it.
+      prctl(PR_SET_PDEATHSIG, SIGKILL);
+      if (getppid() != parent)
+        _exit(0);
+      signal(SIGINT, SIG_IGN);
+      // Don't keep the fuzzer's connections to the target alive.
+      close_range(3, ~0U, 0);
+      run_mutator(k, mutate);
+    }
+    _pids.push_back(pid);
+  }
+  std::cout << "\033[1;32m[INFO] Started " << processes
+            << " mutator processes\033[0m" << std::endl;
+}
+
+MutatorPool::~MutatorPool() {
+  for (pid_t pid : _pids)
+    kill(pid, SIGKILL);
+  for (pid_t pid : _pids)
+    waitpid(pid, nullptr, 0);
+  if (_shared)
+    munmap(_shared, _shared_size);
+}
+
+MutatorPool::ring_header *MutatorPool::ring(size_t k) const {
+  return reinterpret_cast<ring_header *>(_shared + k * _ring_stride);
+}
+
+MutatorPool::cell_header *MutatorPool::cell(size_t k, uint64_t index) const {
+  return reinterpret_cast<cell_header *>(
+      _shared + k * _ring_stride + round_up(sizeof(ring_header), 4096) +
+      (index % _depth) * _cell_stride);
+}
+
+void MutatorPool::run_mutator(size_t k, const mutate_fn &mutate) {
+  ring_header *r = ring(k);
+  for (uint64_t index = 0;; ++index) {
+    // wait for a free cell
+    unsigned round = 0;
+    while (index - r->consumed.load(std::memory_order_acquire) >= _depth)
+      backoff(round);
+    cell_header *c = cell(k, index);
+    c->iteration = _first + k + index * _processes;
+    c->tail = {};
+    c->size = mutate(c->iteration, reinterpret_cast<char *>(c + 1), _capacity,
+                     &c->tail);
+    r->produced.store(index + 1, std::memory_order_release);
+  }
+}
+
+size_t MutatorPool::take(uint64_t iteration, char *out, mutation_tail &tail) {
+  if (iteration < _next) {
+    std::cerr << "Mutator pool: iteration " << iteration
+              << " was already handed out (next: " << _next << ")"
+              << std::endl;
+    exit(1);
+  }
+  // Iterations the loop skipped (a round that ended before mutating) are
+  // released unread.
+  size_t size = 0;
+  for (; _next <= iteration; ++_next) {
+    const size_t k = (_next - _first) % _processes;
+    const uint64_t index = (_next - _first) / _processes;
+    ring_header *r = ring(k);
+
+    unsigned round = 0;
+    while (r->produced.load(std::memory_order_acquire) <= index) {
+      backoff(round);
+      // now and then, make sure the producer is still there
+      if (round % 2048 == 0 && waitpid(_pids[k], nullptr, WNOHANG) != 0) {
+        std::cerr << "Mutator process " << _pids[k] << " died, exiting"
+                  << std::endl;
+        exit(1);
+      }
+    }
+    if (_next == iteration) {
+      cell_header *c = cell(k, index);
+      size = c->size;
+      std::memcpy(out, c + 1, size);
+      tail = c->tail;
+    }
+    r->consumed.store(index + 1, std::memory_order_release);
+  }
+  return size;
+}
+
+} // namespace fuzzberg
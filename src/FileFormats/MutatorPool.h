@@ -0,0 +1,106 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Mutator processes (--mutators N). Radamsa is single-threaded and, for
+// large Parquet seeds, costs more than the target's queries; running it in
+// the fuzzing thread puts it on every exec's critical path. The pool forks
+// N mutators (each with its own copy of the radamsa runtime and corpus)
+// that generate mutations ahead of the fuzz loop into shared memory.
+//
+// Mutator k owns iterations first+k, first+k+N, ... and publishes them, in
+// order, into its own single-producer/single-consumer ring. The fuzz loop
+// consumes iterations strictly in order, round-robin over the rings, so
+// the stream of mutations is exactly what the inline path would produce
+// for the same master seed: --replay still regenerates them.
+
+namespace fuzzberg {
+
+// Bytes a mutation ends with that are a verbatim copy of part of a corpus
+// entry (the Parquet footer). They are written to the mutation file
+// straight from the seed instead of being copied behind the mutated bytes.
+// Mutators fork after the corpus is loaded and --coverage (which grows
+// it) disables them, so a tail pointer is valid in the fuzzer too.
+struct mutation_tail {
+  const char *data = nullptr;
+  size_t size = 0;
+};
+
+class MutatorPool {
+public:
+  // Generates one mutation of `iteration` into `out` (at most `capacity`
+  // bytes, plus `tail`) and returns its size. Runs in the mutator processes.
+  using mutate_fn = std::function<size_t(uint64_t iteration, char *out,
+                                         size_t capacity,
+                                         mutation_tail *tail)>;
+
+  // Fork `processes` mutators with `depth` ring cells of `capacity` bytes
+  // each, producing from iteration `first` on.
+  MutatorPool(size_t processes, size_t depth, size_t capacity, uint64_t first,
+              const mutate_fn &mutate);
+  ~MutatorPool(); // kills and reaps the mutators
+
+  MutatorPool(const MutatorPool &) = delete;
+  MutatorPool &operator=(const MutatorPool &) = delete;
+
+  // Copy the mutation of `iteration` into `out`, waiting for it if its
+  // mutator is behind. Iterations are taken in increasing order; earlier
+  // ones not taken are dropped. Exits if a mutator died.
+  size_t take(uint64_t iteration, char *out, mutation_tail &tail);
+
+private:
+  struct alignas(64) ring_header {
+    std::atomic<uint64_t> produced; // cells published so far
+    char pad[64 - sizeof(std::atomic<uint64_t>)];
+    std::atomic<uint64_t> consumed; // cells released by the fuzz loop
+  };
+  struct cell_header {
+    uint64_t iteration;
+    uint64_t size;
+    mutation_tail tail;
+  };
+
+  ring_header *ring(size_t k) const;
+  cell_header *cell(size_t k, uint64_t index) const;
+  [[noreturn]] void run_mutator(size_t k, const mutate_fn &mutate);
+
+  size_t _processes;
+  size_t _depth;
+  size_t _capacity;
+  size_t _cell_stride;
+  size_t _ring_stride;
+  uint64_t _first;
+  uint64_t _next; // next iteration take() will hand out
+  char *_shared = nullptr;
+  size_t _shared_size = 0;
+  std::vector<pid_t> _pids;
+};
+
+} // namespace fuzzberg
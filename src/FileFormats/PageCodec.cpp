@@ -0,0 +1,260 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#include "PageCodec.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace fuzzberg {
+
+namespace {
+
+constexpr int64_t kUncompressed = 0;
+constexpr int64_t kSnappy = 1;
+constexpr int64_t kGzip = 2;
+
+// Snappy (https://github.com/google/snappy/blob/main/format_description.txt):
+// a varint of the uncompressed length, then literals and back-references.
+
+bool snappy_decompress(const char *data, size_t size, size_t expected,
+                       std::string &out) {
+  const uint8_t *p = reinterpret_cast<const uint8_t *>(data);
+  const uint8_t *end = p + size;
+  uint64_t length = 0;
+  for (int shift = 0;; shift += 7) {
+    if (p == end || shift > 28) {
+      return false;
+    }
+    length |= static_cast<uint64_t>(*p & 0x7f) << shift;
+    if (!(*p++ & 0x80)) {
+      break;
+    }
+  }
+  if (length != expected) {
+    return false;
+  }
+  out.clear();
+  out.reserve(length);
+  while (p < end) {
+    const uint8_t tag = *p++;
+    size_t len, offset;
+    switch (tag & 3) {
+    case 0: // literal
+      len = tag >> 2;
+      if (len >= 60) {
+        const size_t bytes = len - 59;
+        if (static_cast<size_t>(end - p) < bytes) {
+          return false;
+        }
+        len = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+          len |= static_cast<size_t>(p[i]) << (8 * i);
+        }
+        p += bytes;
+      }
+      ++len;
+      if (static_cast<size_t>(end - p) < len || out.size() + len > length) {
+        return false;
+      }
+      out.append(reinterpret_cast<const char *>(p), len);
+      p += len;
+      continue;
+    case 1: // copy, 11-bit offset
+      if (p == end) {
+        return false;
+      }
+      len = 4 + ((tag >> 2) & 7);
+      offset = (static_cast<size_t>(tag >> 5) << 8) | *p++;
+      break;
+    case 2: // copy, 16-bit offset
+      if (end - p < 2) {
+        return false;
+      }
+      len = (tag >> 2) + 1;
+      offset = p[0] | p[1] << 8;
+      p += 2;
+      break;
+    default: // copy, 32-bit offset
+      if (end - p < 4) {
+        return false;
+      }
+      len = (tag >> 2) + 1;
+      offset = p[0] | p[1] << 8 | p[2] << 16 | static_cast<size_t>(p[3]) << 24;
+      p += 4;
+    }
+    if (offset == 0 || offset > out.size() || out.size() + len > length) {
+      return false;
+    }
+    // byte by byte: the copy may overlap what it appends
+    for (size_t from = out.size() - offset; len--; ++from) {
+      out.push_back(out[from]);
+    }
+  }
+  return out.size() == length;
+}
+
+void snappy_literal(const char *data, size_t len, std::string &out) {
+  while (len) {
+    const size_t n = std::min<size_t>(len, 1 << 16);
+    if (n <= 60) {
+      out.push_back(static_cast<char>((n - 1) << 2));
+    } else {
+      out.push_back(static_cast<char>(61 << 2)); // two length bytes
+      out.push_back(static_cast<char>((n - 1) & 0xff));
+      out.push_back(static_cast<char>((n - 1) >> 8));
+    }
+    out.append(data, n);
+    data += n;
+    len -= n;
+  }
+}
+
+void snappy_copy(size_t offset, size_t len, std::string &out) {
+  while (len) {
+    const size_t n = std::min<size_t>(len, 64);
+    out.push_back(static_cast<char>(((n - 1) << 2) | 2));
+    out.push_back(static_cast<char>(offset & 0xff));
+    out.push_back(static_cast<char>(offset >> 8));
+    len -= n;
+  }
+}
+
+// Greedy single-probe matcher: enough to give the target's decompressor
+// back-references to follow, without aiming for snappy's ratio.
+void snappy_compress(const char *data, size_t size, std::string &out) {
+  out.clear();
+  for (uint64_t n = size; ; n >>= 7) {
+    out.push_back(static_cast<char>((n & 0x7f) | (n >= 0x80 ? 0x80 : 0)));
+    if (n < 0x80) {
+      break;
+    }
+  }
+  constexpr int kHashBits = 14;
+  std::vector<uint32_t> table(1 << kHashBits, UINT32_MAX);
+  auto load32 = [data](size_t at) {
+    uint32_t v;
+    memcpy(&v, data + at, 4);
+    return v;
+  };
+  size_t literal = 0, pos = 0;
+  while (pos + 4 <= size) {
+    const uint32_t word = load32(pos);
+    const uint32_t hash = (word * 0x1e35a7bdu) >> (32 - kHashBits);
+    const uint32_t candidate = table[hash];
+    table[hash] = static_cast<uint32_t>(pos);
+    if (candidate == UINT32_MAX || pos - candidate > 0xffff ||
+        load32(candidate) != word) {
+      ++pos;
+      continue;
+    }
+    size_t len = 4;
+    while (pos + len < size && data[candidate + len] == data[pos + len]) {
+      ++len;
+    }
+    snappy_literal(data + literal, pos - literal, out);
+    snappy_copy(pos - candidate, len, out);
+    pos += len;
+    literal = pos;
+  }
+  snappy_literal(data + literal, size - literal, out);
+}
+
+// GZIP pages are gzip members (RFC 1952), not bare deflate streams.
+constexpr int kGzipWindowBits = 16 + MAX_WBITS;
+
+bool gzip_decompress(const char *data, size_t size, size_t expected,
+                     std::string &out) {
+  z_stream stream{};
+  if (inflateInit2(&stream, kGzipWindowBits) != Z_OK) {
+    return false;
+  }
+  out.resize(expected);
+  stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+  stream.avail_in = static_cast<uInt>(size);
+  stream.next_out = reinterpret_cast<Bytef *>(out.data());
+  stream.avail_out = static_cast<uInt>(expected);
+  const int rc = inflate(&stream, Z_FINISH);
+  inflateEnd(&stream);
+  return rc == Z_STREAM_END && stream.total_out == expected;
+}
+
+bool gzip_compress(const char *data, size_t size, std::string &out) {
+  z_stream stream{};
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                   kGzipWindowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+  out.resize(deflateBound(&stream, size));
+  stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+  stream.avail_in = static_cast<uInt>(size);
+  stream.next_out = reinterpret_cast<Bytef *>(out.data());
+  stream.avail_out = static_cast<uInt>(out.size());
+  const int rc = deflate(&stream, Z_FINISH);
+  out.resize(stream.total_out);
+  deflateEnd(&stream);
+  return rc == Z_STREAM_END;
+}
+
+} // namespace
+
+bool page_codec_supported(int64_t codec) {
+  return codec == kUncompressed || codec == kSnappy || codec == kGzip;
+}
+
+bool page_decompress(int64_t codec, const char *data, size_t size,
+                     size_t uncompressed_size, std::string &out) {
+  switch (codec) {
+  case kUncompressed:
+    if (size != uncompressed_size) {
+      return false;
+    }
+    out.assign(data, size);
+    return true;
+  case kSnappy:
+    return snappy_decompress(data, size, uncompressed_size, out);
+  case kGzip:
+    return gzip_decompress(data, size, uncompressed_size, out);
+  default:
+    return false;
+  }
+}
+
+bool page_compress(int64_t codec, const char *data, size_t size,
+                   std::string &out) {
+  switch (codec) {
+  case kUncompressed:
+    out.assign(data, size);
+    return true;
+  case kSnappy:
+    snappy_compress(data, size, out);
+    return true;
+  case kGzip:
+    return gzip_compress(data, size, out);
+  default:
+    return false;
+  }
+}
+
+} // namespace fuzzberg
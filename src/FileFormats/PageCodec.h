@@ -0,0 +1,50 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Parquet page compression, so page mutations can work on the plaintext
+// (values and levels) rather than on a compressed stream the reader would
+// reject before decoding anything. SNAPPY is implemented here, GZIP goes
+// through zlib; other codecs (ZSTD, LZ4, BROTLI, LZO) are not supported and
+// their pages are mutated as they are stored.
+
+namespace fuzzberg {
+
+// Whether pages compressed with `codec` (Parquet CompressionCodec) can be
+// decompressed and recompressed here. UNCOMPRESSED counts.
+bool page_codec_supported(int64_t codec);
+
+// Decompress `size` bytes at `data` into `out`, which must come out at
+// exactly `uncompressed_size` bytes; false on a corrupt stream, a size
+// mismatch or an unsupported codec.
+bool page_decompress(int64_t codec, const char *data, size_t size,
+                     size_t uncompressed_size, std::string &out);
+
+// Compress `size` bytes at `data` with `codec`, replacing `out`.
+bool page_compress(int64_t codec, const char *data, size_t size,
+                   std::string &out);
+
+} // namespace fuzzberg
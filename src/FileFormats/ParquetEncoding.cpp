@@ -0,0 +1,371 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#include "ParquetEncoding.h"
+
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+#include "Thrift.h"
+
+namespace fuzzberg {
+
+namespace {
+
+using namespace parquet;
+
+int bit_width(uint64_t max) {
+  int width = 0;
+  for (; max; max >>= 1) {
+    ++width;
+  }
+  return width;
+}
+
+// RLE / bit-packed hybrid: a varint header per run, its low bit telling a
+// bit-packed run (header >> 1 groups of 8 values, `width` bytes a group)
+// from a repeated one (header >> 1 copies of one value in (width + 7) / 8
+// bytes).
+struct rle_run {
+  size_t begin;      // header
+  size_t values;     // after the header
+  size_t end;
+  bool packed;
+  uint64_t count;    // groups (packed) or repetitions
+};
+
+std::vector<rle_run> rle_runs(const std::string &s, size_t begin, size_t end,
+                              int width) {
+  std::vector<rle_run> runs;
+  // bounded: a page of tiny runs would otherwise make this list huge
+  for (size_t pos = begin; pos < end && runs.size() < 4096;) {
+    rle_run run{pos, 0, 0, false, 0};
+    uint64_t header;
+    if (!read_varint(s, pos, header) || pos > end) {
+      break;
+    }
+    run.values = pos;
+    run.packed = header & 1;
+    run.count = header >> 1;
+    const uint64_t bytes =
+        run.packed ? run.count * width : (width + 7) / 8;
+    if (run.count > end || bytes > end - pos) {
+      break;
+    }
+    run.end = pos + bytes;
+    runs.push_back(run);
+    pos = run.end;
+  }
+  return runs;
+}
+
+// Edit one run of the hybrid data in s[begin, end), whose values are
+// `width` bits and should stay below `limit`. `delta` is the change in size
+// (to fix a length prefix); false if no run parses.
+bool mutate_rle(std::string &s, size_t begin, size_t end, int width,
+                uint64_t limit, RandomStream &rng, int64_t &delta) {
+  const auto runs = rle_runs(s, begin, end, width);
+  if (runs.empty()) {
+    return false;
+  }
+  const rle_run &run = runs[rng.below(runs.size())];
+  const size_t before = s.size();
+  switch (rng.below(4)) {
+  case 0: { // run length: none, one more, far past the page's values
+    const uint64_t counts[] = {0, 1, run.count + 1, run.count * 2 + 1,
+                               uint64_t{1} << 20, 0x7fffffff};
+    std::string header;
+    put_varint(counts[rng.below(std::size(counts))] << 1 | run.packed,
+               header);
+    s.replace(run.begin, run.values - run.begin, header);
+    break;
+  }
+  case 1: // a value past the maximum level / the dictionary
+    if (!run.packed && run.end > run.values) {
+      const uint64_t values[] = {limit, limit + 1,
+                                 (uint64_t{1} << std::min(width, 63)) - 1,
+                                 ~uint64_t{0}};
+      const uint64_t value = values[rng.below(std::size(values))];
+      for (size_t i = run.values; i < run.end; ++i) {
+        s[i] = static_cast<char>(value >> (8 * (i - run.values)));
+      }
+    } else if (run.end > run.values) {
+      s[run.values + rng.below(run.end - run.values)] = '\xff';
+    }
+    break;
+  case 2: { // the other run kind over the same bytes
+    std::string header;
+    const uint64_t count = run.packed ? run.count * 8 : (run.count + 7) / 8;
+    put_varint(count << 1 | !run.packed, header);
+    s.replace(run.begin, run.values - run.begin, header);
+    break;
+  }
+  default: // drop the run, or repeat it
+    if (rng.below(2)) {
+      s.erase(run.begin, run.end - run.begin);
+    } else {
+      s.insert(run.end, s.substr(run.begin, run.end - run.begin));
+    }
+  }
+  delta = static_cast<int64_t>(s.size()) - static_cast<int64_t>(before);
+  return true;
+}
+
+// DELTA_BINARY_PACKED at `begin`: block size, miniblocks per block, total
+// values and first value, then per block a minimum delta and one bit
+// width per miniblock.
+bool mutate_delta(std::string &s, size_t begin, RandomStream &rng) {
+  size_t pos = begin;
+  uint64_t block, miniblocks, total, first;
+  if (!read_varint(s, pos, block) || !read_varint(s, pos, miniblocks) ||
+      !read_varint(s, pos, total) || !read_varint(s, pos, first)) {
+    return false;
+  }
+  const size_t header_end = pos;
+  uint64_t min_delta;
+  const bool has_block = total > 1 && read_varint(s, pos, min_delta);
+  const size_t widths = pos;
+
+  switch (rng.below(has_block ? 5 : 4)) {
+  case 0: { // not a multiple of 128, or huge
+    const uint64_t sizes[] = {0, 8, 127, 129, block + 128, uint64_t{1} << 24};
+    block = sizes[rng.below(std::size(sizes))];
+    break;
+  }
+  case 1: { // miniblocks that do not divide the block into multiples of 32
+    const uint64_t counts[] = {0, 3, block + 1, miniblocks * 2,
+                               uint64_t{1} << 20};
+    miniblocks = counts[rng.below(std::size(counts))];
+    break;
+  }
+  case 2: {
+    const uint64_t counts[] = {0, total + 1, total * 2 + 1, uint64_t{1} << 31,
+                               uint64_t{1} << 36};
+    total = counts[rng.below(std::size(counts))];
+    break;
+  }
+  case 3: {
+    const int64_t values[] = {std::numeric_limits<int64_t>::min(),
+                              std::numeric_limits<int64_t>::max(), 0, -1};
+    first = zigzag(values[rng.below(std::size(values))]);
+    break;
+  }
+  default: { // a miniblock wider than the type, or the first block's deltas
+    if (widths < s.size() && miniblocks > 0 && rng.below(2)) {
+      const uint8_t bad[] = {0, 33, 64, 65, 255};
+      const size_t at =
+          widths + rng.below(std::min<uint64_t>(miniblocks, s.size() - widths));
+      s[at] = static_cast<char>(bad[rng.below(std::size(bad))]);
+      return true;
+    }
+    const int64_t deltas[] = {std::numeric_limits<int64_t>::min(),
+                              std::numeric_limits<int64_t>::max(), 1, -1};
+    std::string value;
+    put_varint(zigzag(deltas[rng.below(std::size(deltas))]), value);
+    s.replace(header_end, widths - header_end, value);
+    return true;
+  }
+  }
+  std::string header;
+  put_varint(block, header);
+  put_varint(miniblocks, header);
+  put_varint(total, header);
+  put_varint(first, header);
+  s.replace(begin, header_end - begin, header);
+  return true;
+}
+
+// PLAIN values from `begin`: one BYTE_ARRAY length prefix off, or one
+// fixed-width value set to a boundary.
+bool mutate_plain(std::string &s, size_t begin, const parquet_page &page,
+                  RandomStream &rng) {
+  if (begin >= s.size()) {
+    return false;
+  }
+  if (page.physical_type == kByteArray) {
+    std::vector<size_t> prefixes;
+    for (size_t pos = begin; pos + 4 <= s.size() && prefixes.size() < 4096;) {
+      prefixes.push_back(pos);
+      const uint32_t len = read_u32(s, pos);
+      if (len > s.size() - pos - 4) {
+        break;
+      }
+      pos += 4 + len;
+    }
+    if (prefixes.empty()) {
+      return false;
+    }
+    const size_t at = prefixes[rng.below(prefixes.size())];
+    const uint32_t lengths[] = {0, read_u32(s, at) + 1,
+                                static_cast<uint32_t>(s.size() - at - 3),
+                                0x7fffffff, 0xffffffff};
+    write_u32(s, at, lengths[rng.below(std::size(lengths))]);
+    return true;
+  }
+
+  size_t width = 0;
+  switch (page.physical_type) {
+  case kInt32:
+  case kFloat:
+    width = 4;
+    break;
+  case kInt64:
+  case kDouble:
+    width = 8;
+    break;
+  case kInt96:
+    width = 12;
+    break;
+  case kFixedLenByteArray:
+    width = page.type_length > 0 ? static_cast<size_t>(page.type_length) : 0;
+    break;
+  default: // BOOLEAN is bit-packed, nothing to align to
+    return false;
+  }
+  if (width == 0 || s.size() - begin < width) {
+    return false;
+  }
+  const size_t at = begin + width * rng.below((s.size() - begin) / width);
+  uint8_t value[16] = {};
+  switch (rng.below(4)) {
+  case 0: // the largest value (also a NaN for floats and doubles)
+    memset(value, 0xff, sizeof(value));
+    value[std::min<size_t>(width, 16) - 1] = 0x7f;
+    break;
+  case 1: // the smallest (-0.0 for floats and doubles)
+    value[std::min<size_t>(width, 16) - 1] = 0x80;
+    break;
+  case 2: // infinity for floats and doubles, a large power of two else
+    if (page.physical_type == kFloat) {
+      const float inf = std::numeric_limits<float>::infinity();
+      memcpy(value, &inf, 4);
+    } else {
+      const double inf = std::numeric_limits<double>::infinity();
+      memcpy(value, &inf, 8);
+    }
+    break;
+  default: // 0, or -1
+    if (rng.below(2)) {
+      memset(value, 0xff, sizeof(value));
+    }
+  }
+  for (size_t i = 0; i < width; ++i) {
+    s[at + i] = static_cast<char>(value[i < 16 ? i : 15]);
+  }
+  return true;
+}
+
+// A length-prefixed (u32) RLE section at `at`: levels in a DATA_PAGE,
+// booleans in an RLE-encoded page. The prefix follows the edit.
+bool mutate_prefixed_rle(std::string &s, size_t at, int width, uint64_t limit,
+                         RandomStream &rng) {
+  if (at + 4 > s.size()) {
+    return false;
+  }
+  const uint32_t len = read_u32(s, at);
+  if (len > s.size() - at - 4) {
+    return false;
+  }
+  int64_t delta = 0;
+  if (!mutate_rle(s, at + 4, at + 4 + len, width, limit, rng, delta)) {
+    return false;
+  }
+  write_u32(s, at, static_cast<uint32_t>(len + delta));
+  return true;
+}
+
+} // namespace
+
+bool mutate_page_values(std::string &plain, const parquet_page &page,
+                        RandomStream &rng) {
+  // A DATA_PAGE starts with its repetition, then definition levels, each
+  // behind a 4-byte length when the column has them.
+  struct section {
+    size_t at;
+    int width;
+    uint64_t limit;
+  };
+  std::vector<section> levels;
+  size_t values = 0;
+  if (page.type == kPageTypeData) {
+    for (uint8_t max : {page.max_repetition, page.max_definition}) {
+      if (max == 0) {
+        continue;
+      }
+      if (values + 4 > plain.size()) {
+        return false;
+      }
+      levels.push_back({values, bit_width(max), uint64_t{max} + 1});
+      values += 4 + read_u32(plain, values);
+    }
+    if (values > plain.size()) {
+      return false;
+    }
+  } else if (page.type != kPageTypeDataV2 &&
+             page.type != kPageTypeDictionary) {
+    return false;
+  }
+
+  // one of the level sections, or the values
+  const size_t pick = rng.below(levels.size() + 1);
+  if (pick < levels.size()) {
+    const section &level = levels[pick];
+    return mutate_prefixed_rle(plain, level.at, level.width, level.limit, rng);
+  }
+  // dictionary pages hold their entries PLAIN, whatever the header says
+  const int64_t encoding =
+      page.type == kPageTypeDictionary ? kPlain : page.encoding;
+  switch (encoding) {
+  case kPlain:
+    return mutate_plain(plain, values, page, rng);
+  case kPlainDictionary:
+  case kRleDictionary: {
+    // one byte of index bit width, then the indices
+    if (values >= plain.size()) {
+      return false;
+    }
+    const int width = static_cast<uint8_t>(plain[values]);
+    if (rng.below(3) == 0 || width > 32) {
+      const uint8_t widths[] = {0, 1, 31, 32, 33, 255};
+      const uint8_t next = rng.below(2) ? widths[rng.below(std::size(widths))]
+                                        : static_cast<uint8_t>(width + 1);
+      plain[values] = static_cast<char>(next);
+      return true;
+    }
+    int64_t delta = 0;
+    return mutate_rle(plain, values + 1, plain.size(), width,
+                      page.dictionary_size, rng, delta);
+  }
+  case kRle: // booleans
+    return page.physical_type == kBoolean &&
+           mutate_prefixed_rle(plain, values, 1, 2, rng);
+  case kDeltaBinaryPacked:
+  case kDeltaLengthByteArray: // the lengths come first
+  case kDeltaByteArray:       // and here the prefix lengths
+    return mutate_delta(plain, values, rng);
+  default:
+    return false;
+  }
+}
+
+} // namespace fuzzberg
@@ -0,0 +1,51 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#pragma once
+
+#include <string>
+
+#include "ParquetMetadata.h"
+#include "Random.h"
+
+// Encoding-aware mutations of a Parquet page's plaintext (its payload,
+// decompressed). Byte-level edits rarely make a well-formed but hostile run
+// header, so these change the logical structures the reader's decode loops
+// are driven by
+// (https://parquet.apache.org/docs/file-format/data-pages/encodings/):
+// - RLE / bit-packed hybrid runs of levels, booleans and dictionary
+//   indices: run lengths, run kinds, bit widths, values past the maximum
+//   level or the dictionary size
+// - DELTA_BINARY_PACKED headers (also the lengths of DELTA_LENGTH_ and
+//   DELTA_BYTE_ARRAY): block and miniblock counts, total and first value,
+//   a block's minimum delta and miniblock bit widths
+// - PLAIN values: BYTE_ARRAY length prefixes, boundary numbers, NaNs
+
+namespace fuzzberg {
+
+// Apply one such edit to `plain`, the plaintext of `page` (the levels and
+// then the values for a DATA_PAGE, only the values for a DATA_PAGE_V2),
+// drawing from `rng`. False, with `plain` unchanged, if the page's
+// encoding is not one of the above or its data does not parse.
+bool mutate_page_values(std::string &plain, const parquet_page &page,
+                        RandomStream &rng);
+
+} // namespace fuzzberg
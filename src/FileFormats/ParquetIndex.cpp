@@ -0,0 +1,52 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#include "ParquetIndex.h"
+
+#include <cstring>
+
+namespace fuzzberg {
+
+bool parse_parquet_layout(const char *data, size_t size,
+                          parquet_layout &layout) {
+  // 4 * 2 magic bytes + 4 bytes of metadata size field, and one page byte
+  if (data == nullptr || size < 13 ||
+      std::memcmp(data, kParquetMagic, 4) != 0 ||
+      std::memcmp(data + size - 4, kParquetMagic, 4) != 0) {
+    return false;
+  }
+  // Read 4 bytes (little endian) from footer length to get file metadata size
+  const unsigned char *length =
+      reinterpret_cast<const unsigned char *>(data + size - 8);
+  uint32_t footer_size = length[0] | length[1] << 8 | length[2] << 16 |
+                         static_cast<uint32_t>(length[3]) << 24;
+  // the metadata must be non-empty and leave room for a page byte
+  if (footer_size == 0 || footer_size > size - 13) {
+    return false;
+  }
+  layout.pages_offset = 4;
+  layout.footer_offset = size - 8 - footer_size;
+  layout.pages_size = layout.footer_offset - layout.pages_offset;
+  layout.footer_size = footer_size;
+  return true;
+}
+
+} // namespace fuzzberg
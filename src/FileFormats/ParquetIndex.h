@@ -0,0 +1,52 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Layout of a Parquet file, as the Parquet fuzzer sees it:
+//
+//   "PAR1" | column chunks (pages) | FileMetaData | u32 length | "PAR1"
+//
+// (https://github.com/apache/parquet-format#file-format). Seeds are
+// indexed once, at load time, so the fuzz loop never re-derives (or
+// re-validates) it per iteration.
+
+namespace fuzzberg {
+
+constexpr char kParquetMagic[4] = {'P', 'A', 'R', '1'};
+
+struct parquet_layout {
+  size_t pages_offset = 4;  // first column chunk, right after the magic
+  size_t pages_size = 0;    // up to the FileMetaData
+  size_t footer_offset = 0; // FileMetaData (Thrift compact)
+  uint32_t footer_size = 0; // FileMetaData bytes, from the length field
+};
+
+// Fill `layout` for the `size` bytes at `data`; false unless both magics
+// are there, the footer length fits the file and at least one byte of page
+// data precedes the footer.
+bool parse_parquet_layout(const char *data, size_t size,
+                          parquet_layout &layout);
+
+} // namespace fuzzberg
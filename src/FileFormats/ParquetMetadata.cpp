@@ -0,0 +1,623 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#include "ParquetMetadata.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+#include <zlib.h>
+
+namespace fuzzberg {
+namespace {
+
+using namespace parquet;
+
+// Which Parquet structure a decoded struct is, from where it sits in the
+// FileMetaData tree.
+enum class meta_kind {
+  other,
+  file,
+  schema,
+  row_group,
+  chunk,
+  column,
+  statistics,
+};
+
+// What a mutation target means, and so which values are worth trying.
+enum class target_role {
+  count,  // rows, values, nulls, children
+  size,   // byte sizes and lengths
+  offset, // file positions of pages and row groups
+  enumeration,
+  integer, // anything else numeric
+  stat,    // statistics min / max bytes
+  list,
+  structure, // a struct whose fields can be removed
+};
+
+struct target {
+  target_role role;
+  thrift_value *value;
+  thrift_value *owner = nullptr; // struct holding `value`
+  int64_t range = 0;             // enumeration: one past the largest value
+};
+
+meta_kind child_kind(meta_kind parent, int16_t id) {
+  switch (parent) {
+  case meta_kind::file:
+    if (id == kMetaSchema)
+      return meta_kind::schema;
+    if (id == kMetaRowGroups)
+      return meta_kind::row_group;
+    break;
+  case meta_kind::row_group:
+    if (id == kRowGroupColumns)
+      return meta_kind::chunk;
+    break;
+  case meta_kind::chunk:
+    if (id == kChunkMetaData)
+      return meta_kind::column;
+    break;
+  case meta_kind::column:
+    if (id == kColumnStatistics)
+      return meta_kind::statistics;
+    break;
+  default:
+    break;
+  }
+  return meta_kind::other;
+}
+
+target_role int_role(meta_kind kind, int16_t id, int64_t &range) {
+  switch (kind) {
+  case meta_kind::file:
+    if (id == kMetaNumRows)
+      return target_role::count;
+    break;
+  case meta_kind::schema:
+    switch (id) {
+    case kSchemaType:
+      range = kTypeCount;
+      return target_role::enumeration;
+    case kSchemaRepetition:
+      range = kRepetitionCount;
+      return target_role::enumeration;
+    case kSchemaConvertedType:
+      range = kConvertedTypeCount;
+      return target_role::enumeration;
+    case kSchemaTypeLength:
+      return target_role::size;
+    case kSchemaNumChildren:
+      return target_role::count;
+    }
+    break;
+  case meta_kind::row_group:
+    switch (id) {
+    case kRowGroupNumRows:
+      return target_role::count;
+    case kRowGroupTotalByteSize:
+    case kRowGroupTotalCompressedSize:
+      return target_role::size;
+    case kRowGroupFileOffset:
+      return target_role::offset;
+    }
+    break;
+  case meta_kind::chunk:
+    if (id == kChunkFileOffset)
+      return target_role::offset;
+    break;
+  case meta_kind::column:
+    switch (id) {
+    case kColumnType:
+      range = kTypeCount;
+      return target_role::enumeration;
+    case kColumnCodec:
+      range = kCodecCount;
+      return target_role::enumeration;
+    case kColumnNumValues:
+      return target_role::count;
+    case kColumnUncompressedSize:
+    case kColumnCompressedSize:
+      return target_role::size;
+    case kColumnDataPageOffset:
+    case kColumnIndexPageOffset:
+    case kColumnDictionaryPageOffset:
+      return target_role::offset;
+    }
+    break;
+  case meta_kind::statistics:
+    if (id == kStatsNullCount || id == kStatsDistinctCount)
+      return target_role::count;
+    break;
+  default:
+    break;
+  }
+  return target_role::integer;
+}
+
+void collect(thrift_value &value, meta_kind kind,
+             std::vector<target> &targets) {
+  if (!value.fields.empty()) {
+    targets.push_back({target_role::structure, &value});
+  }
+  for (auto &[id, field] : value.fields) {
+    if (field.is_int()) {
+      target t{target_role::integer, &field, &value};
+      t.role = int_role(kind, id, t.range);
+      targets.push_back(t);
+    } else if (field.type == thrift_type::binary &&
+               kind == meta_kind::statistics) {
+      targets.push_back({target_role::stat, &field, &value});
+    } else if (field.type == thrift_type::structure) {
+      collect(field, child_kind(kind, id), targets);
+    } else if (field.type == thrift_type::list ||
+               field.type == thrift_type::set) {
+      target t{target_role::list, &field, &value};
+      if (kind == meta_kind::column && id == kColumnEncodings) {
+        t.range = kEncodingCount;
+      }
+      targets.push_back(t);
+      const meta_kind elem = child_kind(kind, id);
+      for (auto &item : field.items) {
+        if (item.type == thrift_type::structure) {
+          collect(item, elem, targets);
+        } else if (item.is_int() && t.range) {
+          targets.push_back(
+              {target_role::enumeration, &item, &value, t.range});
+        }
+      }
+    }
+  }
+}
+
+// Keep `v` representable in the field's wire type, as a writer would.
+int64_t clamp_to(thrift_type type, int64_t v) {
+  switch (type) {
+  case thrift_type::i8:
+    return static_cast<int8_t>(v);
+  case thrift_type::i16:
+    return static_cast<int16_t>(v);
+  case thrift_type::i32:
+    return static_cast<int32_t>(v);
+  default:
+    return v;
+  }
+}
+
+int64_t boundary_value(RandomStream &rng) {
+  static constexpr int64_t kBoundaries[] = {
+      0,
+      -1,
+      1,
+      0x7f,
+      0x80,
+      0xff,
+      0x7fff,
+      0x8000,
+      0xffff,
+      std::numeric_limits<int32_t>::max(),
+      std::numeric_limits<int32_t>::min(),
+      0xffffffffLL,
+      std::numeric_limits<int64_t>::max(),
+      std::numeric_limits<int64_t>::min(),
+  };
+  return kBoundaries[rng.below(std::size(kBoundaries))];
+}
+
+// Two's-complement wrap instead of signed overflow.
+int64_t wrap_add(int64_t v, int64_t delta) {
+  return static_cast<int64_t>(static_cast<uint64_t>(v) +
+                              static_cast<uint64_t>(delta));
+}
+
+void mutate_int(const target &t, RandomStream &rng, size_t file_size) {
+  int64_t v = t.value->i;
+  switch (rng.below(4)) {
+  case 0:
+    v = boundary_value(rng);
+    break;
+  case 1: // off by a little
+    v = wrap_add(v, static_cast<int64_t>(rng.below(33)) - 16);
+    break;
+  default: // something the role makes plausible
+    switch (t.role) {
+    case target_role::enumeration:
+      // neighbours, the first value past the range, and beyond
+      v = static_cast<int64_t>(rng.below(t.range + 4)) - 1;
+      break;
+    case target_role::offset:
+      // into the footer, past the end, or anywhere in the file
+      switch (rng.below(3)) {
+      case 0:
+        v = static_cast<int64_t>(file_size) - 8 -
+            static_cast<int64_t>(rng.below(64));
+        break;
+      case 1:
+        v = static_cast<int64_t>(file_size + rng.below(4096));
+        break;
+      default:
+        v = static_cast<int64_t>(rng.below(file_size + 1));
+      }
+      break;
+    case target_role::size:
+      v = rng.below(2) ? wrap_add(wrap_add(v, v), 1) : v / 2;
+      break;
+    case target_role::count:
+      v = rng.below(2) ? wrap_add(v, 1) : static_cast<int64_t>(rng.below(4096));
+      break;
+    default:
+      v ^= int64_t{1} << rng.below(63);
+    }
+  }
+  t.value->i = clamp_to(t.value->type, v);
+}
+
+void mutate_stat(const target &t, RandomStream &rng) {
+  std::string &bin = t.value->bin;
+  switch (rng.below(4)) {
+  case 0:
+    bin.resize(bin.empty() ? 0 : rng.below(bin.size()));
+    break;
+  case 1: // wider than the column type says
+    bin.append(1 + rng.below(16), static_cast<char>(rng.next()));
+    break;
+  case 2:
+    if (!bin.empty()) {
+      bin[rng.below(bin.size())] ^= static_cast<char>(1 + rng.below(255));
+    }
+    break;
+  default: { // min above max
+    thrift_value &stats = *t.owner;
+    auto *max = stats.field(kStatsMaxValue);
+    auto *min = stats.field(kStatsMinValue);
+    if (!max || !min) {
+      max = stats.field(kStatsMax);
+      min = stats.field(kStatsMin);
+    }
+    if (max && min && max->type == min->type) {
+      std::swap(max->bin, min->bin);
+    }
+  }
+  }
+}
+
+void mutate_list(const target &t, RandomStream &rng) {
+  auto &items = t.value->items;
+  switch (rng.below(t.range ? 4 : 3)) {
+  case 0:
+    if (!items.empty()) {
+      items.erase(items.begin() + rng.below(items.size()));
+    }
+    break;
+  case 1: // bounded, so a wide schema cannot snowball across edits
+    if (!items.empty() && items.size() < 4096) {
+      const size_t at = rng.below(items.size());
+      items.insert(items.begin() + at, thrift_value(items[at]));
+    }
+    break;
+  case 2:
+    if (items.size() > 1) {
+      std::swap(items[rng.below(items.size())],
+                items[rng.below(items.size())]);
+    }
+    break;
+  default: { // an encoding the column chunk does not use, or none at all
+    thrift_value encoding;
+    encoding.type = t.value->elem;
+    encoding.i = static_cast<int64_t>(rng.below(t.range + 2));
+    items.push_back(encoding);
+  }
+  }
+}
+
+// Integer struct member `id` into `out`; false if it is missing or not an
+// integer.
+bool int_field(const thrift_value &value, int16_t id, int64_t &out) {
+  const thrift_value *field = value.field(id);
+  if (!field || !field->is_int()) {
+    return false;
+  }
+  out = field->i;
+  return true;
+}
+
+void add_to(thrift_value *field, int64_t delta) {
+  if (field && field->is_int()) {
+    field->i = clamp_to(field->type, wrap_add(field->i, delta));
+  }
+}
+
+// What a leaf column of the schema tells the page mutators.
+struct leaf_column {
+  int64_t type = -1;
+  int64_t type_length = 0;
+  uint8_t max_definition = 0;
+  uint8_t max_repetition = 0;
+};
+
+// Walk the flattened schema tree (depth first, num_children per element)
+// from `at`, collecting its leaves in column order.
+void schema_leaves(const std::vector<thrift_value> &schema, size_t &at,
+                   uint8_t definition, uint8_t repetition, int depth,
+                   std::vector<leaf_column> &leaves) {
+  if (at >= schema.size() || depth > 64) {
+    at = schema.size();
+    return;
+  }
+  const thrift_value &element = schema[at++];
+  int64_t repetition_type = kRequired, children = 0;
+  // the root has no repetition and adds no level
+  if (depth > 0 && int_field(element, kSchemaRepetition, repetition_type)) {
+    definition += repetition_type != kRequired;
+    repetition += repetition_type == kRepeated;
+  }
+  if (!int_field(element, kSchemaNumChildren, children) || children <= 0) {
+    leaf_column leaf{-1, 0, definition, repetition};
+    int_field(element, kSchemaType, leaf.type);
+    int_field(element, kSchemaTypeLength, leaf.type_length);
+    leaves.push_back(leaf);
+    return;
+  }
+  for (int64_t i = 0; i < children && at < schema.size(); ++i) {
+    schema_leaves(schema, at, definition, repetition, depth + 1, leaves);
+  }
+}
+
+// One to three edits to `root`, a struct of kind `kind`.
+void mutate_tree(thrift_value &root, meta_kind kind, RandomStream &rng,
+                 size_t file_size) {
+  const size_t edits = 1 + rng.below(3);
+  std::vector<target> targets;
+  for (size_t e = 0; e < edits; ++e) {
+    // Re-collected after every edit: removing or duplicating list items
+    // moves the values the previous targets pointed at.
+    targets.clear();
+    collect(root, kind, targets);
+    if (targets.empty()) {
+      return;
+    }
+    const target &t = targets[rng.below(targets.size())];
+    switch (t.role) {
+    case target_role::stat:
+      mutate_stat(t, rng);
+      break;
+    case target_role::list:
+      mutate_list(t, rng);
+      break;
+    case target_role::structure: {
+      auto &fields = t.value->fields;
+      fields.erase(fields.begin() + rng.below(fields.size()));
+      break;
+    }
+    default:
+      mutate_int(t, rng, file_size);
+    }
+  }
+}
+
+} // namespace
+
+void mutate_footer(thrift_value &meta, RandomStream &rng, size_t file_size) {
+  mutate_tree(meta, meta_kind::file, rng, file_size);
+}
+
+void mutate_row_group(thrift_value &group, RandomStream &rng,
+                      size_t file_size) {
+  mutate_tree(group, meta_kind::row_group, rng, file_size);
+}
+
+bool index_parquet_pages(const char *data, const parquet_layout &layout,
+                         std::vector<parquet_page> &pages) {
+  pages.clear();
+  thrift_value meta;
+  if (thrift_decode_struct(data + layout.footer_offset, layout.footer_size,
+                           meta) == 0) {
+    return false;
+  }
+  const thrift_value *groups = meta.field(kMetaRowGroups);
+  if (!groups) {
+    return false;
+  }
+  std::vector<leaf_column> leaves;
+  if (const thrift_value *schema = meta.field(kMetaSchema)) {
+    size_t at = 0;
+    schema_leaves(schema->items, at, 0, 0, 0, leaves);
+  }
+  const int64_t first = static_cast<int64_t>(layout.pages_offset);
+  const int64_t last = static_cast<int64_t>(layout.footer_offset);
+  uint32_t chunk = 0;
+  for (const auto &group : groups->items) {
+    const thrift_value *columns = group.field(kRowGroupColumns);
+    if (!columns) {
+      return false;
+    }
+    for (size_t c = 0; c < columns->items.size(); ++c) {
+      const thrift_value &column = columns->items[c];
+      const leaf_column leaf = c < leaves.size() ? leaves[c] : leaf_column{};
+      uint32_t dictionary_size = 0;
+      const thrift_value *column_meta = column.field(kChunkMetaData);
+      int64_t begin, size, dictionary, codec = kCodecUncompressed;
+      if (!column_meta ||
+          !int_field(*column_meta, kColumnDataPageOffset, begin) ||
+          !int_field(*column_meta, kColumnCompressedSize, size)) {
+        return false;
+      }
+      // the dictionary page, when there is one, leads the chunk
+      if (int_field(*column_meta, kColumnDictionaryPageOffset, dictionary) &&
+          dictionary > 0 && dictionary < begin) {
+        begin = dictionary;
+      }
+      int_field(*column_meta, kColumnCodec, codec);
+      if (begin < first || size < 0 || size > last - begin) {
+        return false;
+      }
+      const size_t end = static_cast<size_t>(begin + size);
+      for (size_t pos = static_cast<size_t>(begin); pos < end;) {
+        thrift_value header;
+        int64_t payload, uncompressed = 0;
+        const size_t header_size =
+            thrift_decode_struct(data + pos, end - pos, header);
+        if (header_size == 0 ||
+            !int_field(header, kPageCompressedSize, payload) || payload < 0 ||
+            static_cast<uint64_t>(payload) > end - pos - header_size) {
+          return false;
+        }
+        int_field(header, kPageUncompressedSize, uncompressed);
+        parquet_page page{pos, static_cast<uint32_t>(header_size),
+                          static_cast<uint32_t>(payload),
+                          static_cast<uint32_t>(uncompressed), chunk, codec};
+        page.compressed = codec != kCodecUncompressed;
+        page.physical_type = leaf.type;
+        page.type_length = leaf.type_length;
+        page.max_definition = leaf.max_definition;
+        page.max_repetition = leaf.max_repetition;
+        int_field(header, kPageType, page.type);
+        // the page type's own header: value count and encoding
+        int64_t num_values = 0;
+        const thrift_value *values = header.field(
+            page.type == kPageTypeDataV2       ? kPageDataV2
+            : page.type == kPageTypeDictionary ? kPageDictionary
+                                               : kPageData);
+        if (values) {
+          int_field(*values, kDataNumValues, num_values);
+          int_field(*values,
+                    page.type == kPageTypeDataV2 ? kV2Encoding : kDataEncoding,
+                    page.encoding);
+        }
+        page.num_values = static_cast<uint32_t>(std::max<int64_t>(num_values, 0));
+        if (page.type == kPageTypeDictionary) {
+          dictionary_size = page.num_values;
+        }
+        page.dictionary_size = dictionary_size;
+
+        int64_t definition = 0, repetition = 0, is_compressed = 1;
+        const thrift_value *v2 = header.field(kPageDataV2);
+        if (page.type == kPageTypeDataV2 && v2) {
+          int_field(*v2, kV2DefinitionLevelsSize, definition);
+          int_field(*v2, kV2RepetitionLevelsSize, repetition);
+          if (const thrift_value *flag = v2->field(kV2IsCompressed)) {
+            is_compressed = flag->i; // a bool, which int_field() skips
+          }
+          if (definition < 0 || repetition < 0 ||
+              definition + repetition > payload) {
+            return false;
+          }
+          page.levels_size = static_cast<uint32_t>(definition + repetition);
+          page.compressed = page.compressed && is_compressed;
+        }
+        pages.push_back(page);
+        pos += header_size + payload;
+      }
+      ++chunk;
+    }
+  }
+  std::sort(pages.begin(), pages.end(),
+            [](const parquet_page &a, const parquet_page &b) {
+              return a.header_offset < b.header_offset;
+            });
+  for (size_t i = 1; i < pages.size(); ++i) {
+    const parquet_page &prev = pages[i - 1];
+    if (pages[i].header_offset <
+        prev.header_offset + prev.header_size + prev.payload_size) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void rewrite_page_header(const char *data, const parquet_page &page,
+                         const char *payload, size_t size,
+                         size_t uncompressed_size, std::string &out) {
+  thrift_value header;
+  thrift_decode_struct(data + page.header_offset, page.header_size, header);
+  for (auto [id, value] : {std::pair<int16_t, size_t>{kPageCompressedSize, size},
+                           {kPageUncompressedSize, uncompressed_size}}) {
+    if (thrift_value *field = header.field(id); field && field->is_int()) {
+      field->i = clamp_to(field->type, static_cast<int64_t>(value));
+    }
+  }
+  if (thrift_value *crc = header.field(kPageCrc)) {
+    crc->i = static_cast<int32_t>(
+        crc32(0, reinterpret_cast<const Bytef *>(payload), size));
+  }
+  thrift_encode_struct(header, out);
+}
+
+void relocate_footer(thrift_value &meta, const std::vector<page_edit> &edits) {
+  thrift_value *groups = meta.field(kMetaRowGroups);
+  if (!groups || edits.empty()) {
+    return;
+  }
+  // An offset moves with every edited page that starts before it; one that
+  // points at an edited page itself (its header) stays.
+  auto shift = [&edits](thrift_value *field) {
+    if (!field || !field->is_int()) {
+      return;
+    }
+    int64_t delta = 0;
+    for (const auto &edit : edits) {
+      if (static_cast<int64_t>(edit.page->header_offset) < field->i) {
+        delta = wrap_add(delta, edit.delta);
+      }
+    }
+    add_to(field, delta);
+  };
+
+  uint32_t chunk = 0;
+  for (auto &group : groups->items) {
+    thrift_value *columns = group.field(kRowGroupColumns);
+    if (!columns) {
+      continue;
+    }
+    int64_t group_delta = 0, group_uncompressed = 0;
+    for (auto &column : columns->items) {
+      int64_t delta = 0, uncompressed = 0;
+      for (const auto &edit : edits) {
+        if (edit.page->chunk == chunk) {
+          delta = wrap_add(delta, edit.delta);
+          uncompressed = wrap_add(uncompressed, edit.uncompressed_delta);
+        }
+      }
+      shift(column.field(kChunkFileOffset));
+      shift(column.field(kChunkOffsetIndexOffset));
+      shift(column.field(kChunkColumnIndexOffset));
+      if (thrift_value *column_meta = column.field(kChunkMetaData)) {
+        shift(column_meta->field(kColumnDataPageOffset));
+        shift(column_meta->field(kColumnIndexPageOffset));
+        shift(column_meta->field(kColumnDictionaryPageOffset));
+        shift(column_meta->field(kColumnBloomFilterOffset));
+        add_to(column_meta->field(kColumnCompressedSize), delta);
+        add_to(column_meta->field(kColumnUncompressedSize), uncompressed);
+      }
+      group_delta = wrap_add(group_delta, delta);
+      group_uncompressed = wrap_add(group_uncompressed, uncompressed);
+      ++chunk;
+    }
+    shift(group.field(kRowGroupFileOffset));
+    add_to(group.field(kRowGroupTotalCompressedSize), group_delta);
+    add_to(group.field(kRowGroupTotalByteSize), group_uncompressed);
+  }
+}
+
+} // namespace fuzzberg
@@ -0,0 +1,222 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ParquetIndex.h"
+#include "Random.h"
+#include "Thrift.h"
+
+// Parquet's Thrift structures, by field id
+// (https://github.com/apache/parquet-format/blob/master/src/main/thrift/parquet.thrift),
+// the structure-aware footer mutator built on them, and the page index
+// that lets pages be mutated one at a time.
+
+namespace fuzzberg {
+namespace parquet {
+
+// FileMetaData
+constexpr int16_t kMetaVersion = 1;
+constexpr int16_t kMetaSchema = 2;    // list<SchemaElement>
+constexpr int16_t kMetaNumRows = 3;
+constexpr int16_t kMetaRowGroups = 4; // list<RowGroup>
+constexpr int16_t kMetaCreatedBy = 6;
+constexpr int16_t kMetaColumnOrders = 7; // list<ColumnOrder>
+
+// SchemaElement
+constexpr int16_t kSchemaType = 1;
+constexpr int16_t kSchemaTypeLength = 2;
+constexpr int16_t kSchemaRepetition = 3;
+constexpr int16_t kSchemaName = 4;
+constexpr int16_t kSchemaNumChildren = 5;
+constexpr int16_t kSchemaConvertedType = 6;
+constexpr int16_t kSchemaScale = 7;
+constexpr int16_t kSchemaPrecision = 8;
+
+// RowGroup
+constexpr int16_t kRowGroupColumns = 1; // list<ColumnChunk>
+constexpr int16_t kRowGroupTotalByteSize = 2;
+constexpr int16_t kRowGroupNumRows = 3;
+constexpr int16_t kRowGroupFileOffset = 5;
+constexpr int16_t kRowGroupTotalCompressedSize = 6;
+
+// ColumnChunk
+constexpr int16_t kChunkFileOffset = 2;
+constexpr int16_t kChunkMetaData = 3; // ColumnMetaData
+constexpr int16_t kChunkOffsetIndexOffset = 4;
+constexpr int16_t kChunkColumnIndexOffset = 6;
+
+// ColumnMetaData
+constexpr int16_t kColumnType = 1;
+constexpr int16_t kColumnEncodings = 2; // list<Encoding>
+constexpr int16_t kColumnPath = 3;      // list<string>
+constexpr int16_t kColumnCodec = 4;
+constexpr int16_t kColumnNumValues = 5;
+constexpr int16_t kColumnUncompressedSize = 6;
+constexpr int16_t kColumnCompressedSize = 7;
+constexpr int16_t kColumnDataPageOffset = 9;
+constexpr int16_t kColumnIndexPageOffset = 10;
+constexpr int16_t kColumnDictionaryPageOffset = 11;
+constexpr int16_t kColumnStatistics = 12;
+constexpr int16_t kColumnBloomFilterOffset = 14;
+
+// Statistics
+constexpr int16_t kStatsMax = 1;
+constexpr int16_t kStatsMin = 2;
+constexpr int16_t kStatsNullCount = 3;
+constexpr int16_t kStatsDistinctCount = 4;
+constexpr int16_t kStatsMaxValue = 5;
+constexpr int16_t kStatsMinValue = 6;
+
+// PageHeader
+constexpr int16_t kPageType = 1;
+constexpr int16_t kPageUncompressedSize = 2;
+constexpr int16_t kPageCompressedSize = 3;
+constexpr int16_t kPageCrc = 4;
+constexpr int16_t kPageData = 5;       // DataPageHeader
+constexpr int16_t kPageDictionary = 7; // DictionaryPageHeader
+constexpr int16_t kPageDataV2 = 8;     // DataPageHeaderV2
+
+// DataPageHeader, DictionaryPageHeader (both start the same way)
+constexpr int16_t kDataNumValues = 1;
+constexpr int16_t kDataEncoding = 2;
+
+// DataPageHeaderV2
+constexpr int16_t kV2NumValues = 1;
+constexpr int16_t kV2Encoding = 4;
+constexpr int16_t kV2DefinitionLevelsSize = 5;
+constexpr int16_t kV2RepetitionLevelsSize = 6;
+constexpr int16_t kV2IsCompressed = 7;
+
+// PageType
+constexpr int64_t kPageTypeData = 0;
+constexpr int64_t kPageTypeDictionary = 2;
+constexpr int64_t kPageTypeDataV2 = 3;
+
+// FieldRepetitionType
+constexpr int64_t kRequired = 0;
+constexpr int64_t kOptional = 1;
+constexpr int64_t kRepeated = 2;
+
+// Type (physical)
+constexpr int64_t kBoolean = 0;
+constexpr int64_t kInt32 = 1;
+constexpr int64_t kInt64 = 2;
+constexpr int64_t kInt96 = 3;
+constexpr int64_t kFloat = 4;
+constexpr int64_t kDouble = 5;
+constexpr int64_t kByteArray = 6;
+constexpr int64_t kFixedLenByteArray = 7;
+
+// Encoding
+constexpr int64_t kPlain = 0;
+constexpr int64_t kPlainDictionary = 2;
+constexpr int64_t kRle = 3;
+constexpr int64_t kDeltaBinaryPacked = 5;
+constexpr int64_t kDeltaLengthByteArray = 6;
+constexpr int64_t kDeltaByteArray = 7;
+constexpr int64_t kRleDictionary = 8;
+
+// CompressionCodec
+constexpr int64_t kCodecUncompressed = 0;
+
+// Enum ranges (one past the largest value the format defines)
+constexpr int64_t kTypeCount = 8;           // BOOLEAN .. FIXED_LEN_BYTE_ARRAY
+constexpr int64_t kRepetitionCount = 3;     // REQUIRED, OPTIONAL, REPEATED
+constexpr int64_t kConvertedTypeCount = 22; // UTF8 .. INTERVAL
+constexpr int64_t kCodecCount = 8;          // UNCOMPRESSED .. LZ4_RAW
+constexpr int64_t kEncodingCount = 10;      // PLAIN .. BYTE_STREAM_SPLIT
+
+} // namespace parquet
+
+// Apply one to three typed edits to a decoded FileMetaData: counts, sizes
+// and page offsets set to boundary values (or to other offsets within the
+// file), enums to neighbouring or out-of-range values, statistics
+// truncated, swapped or widened, encodings, schema elements, row groups
+// and column chunks dropped or duplicated, optional fields removed. Every
+// choice comes from `rng`. `file_size` anchors the offset edits.
+void mutate_footer(thrift_value &meta, RandomStream &rng, size_t file_size);
+
+// The same edits confined to one RowGroup (its column chunks, their
+// metadata and statistics), for footers that are encoded a row group at a
+// time and never held whole.
+void mutate_row_group(thrift_value &group, RandomStream &rng,
+                      size_t file_size);
+
+// One page of a column chunk: a PageHeader followed by its payload.
+struct parquet_page {
+  size_t header_offset = 0; // in the file
+  uint32_t header_size = 0;
+  uint32_t payload_size = 0; // compressed_page_size
+  uint32_t uncompressed_size = 0; // uncompressed_page_size
+  uint32_t chunk = 0; // ColumnChunk, counted across row groups in order
+  int64_t codec = 0;  // of the column chunk
+  // DATA_PAGE_V2 stores its levels uncompressed, ahead of the values
+  uint32_t levels_size = 0;
+  bool compressed = false; // the values are compressed with `codec`
+
+  // What the values are, for the encoding-aware mutators
+  int64_t type = 0;          // PageType
+  int64_t encoding = -1;     // of the values, -1 if the header has none
+  int64_t physical_type = -1; // of the column, -1 if the schema is unknown
+  int64_t type_length = 0;   // FIXED_LEN_BYTE_ARRAY width
+  uint32_t num_values = 0;
+  uint32_t dictionary_size = 0; // entries in the chunk's dictionary page
+  uint8_t max_definition = 0;   // level maxima, from the schema
+  uint8_t max_repetition = 0;
+};
+
+// List the pages of every column chunk of the file at `data`, in file
+// order, with what the schema and page headers say about their values.
+// Chunks are walked from their dictionary (or first data) page over
+// total_compressed_size bytes; false if the footer does not decode, or a
+// chunk or page header does not fit between the magic and the footer, or
+// pages overlap.
+bool index_parquet_pages(const char *data, const parquet_layout &layout,
+                         std::vector<parquet_page> &pages);
+
+// The header of `page` (in the file at `data`) re-encoded for a new
+// payload of `size` bytes at `payload`, `uncompressed_size` once
+// decompressed, appended to `out`; a CRC, if the page has one, is
+// recomputed so readers that verify it get to the payload.
+void rewrite_page_header(const char *data, const parquet_page &page,
+                         const char *payload, size_t size,
+                         size_t uncompressed_size, std::string &out);
+
+// A page rewritten with `delta` more (or fewer) bytes, and a size when
+// uncompressed that changed by `uncompressed_delta`; both count the header.
+struct page_edit {
+  const parquet_page *page;
+  int64_t delta = 0;
+  int64_t uncompressed_delta = 0;
+};
+
+// Update the FileMetaData `meta` for `edits` (in file order): page, chunk,
+// index and bloom filter offsets past an edited page move with it, and the
+// compressed / uncompressed totals of its column chunk and row group grow
+// or shrink by its deltas.
+void relocate_footer(thrift_value &meta, const std::vector<page_edit> &edits);
+
+} // namespace fuzzberg
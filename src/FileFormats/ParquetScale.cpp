@@ -0,0 +1,707 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#include "ParquetScale.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+#include "ParquetIndex.h"
+#include "ParquetMetadata.h"
+#include "Thrift.h"
+
+namespace fuzzberg {
+namespace {
+
+using namespace parquet;
+
+// Bounds on what one shape may ask for: the footer (about 150 bytes per
+// column chunk) and one page or dictionary are built in memory.
+constexpr uint64_t kMaxColumns = 20000;
+constexpr uint64_t kMaxRowGroups = 20000;
+constexpr uint64_t kMaxChunks = 1 << 18;
+constexpr uint64_t kMaxPageBytes = 16 << 20;
+constexpr uint64_t kMaxDictionaryBytes = 64 << 20;
+constexpr uint64_t kMaxStringLength = 4096;
+
+// Estimates for parquet_shape_bytes
+constexpr uint64_t kPageOverhead = 24;  // header, plus definition levels
+constexpr uint64_t kChunkOverhead = 64; // ColumnChunk in the footer
+
+constexpr int64_t kUtf8 = 0; // ConvertedType
+
+constexpr size_t kProfiles = 5;
+constexpr const char *kProfileNames[kProfiles] = {"wide", "deep", "tall",
+                                                  "dictionary", "mixed"};
+
+enum class column_kind { int64, string, dbl, int32 };
+
+column_kind kind_of(uint32_t column) {
+  return static_cast<column_kind>(column % 4);
+}
+
+int64_t physical_type(column_kind kind) {
+  static constexpr int64_t kTypes[] = {kInt64, kByteArray, kDouble, kInt32};
+  return kTypes[static_cast<int>(kind)];
+}
+
+// Columns of `kind` among the first `columns`.
+uint64_t columns_of(const parquet_shape &shape, column_kind kind) {
+  const uint32_t k = static_cast<uint32_t>(kind);
+  return shape.columns / 4 + (shape.columns % 4 > k);
+}
+
+bool optional(column_kind kind) {
+  return kind == column_kind::string || kind == column_kind::dbl;
+}
+
+int index_width(uint32_t dictionary) {
+  int width = 1;
+  while (width < 32 && (uint64_t{1} << width) < dictionary) {
+    ++width;
+  }
+  return width;
+}
+
+// Encoded bytes of one value of `kind`, times 8 (dictionary indices are
+// bit-packed).
+uint64_t value_bits(const parquet_shape &shape, column_kind kind) {
+  switch (kind) {
+  case column_kind::int32:
+    return 32;
+  case column_kind::string:
+    return shape.dictionary ? index_width(shape.dictionary)
+                            : 8 * (4 + uint64_t{shape.string_length});
+  default:
+    return 64;
+  }
+}
+
+uint64_t row_bits(const parquet_shape &shape) {
+  uint64_t bits = 0;
+  for (auto kind : {column_kind::int64, column_kind::string,
+                    column_kind::dbl, column_kind::int32}) {
+    bits += columns_of(shape, kind) * value_bits(shape, kind);
+  }
+  return bits;
+}
+
+uint64_t dictionary_bytes(const parquet_shape &shape) {
+  return shape.dictionary * (4 + uint64_t{shape.string_length});
+}
+
+// Log-uniform in [1, limit]: small values are as likely as huge ones.
+uint64_t spread(RandomStream &rng, uint64_t limit) {
+  int bits = 0;
+  while (bits < 63 && (uint64_t{2} << bits) <= limit) {
+    ++bits;
+  }
+  const uint64_t low = uint64_t{1} << rng.below(bits + 1);
+  return std::min(limit, low + rng.below(low));
+}
+
+// Value `n` of the stream `seed`: cheap enough for billions of values.
+uint64_t mix(uint64_t seed, uint64_t n) {
+  uint64_t x = seed + n * 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 33)) * 0xff51afd7ed558ccdULL;
+  x = (x ^ (x >> 33)) * 0xc4ceb9fe1a85ec53ULL;
+  return x ^ (x >> 33);
+}
+
+// `length` lowercase letters (valid UTF-8, which readers may check).
+void put_string(uint64_t seed, uint32_t length, std::string &out) {
+  for (uint32_t i = 0; i < length; i += 16) {
+    uint64_t bits = mix(seed, i);
+    for (uint32_t k = i; k < length && k < i + 16; ++k, bits >>= 4) {
+      out.push_back(static_cast<char>('a' + (bits & 15)));
+    }
+  }
+}
+
+template <typename T> void put_raw(T v, std::string &out) {
+  char raw[sizeof(T)];
+  memcpy(raw, &v, sizeof(T));
+  out.append(raw, sizeof(T));
+}
+
+thrift_value number(thrift_type type, int64_t v) {
+  thrift_value value;
+  value.type = type;
+  value.i = v;
+  return value;
+}
+
+thrift_value binary(std::string bytes) {
+  thrift_value value;
+  value.type = thrift_type::binary;
+  value.bin = std::move(bytes);
+  return value;
+}
+
+thrift_value list_of(thrift_type elem) {
+  thrift_value value;
+  value.type = thrift_type::list;
+  value.elem = elem;
+  return value;
+}
+
+void add(thrift_value &owner, int16_t id, thrift_value value) {
+  owner.type = thrift_type::structure;
+  owner.fields.emplace_back(id, std::move(value));
+}
+
+// Buffered writes that count the file offset; the first error sticks.
+class file_writer {
+public:
+  explicit file_writer(const std::string &path)
+      : _file(std::fopen(path.c_str(), "wb")) {
+    if (_file) {
+      std::setvbuf(_file, nullptr, _IOFBF, 1 << 20);
+    }
+  }
+  ~file_writer() {
+    if (_file) {
+      std::fclose(_file);
+    }
+  }
+  bool ok() const { return _file && !_failed; }
+  uint64_t offset() const { return _offset; }
+  void write(const std::string &bytes) {
+    if (ok() && std::fwrite(bytes.data(), 1, bytes.size(), _file) !=
+                    bytes.size()) {
+      _failed = true;
+    }
+    _offset += bytes.size();
+  }
+  bool close() {
+    const bool closed = _file && std::fclose(_file) == 0;
+    _file = nullptr;
+    return closed && !_failed;
+  }
+
+private:
+  std::FILE *_file;
+  uint64_t _offset = 0;
+  bool _failed = false;
+};
+
+// Header of a page of `size` bytes (uncompressed, so both sizes match).
+void page_header(int64_t type, uint32_t size, uint32_t values,
+                 int64_t encoding, std::string &out) {
+  thrift_value header, page;
+  add(header, kPageType, number(thrift_type::i32, type));
+  add(header, kPageUncompressedSize, number(thrift_type::i32, size));
+  add(header, kPageCompressedSize, number(thrift_type::i32, size));
+  add(page, kDataNumValues, number(thrift_type::i32, values));
+  add(page, kDataEncoding, number(thrift_type::i32, encoding));
+  if (type == kPageTypeData) {
+    // definition and repetition level encodings
+    add(page, 3, number(thrift_type::i32, kRle));
+    add(page, 4, number(thrift_type::i32, kRle));
+  }
+  add(header,
+      type == kPageTypeDictionary ? kPageDictionary : kPageData, page);
+  out.clear();
+  thrift_encode_struct(header, out);
+}
+
+// Writes one column chunk at a time, page by page.
+class chunk_writer {
+public:
+  chunk_writer(const parquet_shape &shape, file_writer &file, uint64_t seed)
+      : _shape(shape), _file(file), _seed(seed) {}
+
+  // Column `column` of row group `group`; returns its ColumnChunk.
+  thrift_value write(uint32_t group, uint32_t column) {
+    const column_kind kind = kind_of(column);
+    const uint64_t seed = mix(_seed, column);
+    const bool dictionary = kind == column_kind::string && _shape.dictionary;
+    const uint64_t start = _file.offset();
+    _min = std::numeric_limits<int64_t>::max();
+    _max = std::numeric_limits<int64_t>::min();
+    _dmin = std::numeric_limits<double>::infinity();
+    _dmax = -_dmin;
+
+    if (dictionary) {
+      _page.clear();
+      for (uint32_t i = 0; i < _shape.dictionary; ++i) {
+        put_u32(_shape.string_length, _page);
+        put_string(mix(seed, i), _shape.string_length, _page);
+      }
+      emit(kPageTypeDictionary, _shape.dictionary, kPlain);
+    }
+    const uint64_t data_offset = _file.offset();
+    uint64_t row = uint64_t{group} * _shape.rows;
+    for (uint64_t left = _shape.rows; left > 0;) {
+      const uint32_t n =
+          static_cast<uint32_t>(std::min<uint64_t>(left, _shape.page_rows));
+      _page.clear();
+      if (optional(kind)) {
+        // every value defined: one RLE run of 1s, bit width 1
+        std::string levels;
+        put_varint(uint64_t{n} << 1, levels);
+        levels.push_back(1);
+        put_u32(static_cast<uint32_t>(levels.size()), _page);
+        _page += levels;
+      }
+      values(kind, seed, row, n);
+      emit(kPageTypeData, n, dictionary ? kRleDictionary : kPlain);
+      row += n;
+      left -= n;
+    }
+    const int64_t size = static_cast<int64_t>(_file.offset() - start);
+
+    thrift_value meta;
+    add(meta, kColumnType, number(thrift_type::i32, physical_type(kind)));
+    thrift_value encodings = list_of(thrift_type::i32);
+    encodings.items.push_back(number(thrift_type::i32, kPlain));
+    encodings.items.push_back(number(thrift_type::i32, kRle));
+    if (dictionary) {
+      encodings.items.push_back(number(thrift_type::i32, kRleDictionary));
+    }
+    add(meta, kColumnEncodings, encodings);
+    thrift_value path = list_of(thrift_type::binary);
+    path.items.push_back(binary("c" + std::to_string(column)));
+    add(meta, kColumnPath, path);
+    add(meta, kColumnCodec, number(thrift_type::i32, kCodecUncompressed));
+    add(meta, kColumnNumValues,
+        number(thrift_type::i64, static_cast<int64_t>(_shape.rows)));
+    add(meta, kColumnUncompressedSize, number(thrift_type::i64, size));
+    add(meta, kColumnCompressedSize, number(thrift_type::i64, size));
+    add(meta, kColumnDataPageOffset,
+        number(thrift_type::i64, static_cast<int64_t>(data_offset)));
+    if (dictionary) {
+      add(meta, kColumnDictionaryPageOffset,
+          number(thrift_type::i64, static_cast<int64_t>(start)));
+    }
+    if (kind != column_kind::string) {
+      // min / max let readers prune, and the footer edits garble them
+      thrift_value stats;
+      std::string max, min;
+      if (kind == column_kind::dbl) {
+        put_raw(_dmax, max);
+        put_raw(_dmin, min);
+      } else if (kind == column_kind::int32) {
+        put_raw(static_cast<int32_t>(_max), max);
+        put_raw(static_cast<int32_t>(_min), min);
+      } else {
+        put_raw(_max, max);
+        put_raw(_min, min);
+      }
+      add(stats, kStatsNullCount, number(thrift_type::i64, 0));
+      add(stats, kStatsMaxValue, binary(max));
+      add(stats, kStatsMinValue, binary(min));
+      add(meta, kColumnStatistics, stats);
+    }
+
+    thrift_value chunk;
+    add(chunk, kChunkFileOffset,
+        number(thrift_type::i64, static_cast<int64_t>(start)));
+    add(chunk, kChunkMetaData, meta);
+    return chunk;
+  }
+
+private:
+  void values(column_kind kind, uint64_t seed, uint64_t row, uint32_t n) {
+    switch (kind) {
+    case column_kind::int64:
+      for (uint32_t i = 0; i < n; ++i) {
+        const int64_t v = static_cast<int64_t>(mix(seed, row + i));
+        _min = std::min(_min, v);
+        _max = std::max(_max, v);
+        put_raw(v, _page);
+      }
+      break;
+    case column_kind::int32:
+      for (uint32_t i = 0; i < n; ++i) {
+        const int32_t v = static_cast<int32_t>(mix(seed, row + i));
+        _min = std::min<int64_t>(_min, v);
+        _max = std::max<int64_t>(_max, v);
+        put_raw(v, _page);
+      }
+      break;
+    case column_kind::dbl:
+      for (uint32_t i = 0; i < n; ++i) {
+        // finite, spread over [-2^20, 2^20)
+        const double v =
+            static_cast<double>(static_cast<int64_t>(mix(seed, row + i)) >>
+                                11) /
+            (1ULL << 32);
+        _dmin = std::min(_dmin, v);
+        _dmax = std::max(_dmax, v);
+        put_raw(v, _page);
+      }
+      break;
+    case column_kind::string:
+      if (_shape.dictionary) {
+        // bit width, then one bit-packed run of n indices padded to 8
+        const int width = index_width(_shape.dictionary);
+        _page.push_back(static_cast<char>(width));
+        put_varint((uint64_t{(n + 7) / 8} << 1) | 1, _page);
+        uint64_t acc = 0;
+        int bits = 0;
+        for (uint32_t i = 0; i < (n + 7) / 8 * 8; ++i) {
+          const uint64_t index =
+              i < n ? mix(seed ^ 1, row + i) % _shape.dictionary : 0;
+          acc |= index << bits;
+          bits += width;
+          while (bits >= 8) {
+            _page.push_back(static_cast<char>(acc));
+            acc >>= 8;
+            bits -= 8;
+          }
+        }
+      } else {
+        for (uint32_t i = 0; i < n; ++i) {
+          put_u32(_shape.string_length, _page);
+          put_string(mix(seed, row + i), _shape.string_length, _page);
+        }
+      }
+      break;
+    }
+  }
+
+  void emit(int64_t type, uint32_t values, int64_t encoding) {
+    page_header(type, static_cast<uint32_t>(_page.size()), values, encoding,
+                _header);
+    _file.write(_header);
+    _file.write(_page);
+  }
+
+  const parquet_shape &_shape;
+  file_writer &_file;
+  const uint64_t _seed;
+  std::string _page, _header; // reused across pages
+  int64_t _min = 0, _max = 0; // integer column statistics
+  double _dmin = 0, _dmax = 0;
+};
+
+} // namespace
+
+uint64_t parquet_shape_bytes(const parquet_shape &shape) {
+  const uint64_t chunks = uint64_t{shape.row_groups} * shape.columns;
+  const uint64_t pages =
+      (shape.rows + shape.page_rows - 1) / std::max(shape.page_rows, 1u);
+  const uint64_t dictionaries =
+      shape.dictionary ? columns_of(shape, column_kind::string) : 0;
+  return 12 + shape.row_groups * shape.rows * row_bits(shape) / 8 +
+         chunks * (pages * kPageOverhead + kChunkOverhead) +
+         shape.row_groups * dictionaries *
+             (dictionary_bytes(shape) + kPageOverhead) +
+         shape.columns * 16;
+}
+
+parquet_shape draw_parquet_shape(RandomStream &rng, uint64_t max_bytes) {
+  parquet_shape shape;
+  max_bytes = std::max<uint64_t>(max_bytes >> rng.below(8), 4096);
+  shape.profile = static_cast<scale_profile>(rng.below(kProfiles));
+  switch (shape.profile) {
+  case scale_profile::wide:
+    shape.columns = spread(rng, kMaxColumns);
+    shape.row_groups = spread(rng, 8);
+    break;
+  case scale_profile::deep:
+    shape.columns = spread(rng, 16);
+    shape.row_groups = spread(rng, kMaxRowGroups);
+    break;
+  case scale_profile::tall:
+    shape.columns = spread(rng, 4);
+    shape.row_groups = 1;
+    break;
+  case scale_profile::dictionary:
+    shape.columns = 2 + rng.below(6);
+    shape.row_groups = spread(rng, 16);
+    shape.dictionary = spread(rng, 1 << 22);
+    break;
+  default:
+    shape.columns = spread(rng, 1024);
+    shape.row_groups = spread(rng, 1024);
+  }
+  shape.row_groups = static_cast<uint32_t>(
+      std::min<uint64_t>(shape.row_groups, kMaxChunks / shape.columns));
+  if (!shape.dictionary && rng.below(2)) {
+    shape.dictionary = spread(rng, 1 << 16);
+  }
+  shape.string_length = rng.below(4) ? spread(rng, 32) - 1
+                                     : spread(rng, kMaxStringLength);
+  if (dictionary_bytes(shape) > kMaxDictionaryBytes) {
+    shape.dictionary = static_cast<uint32_t>(
+        kMaxDictionaryBytes / (4 + uint64_t{shape.string_length}));
+  }
+  // The widest value of a row bounds the rows a page can hold.
+  const uint64_t widest = std::max<uint64_t>(
+      8, shape.columns > 1 && !shape.dictionary ? 4 + shape.string_length : 0);
+  shape.page_rows = static_cast<uint32_t>(
+      std::min<uint64_t>(spread(rng, 1 << 20), kMaxPageBytes / widest));
+
+  // Halve whatever dominates (dictionaries, row groups or columns) until
+  // a single row per row group fits; then add as many rows as do.
+  for (uint64_t bytes; (bytes = parquet_shape_bytes(shape)) > max_bytes;) {
+    const uint64_t dictionaries = shape.row_groups *
+                                  columns_of(shape, column_kind::string) *
+                                  dictionary_bytes(shape);
+    if (shape.dictionary > 1 && dictionaries * 2 > bytes) {
+      shape.dictionary /= 2;
+    } else if (shape.row_groups > 1 && shape.row_groups >= shape.columns) {
+      shape.row_groups /= 2;
+    } else if (shape.columns > 1) {
+      shape.columns /= 2;
+    } else if (shape.dictionary > 1) {
+      shape.dictionary /= 2;
+    } else {
+      break;
+    }
+  }
+  const uint64_t base = parquet_shape_bytes(shape);
+  const uint64_t row = std::max<uint64_t>(
+      1, (shape.row_groups * row_bits(shape) + 7) / 8 +
+             uint64_t{shape.row_groups} * shape.columns * kPageOverhead /
+                 shape.page_rows);
+  if (base < max_bytes) {
+    shape.rows += (max_bytes - base) / row;
+  }
+
+  // Most files get some metadata edits; clean ones keep the timings
+  // comparable.
+  if (rng.below(2)) {
+    shape.mutated_groups =
+        static_cast<uint32_t>(spread(rng, shape.row_groups));
+    shape.mutate_schema = rng.below(4) == 0;
+  }
+  return shape;
+}
+
+std::string parquet_shape_name(const parquet_shape &shape) {
+  std::string name = kProfileNames[static_cast<int>(shape.profile)];
+  name += ": " + std::to_string(shape.row_groups) + " groups x " +
+          std::to_string(shape.columns) + " columns x " +
+          std::to_string(shape.rows) + " rows";
+  if (shape.dictionary) {
+    name += ", dictionary " + std::to_string(shape.dictionary) + " x " +
+            std::to_string(shape.string_length) + " B";
+  } else if (shape.columns > 1) {
+    name += ", strings " + std::to_string(shape.string_length) + " B";
+  }
+  if (shape.mutated_groups || shape.mutate_schema) {
+    name += ", " + std::to_string(shape.mutated_groups) + " groups" +
+            (shape.mutate_schema ? " and schema" : "") + " mutated";
+  }
+  return name;
+}
+
+uint64_t write_parquet(const std::string &path, const parquet_shape &shape,
+                       RandomStream &rng) {
+  file_writer file(path);
+  file.write(std::string(kParquetMagic, 4));
+  chunk_writer chunks(shape, file, rng.next());
+  const uint64_t estimate = parquet_shape_bytes(shape);
+
+  // The row groups are encoded into the footer as they are written; the
+  // rest of FileMetaData goes in front of them at the end.
+  std::string groups;
+  for (uint32_t g = 0; g < shape.row_groups && file.ok(); ++g) {
+    const uint64_t start = file.offset();
+    thrift_value columns = list_of(thrift_type::structure);
+    columns.items.reserve(shape.columns);
+    for (uint32_t c = 0; c < shape.columns && file.ok(); ++c) {
+      columns.items.push_back(chunks.write(g, c));
+    }
+    const int64_t size = static_cast<int64_t>(file.offset() - start);
+    thrift_value group;
+    add(group, kRowGroupColumns, std::move(columns));
+    add(group, kRowGroupTotalByteSize, number(thrift_type::i64, size));
+    add(group, kRowGroupNumRows,
+        number(thrift_type::i64, static_cast<int64_t>(shape.rows)));
+    add(group, kRowGroupFileOffset,
+        number(thrift_type::i64, static_cast<int64_t>(start)));
+    add(group, kRowGroupTotalCompressedSize, number(thrift_type::i64, size));
+    if (rng.below(shape.row_groups) < shape.mutated_groups) {
+      mutate_row_group(group, rng, estimate);
+    }
+    thrift_encode_struct(group, groups);
+  }
+
+  thrift_value meta;
+  add(meta, kMetaVersion, number(thrift_type::i32, 1));
+  thrift_value schema = list_of(thrift_type::structure);
+  thrift_value root;
+  add(root, kSchemaName, binary("schema"));
+  add(root, kSchemaNumChildren, number(thrift_type::i32, shape.columns));
+  schema.items.push_back(root);
+  for (uint32_t c = 0; c < shape.columns; ++c) {
+    const column_kind kind = kind_of(c);
+    thrift_value leaf;
+    add(leaf, kSchemaType, number(thrift_type::i32, physical_type(kind)));
+    add(leaf, kSchemaRepetition,
+        number(thrift_type::i32, optional(kind) ? kOptional : kRequired));
+    add(leaf, kSchemaName, binary("c" + std::to_string(c)));
+    if (kind == column_kind::string) {
+      add(leaf, kSchemaConvertedType, number(thrift_type::i32, kUtf8));
+    }
+    schema.items.push_back(std::move(leaf));
+  }
+  add(meta, kMetaSchema, std::move(schema));
+  add(meta, kMetaNumRows,
+      number(thrift_type::i64,
+             static_cast<int64_t>(shape.rows * shape.row_groups)));
+  // Readers only trust min_value / max_value under a type-defined column
+  // order. The row groups follow these fields, out of id order, which the
+  // compact protocol allows.
+  add(meta, kMetaCreatedBy, binary("fuzzberg"));
+  thrift_value orders = list_of(thrift_type::structure);
+  thrift_value type_order;
+  type_order.type = thrift_type::structure;
+  thrift_value order;
+  add(order, 1, type_order); // ColumnOrder.TYPE_ORDER
+  orders.items.assign(shape.columns, order);
+  add(meta, kMetaColumnOrders, std::move(orders));
+  if (shape.mutate_schema) {
+    mutate_footer(meta, rng, estimate);
+  }
+
+  std::string footer;
+  thrift_encode_struct(meta, footer);
+  footer.pop_back(); // stop: the row groups follow
+  // after whichever field the edits left last
+  const int16_t last = meta.fields.empty() ? 0 : meta.fields.back().first;
+  thrift_encode_list_field(kMetaRowGroups, last, thrift_type::structure,
+                           shape.row_groups, footer);
+  const uint64_t footer_size = footer.size() + groups.size() + 1;
+  file.write(footer);
+  file.write(groups);
+  std::string tail(1, '\0'); // stop
+  put_u32(static_cast<uint32_t>(footer_size), tail);
+  tail.append(kParquetMagic, 4);
+  file.write(tail);
+  const uint64_t size = file.offset();
+  return file.close() ? size : 0;
+}
+
+process_memory read_process_memory(pid_t pid) {
+  process_memory memory;
+  const std::string path = "/proc/" + std::to_string(pid) + "/status";
+  std::unique_ptr<std::FILE, int (*)(std::FILE *)> status(
+      std::fopen(path.c_str(), "r"), std::fclose);
+  if (!status) {
+    return memory;
+  }
+  char line[256];
+  while (std::fgets(line, sizeof(line), status.get())) {
+    unsigned long long kb = 0;
+    if (std::sscanf(line, "VmHWM: %llu", &kb) == 1) {
+      memory.peak_kb = kb;
+    } else if (std::sscanf(line, "VmRSS: %llu", &kb) == 1) {
+      memory.rss_kb = kb;
+    }
+  }
+  return memory;
+}
+
+bool reset_peak_memory(pid_t pid) {
+  const std::string path = "/proc/" + std::to_string(pid) + "/clear_refs";
+  std::FILE *clear = std::fopen(path.c_str(), "w");
+  if (!clear) {
+    return false;
+  }
+  const bool written = std::fputs("5", clear) >= 0;
+  return std::fclose(clear) == 0 && written;
+}
+
+namespace {
+// Flagged when a file costs this many times what the median cost per byte
+// of smaller files of its profile predicts, once there are enough of
+// those...
+constexpr double kSuperLinear = 4;
+constexpr size_t kMinBaseline = 4;
+constexpr size_t kMaxSamples = 4096;
+// ...or this much, if more: small files often show no memory growth at
+// all (the allocator reuses what it has) and time is mostly round trip.
+constexpr double kMinMillis = 100;
+constexpr uint64_t kMinMemoryKb = 16 << 10;
+
+template <typename Cost>
+bool super_linear(const std::vector<scale_sample> &samples,
+                  const scale_sample &sample, Cost cost, double floor) {
+  std::vector<double> per_byte;
+  for (const auto &smaller : samples) {
+    if (smaller.profile == sample.profile &&
+        smaller.bytes * 2 <= sample.bytes) {
+      per_byte.push_back(cost(smaller) / smaller.bytes);
+    }
+  }
+  if (per_byte.size() < kMinBaseline) {
+    return false;
+  }
+  auto median = per_byte.begin() + per_byte.size() / 2;
+  std::nth_element(per_byte.begin(), median, per_byte.end());
+  return cost(sample) > kSuperLinear * std::max(*median * sample.bytes, floor);
+}
+} // namespace
+
+scale_monitor::scale_monitor(const std::string &report) {
+  if (report.empty()) {
+    return;
+  }
+  const bool fresh = !std::ifstream(report).good();
+  _report.open(report, std::ios::app);
+  if (_report && fresh) {
+    _report << "iteration,profile,bytes,row_groups,columns,rows,page_rows,"
+               "dictionary,string_length,mutated_groups,mutated_schema,"
+               "millis,memory_kb,super_linear\n";
+  }
+}
+
+std::string scale_monitor::record(const scale_sample &sample,
+                                  const parquet_shape &shape) {
+  std::string flag;
+  if (super_linear(
+          _samples, sample,
+          [](const scale_sample &s) { return s.millis; }, kMinMillis)) {
+    flag = "time";
+  }
+  if (super_linear(
+          _samples, sample,
+          [](const scale_sample &s) { return double(s.memory_kb); },
+          kMinMemoryKb)) {
+    flag += flag.empty() ? "memory" : "+memory";
+  }
+  if (_samples.size() == kMaxSamples) {
+    _samples.erase(_samples.begin());
+  }
+  _samples.push_back(sample);
+
+  if (_report) {
+    _report << sample.iteration << ','
+            << kProfileNames[static_cast<int>(shape.profile)] << ','
+            << sample.bytes << ','
+            << shape.row_groups << ',' << shape.columns << ',' << shape.rows
+            << ',' << shape.page_rows << ',' << shape.dictionary << ','
+            << shape.string_length << ',' << shape.mutated_groups << ','
+            << shape.mutate_schema << ',' << sample.millis << ','
+            << sample.memory_kb << ',' << flag << std::endl;
+  }
+  return flag;
+}
+
+} // namespace fuzzberg
@@ -0,0 +1,125 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Random.h"
+
+// --parquet-scale: Parquet files far larger than a mutation buffer,
+// synthesized straight to disk, and a record of what reading each one cost
+// the target. Seed mutations stay around the size of their seeds; scaling
+// bugs need thousands of row groups, wide schemas, huge dictionaries or
+// multi-GB column chunks to show.
+
+namespace fuzzberg {
+
+// What a shape stresses; costs are only compared within one profile.
+enum class scale_profile : uint8_t {
+  wide,       // thousands of columns
+  deep,       // thousands of row groups
+  tall,       // a few huge column chunks
+  dictionary, // huge dictionaries
+  mixed,
+};
+
+// Shape of a synthesized file. Columns cycle through INT64 (required),
+// BYTE_ARRAY (optional, dictionary-encoded when `dictionary` is set),
+// DOUBLE (optional) and INT32 (required); pages are uncompressed.
+struct parquet_shape {
+  scale_profile profile = scale_profile::mixed;
+  uint32_t row_groups = 1;
+  uint32_t columns = 1;
+  uint64_t rows = 1;           // per row group
+  uint32_t page_rows = 1;      // rows per data page
+  uint32_t dictionary = 0;     // BYTE_ARRAY dictionary entries, 0 for PLAIN
+  uint32_t string_length = 0;  // bytes per BYTE_ARRAY value
+  uint32_t mutated_groups = 0; // row groups whose metadata is mutated
+  bool mutate_schema = false;  // and the schema / row count part
+};
+
+// A shape drawn from `rng` whose file comes out at about `max_bytes`
+// halved zero to seven times (so that costs can be compared across sizes),
+// give or take the estimate's error, unless even one row per row group is
+// more than that.
+parquet_shape draw_parquet_shape(RandomStream &rng, uint64_t max_bytes);
+
+// About the size of the file `shape` gives.
+uint64_t parquet_shape_bytes(const parquet_shape &shape);
+
+// "wide: 12 groups x 300 columns x 5000 rows, dictionary 1000 x 16 B"
+std::string parquet_shape_name(const parquet_shape &shape);
+
+// Write a file of `shape` to `path` a page at a time: only the page being
+// written (or a column chunk's dictionary) and the footer are ever in
+// memory. Values and metadata edits are drawn from `rng`, so the file is
+// regenerated byte for byte from the same stream. Returns the file size,
+// or 0 if writing failed (errno says why).
+uint64_t write_parquet(const std::string &path, const parquet_shape &shape,
+                       RandomStream &rng);
+
+// Resident memory of a process, in KiB, from /proc/<pid>/status; zeros if
+// it cannot be read.
+struct process_memory {
+  uint64_t peak_kb = 0; // VmHWM
+  uint64_t rss_kb = 0;  // VmRSS
+};
+process_memory read_process_memory(pid_t pid);
+// Restart the peak at the current RSS (clear_refs); false if refused, and
+// the peak then covers the process' whole life.
+bool reset_peak_memory(pid_t pid);
+
+// One synthesized file and what reading it cost the target.
+struct scale_sample {
+  scale_profile profile = scale_profile::mixed;
+  uint64_t iteration = 0;
+  uint64_t bytes = 0;
+  double millis = 0;      // all queries, back to back
+  uint64_t memory_kb = 0; // peak RSS above the RSS before the queries
+};
+
+// Keeps the samples of a session and flags super-linear ones: a file whose
+// time or memory per byte is several times the median of files of the
+// same profile at most half its size. Every sample is appended to a CSV
+// report, if there is one.
+class scale_monitor {
+public:
+  // No report unless `report` names a file; it is appended to, so a
+  // restarted target (--continue) keeps adding to the same one.
+  explicit scale_monitor(const std::string &report = "");
+
+  // Record `sample` of a file of `shape`; returns what grew super-linearly
+  // ("time", "memory" or "time+memory"), empty if nothing did.
+  std::string record(const scale_sample &sample, const parquet_shape &shape);
+
+private:
+  std::vector<scale_sample> _samples; // the latest kMaxSamples
+  std::ofstream _report;
+};
+
+} // namespace fuzzberg
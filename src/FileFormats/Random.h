@@ -0,0 +1,106 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <unistd.h>
+
+// Per-fuzzer PRNG (xoshiro256**, seeded through splitmix64). Every random
+// choice of a fuzzing iteration, the radamsa seeds included, is drawn from
+// a stream derived from (master seed, iteration[, step]), so any iteration
+// can be regenerated from the logged master seed without replaying the ones
+// before it.
+
+namespace fuzzberg {
+
+inline uint64_t splitmix64(uint64_t &state) {
+  uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+class RandomStream {
+public:
+  explicit RandomStream(uint64_t seed = 0) { reseed(seed); }
+
+  // Independent stream for one iteration (and optionally one step of it,
+  // e.g. a metadata field in Iceberg sequence 2).
+  static RandomStream derive(uint64_t master_seed, uint64_t iteration,
+                             uint64_t step = 0) {
+    uint64_t mix = master_seed;
+    uint64_t seed = splitmix64(mix) ^ iteration;
+    mix = seed;
+    seed = splitmix64(mix) ^ step;
+    return RandomStream(seed);
+  }
+
+  // A fresh master seed: the only place /dev/urandom is read.
+  static uint64_t entropy() {
+    uint64_t seed = 0;
+    std::FILE *f = std::fopen("/dev/urandom", "rb");
+    if (!f || std::fread(&seed, 1, sizeof(seed), f) != sizeof(seed)) {
+      // Seeding without /dev/urandom
+      seed = static_cast<uint64_t>(time(NULL)) ^
+             (static_cast<uint64_t>(getpid()) << 32) ^ clock();
+    }
+    if (f)
+      std::fclose(f);
+    return seed;
+  }
+
+  void reseed(uint64_t seed) {
+    for (auto &word : _s)
+      word = splitmix64(seed);
+  }
+
+  uint64_t next() {
+    const uint64_t result = rotl(_s[1] * 5, 7) * 9;
+    const uint64_t t = _s[1] << 17;
+    _s[2] ^= _s[0];
+    _s[3] ^= _s[1];
+    _s[1] ^= _s[2];
+    _s[0] ^= _s[3];
+    _s[2] ^= t;
+    _s[3] = rotl(_s[3], 45);
+    return result;
+  }
+
+  // Uniform in [0, n); n must be > 0. Multiply-shift instead of modulo.
+  size_t below(size_t n) {
+    return static_cast<size_t>(
+        (static_cast<unsigned __int128>(next()) * n) >> 64);
+  }
+
+  // Seed for one radamsa() call
+  unsigned int seed32() { return static_cast<unsigned int>(next() >> 32); }
+
+private:
+  uint64_t _s[4];
+
+  static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+} // namespace fuzzberg
@@ -0,0 +1,86 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#include "SeedCache.h"
+#include "FileFuzzerBase.h"
+
+#include <zlib.h>
+
+#include <cstring>
+#include <iostream>
+
+namespace fuzzberg {
+
+void deflate_seed(corpus_stat &stat) {
+  if (stat.corpus == nullptr || stat.size == 0 || stat.stored != 0 ||
+      !stat.owned) {
+    return;
+  }
+  uLongf stored = compressBound(stat.size);
+  std::unique_ptr<char[]> deflated(new char[stored]);
+  if (compress2(reinterpret_cast<Bytef *>(deflated.get()), &stored,
+                reinterpret_cast<const Bytef *>(stat.corpus), stat.size,
+                Z_DEFAULT_COMPRESSION) != Z_OK ||
+      stored > stat.size - stat.size / 8) {
+    return; // incompressible: keep it inflated
+  }
+  char *corpus = new char[stored];
+  memcpy(corpus, deflated.get(), stored);
+  delete[] stat.corpus;
+  stat.corpus = corpus;
+  stat.stored = stored;
+}
+
+const char *SeedCache::get(const corpus_stat &stat, size_t capacity) {
+  if (stat.stored == 0) {
+    return stat.corpus;
+  }
+  auto hit = _index.find(stat.corpus);
+  if (hit != _index.end()) {
+    _lru.splice(_lru.begin(), _lru, hit->second);
+    return hit->second->data.get();
+  }
+
+  std::unique_ptr<char[]> data(new char[stat.size + 1]);
+  uLongf size = stat.size;
+  if (uncompress(reinterpret_cast<Bytef *>(data.get()), &size,
+                 reinterpret_cast<const Bytef *>(stat.corpus),
+                 stat.stored) != Z_OK ||
+      size != stat.size) {
+    std::cerr << "Corrupt compressed corpus entry (" << stat.stored
+              << " bytes)" << std::endl;
+    exit(1);
+  }
+  data[stat.size] = '\0'; // JSON entries are parsed as C strings
+
+  // make room, but never evict the entry about to be returned
+  _bytes += stat.size;
+  while (_bytes > capacity && !_lru.empty()) {
+    _bytes -= _lru.back().size;
+    _index.erase(_lru.back().key);
+    _lru.pop_back();
+  }
+  _lru.push_front({stat.corpus, std::move(data), stat.size});
+  _index[stat.corpus] = _lru.begin();
+  return _lru.front().data.get();
+}
+
+} // namespace fuzzberg
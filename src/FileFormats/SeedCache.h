@@ -0,0 +1,65 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+// Compressed corpus (--compress-corpus). Large Parquet and Avro corpora are
+// highly compressible, and keeping every seed inflated for the whole run
+// caps how many workers fit on a box. Seeds can instead be stored deflated
+// (zlib) and inflated on demand when a fuzz loop picks them; the most
+// recently used ones are kept inflated in a small LRU, so a hot seed costs
+// one inflate, not one per iteration.
+
+namespace fuzzberg {
+
+struct corpus_stat;
+
+// Replace `stat`'s new[] buffer with its deflated bytes (stat.stored set)
+// unless that saves less than an eighth. `stat.size` stays the inflated
+// size. Thread-safe (the corpus is compressed by the loader threads).
+void deflate_seed(corpus_stat &stat);
+
+class SeedCache {
+public:
+  // The inflated, NUL-terminated bytes of `stat`; `stat.corpus` itself when
+  // it isn't stored compressed. Inflated seeds are kept, least recently
+  // used first out, while they total at most `capacity` bytes; the one
+  // returned last always stays valid until the next call.
+  const char *get(const corpus_stat &stat, size_t capacity);
+
+private:
+  struct entry {
+    const char *key; // the deflated buffer, stable while the seed lives
+    std::unique_ptr<char[]> data;
+    size_t size;
+  };
+
+  std::list<entry> _lru; // most recently used first
+  std::unordered_map<const char *, std::list<entry>::iterator> _index;
+  size_t _bytes = 0;
+};
+
+} // namespace fuzzberg
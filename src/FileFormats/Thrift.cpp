@@ -0,0 +1,378 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#include "Thrift.h"
+
+#include <cstring>
+
+namespace fuzzberg {
+
+namespace {
+
+// Parquet footers nest a handful of levels; anything deeper is hostile.
+constexpr int kMaxDepth = 64;
+// Bound list sizes by the bytes left, so a corrupt header can't make the
+// decoder reserve gigabytes.
+constexpr size_t kMinElementBytes = 1;
+
+class reader {
+public:
+  reader(const char *data, size_t size)
+      : _p(reinterpret_cast<const uint8_t *>(data)), _end(_p + size),
+        _begin(_p) {}
+
+  size_t consumed() const { return _p - _begin; }
+  size_t left() const { return _end - _p; }
+
+  bool byte(uint8_t &out) {
+    if (_p == _end)
+      return false;
+    out = *_p++;
+    return true;
+  }
+
+  bool varint(uint64_t &out) {
+    out = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t b;
+      if (!byte(b))
+        return false;
+      out |= static_cast<uint64_t>(b & 0x7f) << shift;
+      if (!(b & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  bool zigzag(int64_t &out) {
+    uint64_t raw;
+    if (!varint(raw))
+      return false;
+    out = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+    return true;
+  }
+
+  bool bytes(size_t n, std::string &out) {
+    if (n > left())
+      return false;
+    out.assign(reinterpret_cast<const char *>(_p), n);
+    _p += n;
+    return true;
+  }
+
+  // A value of `type` whose header (if any) has been read.
+  bool value(thrift_type type, thrift_value &out, int depth) {
+    // Checked here, not only per struct: containers nest without one.
+    if (depth > kMaxDepth)
+      return false;
+    out.type = type;
+    switch (type) {
+    case thrift_type::bool_true:
+    case thrift_type::bool_false: {
+      // in a container: one byte, 1 for true
+      uint8_t b;
+      if (!byte(b))
+        return false;
+      out.i = (b == 1);
+      return true;
+    }
+    case thrift_type::i8: {
+      uint8_t b;
+      if (!byte(b))
+        return false;
+      out.i = static_cast<int8_t>(b);
+      return true;
+    }
+    case thrift_type::i16:
+    case thrift_type::i32:
+    case thrift_type::i64:
+      return zigzag(out.i);
+    case thrift_type::dbl: {
+      std::string raw;
+      if (!bytes(8, raw))
+        return false;
+      std::memcpy(&out.d, raw.data(), 8); // little endian
+      return true;
+    }
+    case thrift_type::binary: {
+      uint64_t n;
+      return varint(n) && bytes(n, out.bin);
+    }
+    case thrift_type::list:
+    case thrift_type::set: {
+      uint8_t header;
+      if (!byte(header))
+        return false;
+      uint64_t n = header >> 4;
+      out.elem = static_cast<thrift_type>(header & 0x0f);
+      if (n == 15 && !varint(n))
+        return false;
+      if (n > left() / kMinElementBytes || !valid(out.elem))
+        return false;
+      out.items.resize(n);
+      for (auto &item : out.items) {
+        if (!element(out.elem, item, depth))
+          return false;
+      }
+      return true;
+    }
+    case thrift_type::map: {
+      uint64_t n;
+      if (!varint(n))
+        return false;
+      if (n == 0)
+        return true;
+      uint8_t types;
+      if (!byte(types) || n > left() / (2 * kMinElementBytes))
+        return false;
+      out.elem = static_cast<thrift_type>(types >> 4);
+      out.val = static_cast<thrift_type>(types & 0x0f);
+      if (!valid(out.elem) || !valid(out.val))
+        return false;
+      out.items.resize(2 * n);
+      for (size_t k = 0; k < out.items.size(); ++k) {
+        if (!element(k % 2 ? out.val : out.elem, out.items[k], depth))
+          return false;
+      }
+      return true;
+    }
+    case thrift_type::structure:
+      return structure(out, depth);
+    default:
+      return false;
+    }
+  }
+
+  bool structure(thrift_value &out, int depth) {
+    if (depth > kMaxDepth)
+      return false;
+    out.type = thrift_type::structure;
+    int16_t last = 0;
+    while (true) {
+      uint8_t header;
+      if (!byte(header))
+        return false;
+      auto type = static_cast<thrift_type>(header & 0x0f);
+      if (type == thrift_type::stop)
+        return true;
+      if (!valid(type))
+        return false;
+      int16_t id;
+      if (header >> 4) {
+        id = static_cast<int16_t>(last + (header >> 4));
+      } else {
+        int64_t wide;
+        if (!zigzag(wide))
+          return false;
+        id = static_cast<int16_t>(wide);
+      }
+      last = id;
+      thrift_value field;
+      if (type == thrift_type::bool_true || type == thrift_type::bool_false) {
+        // the value is the header's type
+        field.type = type;
+        field.i = (type == thrift_type::bool_true);
+      } else if (!value(type, field, depth + 1)) {
+        return false;
+      }
+      out.fields.emplace_back(id, std::move(field));
+    }
+  }
+
+private:
+  bool element(thrift_type type, thrift_value &out, int depth) {
+    return value(type, out, depth + 1);
+  }
+
+  static bool valid(thrift_type type) {
+    return type >= thrift_type::bool_true && type <= thrift_type::structure;
+  }
+
+  const uint8_t *_p;
+  const uint8_t *_end;
+  const uint8_t *_begin;
+};
+
+void put_zigzag(int64_t n, std::string &out) { put_varint(zigzag(n), out); }
+
+// Field ids are written as a delta from the previous field when it fits
+// in the header's high nibble.
+void put_field_header(int16_t id, int16_t last, thrift_type type,
+                      std::string &out) {
+  const int delta = id - last;
+  if (delta > 0 && delta <= 15) {
+    out.push_back(static_cast<char>(delta << 4 | static_cast<uint8_t>(type)));
+  } else {
+    out.push_back(static_cast<char>(type));
+    put_zigzag(id, out);
+  }
+}
+
+void put_list_header(thrift_type elem, size_t n, std::string &out) {
+  if (n < 15) {
+    out.push_back(static_cast<char>(n << 4 | static_cast<uint8_t>(elem)));
+  } else {
+    out.push_back(static_cast<char>(0xf0 | static_cast<uint8_t>(elem)));
+    put_varint(n, out);
+  }
+}
+
+void put_value(const thrift_value &value, std::string &out);
+
+void put_element(thrift_type type, const thrift_value &value,
+                 std::string &out) {
+  if (type == thrift_type::bool_true || type == thrift_type::bool_false) {
+    out.push_back(value.i ? 1 : 2);
+  } else {
+    put_value(value, out);
+  }
+}
+
+void put_value(const thrift_value &value, std::string &out) {
+  switch (value.type) {
+  case thrift_type::i8:
+    out.push_back(static_cast<char>(value.i));
+    break;
+  case thrift_type::i16:
+  case thrift_type::i32:
+  case thrift_type::i64:
+    put_zigzag(value.i, out);
+    break;
+  case thrift_type::dbl: {
+    char raw[8];
+    std::memcpy(raw, &value.d, 8);
+    out.append(raw, 8);
+    break;
+  }
+  case thrift_type::binary:
+    put_varint(value.bin.size(), out);
+    out += value.bin;
+    break;
+  case thrift_type::list:
+  case thrift_type::set: {
+    put_list_header(value.elem, value.items.size(), out);
+    for (const auto &item : value.items)
+      put_element(value.elem, item, out);
+    break;
+  }
+  case thrift_type::map: {
+    const size_t n = value.items.size() / 2;
+    put_varint(n, out);
+    if (n == 0)
+      break;
+    out.push_back(static_cast<char>(static_cast<uint8_t>(value.elem) << 4 |
+                                    static_cast<uint8_t>(value.val)));
+    for (size_t k = 0; k < 2 * n; ++k)
+      put_element(k % 2 ? value.val : value.elem, value.items[k], out);
+    break;
+  }
+  case thrift_type::structure:
+    thrift_encode_struct(value, out);
+    break;
+  default:
+    break; // booleans are written by their field header or container
+  }
+}
+
+} // namespace
+
+thrift_value *thrift_value::field(int16_t id) {
+  for (auto &member : fields) {
+    if (member.first == id)
+      return &member.second;
+  }
+  return nullptr;
+}
+
+const thrift_value *thrift_value::field(int16_t id) const {
+  return const_cast<thrift_value *>(this)->field(id);
+}
+
+size_t thrift_decode_struct(const char *data, size_t size, thrift_value &out) {
+  reader in(data, size);
+  out = thrift_value();
+  if (!in.structure(out, 0))
+    return 0;
+  return in.consumed();
+}
+
+void thrift_encode_struct(const thrift_value &value, std::string &out) {
+  int16_t last = 0;
+  for (const auto &[id, field] : value.fields) {
+    auto type = field.type;
+    if (type == thrift_type::bool_true || type == thrift_type::bool_false)
+      type = field.i ? thrift_type::bool_true : thrift_type::bool_false;
+    put_field_header(id, last, type, out);
+    last = id;
+    put_value(field, out);
+  }
+  out.push_back(0); // stop
+}
+
+void thrift_encode_list_field(int16_t id, int16_t last_id, thrift_type elem,
+                              size_t count, std::string &out) {
+  put_field_header(id, last_id, thrift_type::list, out);
+  put_list_header(elem, count, out);
+}
+
+void put_varint(uint64_t n, std::string &out) {
+  while (n >= 0x80) {
+    out.push_back(static_cast<char>((n & 0x7f) | 0x80));
+    n >>= 7;
+  }
+  out.push_back(static_cast<char>(n));
+}
+
+bool read_varint(const std::string &s, size_t &pos, uint64_t &out) {
+  out = 0;
+  for (int shift = 0; shift < 64 && pos < s.size(); shift += 7) {
+    const uint8_t b = static_cast<uint8_t>(s[pos++]);
+    out |= static_cast<uint64_t>(b & 0x7f) << shift;
+    if (!(b & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint64_t zigzag(int64_t n) {
+  return (static_cast<uint64_t>(n) << 1) ^ static_cast<uint64_t>(n >> 63);
+}
+
+void put_u32(uint32_t n, std::string &out) {
+  for (int i = 0; i < 4; ++i) {
+    out.push_back(static_cast<char>(n >> (8 * i)));
+  }
+}
+
+uint32_t read_u32(const std::string &s, size_t pos) {
+  const auto *p = reinterpret_cast<const uint8_t *>(s.data() + pos);
+  return uint32_t{p[0]} | uint32_t{p[1]} << 8 | uint32_t{p[2]} << 16 |
+         uint32_t{p[3]} << 24;
+}
+
+void write_u32(std::string &s, size_t pos, uint32_t n) {
+  for (int i = 0; i < 4; ++i) {
+    s[pos + i] = static_cast<char>(n >> (8 * i));
+  }
+}
+
+} // namespace fuzzberg
@@ -0,0 +1,105 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Thrift compact protocol, as used by Parquet for its FileMetaData footer
+// and page headers
+// (https://github.com/apache/thrift/blob/master/doc/specs/thrift-compact-protocol.md).
+// Values are decoded into a schema-less tree that keeps field ids, types
+// and order, so re-encoding an unmodified tree gives back the same bytes
+// and a mutator can edit any field without generated code.
+
+namespace fuzzberg {
+
+// Compact protocol type ids (booleans are split in two in field headers).
+enum class thrift_type : uint8_t {
+  stop = 0,
+  bool_true = 1,
+  bool_false = 2,
+  i8 = 3,
+  i16 = 4,
+  i32 = 5,
+  i64 = 6,
+  dbl = 7,
+  binary = 8,
+  list = 9,
+  set = 10,
+  map = 11,
+  structure = 12,
+};
+
+struct thrift_value {
+  thrift_type type = thrift_type::stop;
+  int64_t i = 0;    // bool (0/1), i8, i16, i32, i64
+  double d = 0;     // dbl
+  std::string bin;  // binary (and string)
+  thrift_type elem = thrift_type::stop; // list / set elements, map keys
+  thrift_type val = thrift_type::stop;  // map values
+  std::vector<thrift_value> items;      // list / set; map: key, value, ...
+  std::vector<std::pair<int16_t, thrift_value>> fields; // struct, in order
+
+  bool is_int() const {
+    return type == thrift_type::i8 || type == thrift_type::i16 ||
+           type == thrift_type::i32 || type == thrift_type::i64;
+  }
+  // Struct member `id`, or nullptr.
+  thrift_value *field(int16_t id);
+  const thrift_value *field(int16_t id) const;
+};
+
+// Decode the struct at `data` (at most `size` bytes) into `out`. Returns
+// the number of bytes it took, or 0 if it is malformed or nested deeper
+// than the decoder allows.
+size_t thrift_decode_struct(const char *data, size_t size, thrift_value &out);
+
+// Append the compact encoding of struct `value` to `out`.
+void thrift_encode_struct(const thrift_value &value, std::string &out);
+
+// For structs too large to build as one tree (the footer of a synthesized
+// file): append the header of list field `id`, following field `last_id`,
+// with `count` elements of type `elem`. The caller appends the elements
+// (thrift_encode_struct for structs) and then the enclosing struct's stop
+// byte.
+void thrift_encode_list_field(int16_t id, int16_t last_id, thrift_type elem,
+                              size_t count, std::string &out);
+
+// The integer encodings Thrift shares with Parquet's own: ULEB128 varints
+// (RLE run headers, DELTA_BINARY_PACKED), zigzag for signed ones, and
+// 4-byte little-endian lengths (PLAIN BYTE_ARRAY, level runs, the footer
+// length).
+void put_varint(uint64_t n, std::string &out);
+// The varint at `pos` in `s`, moving `pos` past it; false if it runs off
+// the end or past 64 bits.
+bool read_varint(const std::string &s, size_t &pos, uint64_t &out);
+uint64_t zigzag(int64_t n);
+void put_u32(uint32_t n, std::string &out);
+// At `pos`, which must leave 4 bytes in `s`.
+uint32_t read_u32(const std::string &s, size_t pos);
+void write_u32(std::string &s, size_t pos, uint32_t n);
+
+} // namespace fuzzberg
@@ -19,9 +19,36 @@
 
 */
 
+// Fuzz CSV as follows, one of these per iteration (--csv-modes):
+// blob:
+//    Radamsa mutates the whole seed
+// grammar:
+// 1. Sniff each seed's dialect and index its fields (once per seed)
+// 2. Edit one to three fields or rows: type boundary values, quoting,
+//    embedded newlines, column-count drift
+// 3. Copy the rest of the seed around the edits, so the file still parses
+
 #include "csv.h"
 
+#include <algorithm>
+#include <map>
+
 namespace fuzzberg {
+namespace {
+constexpr mode_name kModeNames[] = {
+    {"blob", kCsvBlob},
+    {"grammar", kCsvGrammar},
+};
+} // namespace
+
+bool parse_csv_modes(const std::string &list, unsigned &modes) {
+  return parse_mode_list(list, kModeNames, modes);
+}
+
+std::string csv_modes_name(unsigned modes) {
+  return mode_list_name(modes, kModeNames);
+}
+
 CSVFuzzer::CSVFuzzer(pid_t target_pid, std::string fuzzer_mutation_path) {
   std::cout << "Entered CSV fuzzer: " << std::endl;
   // Persist target_pid on the base so the timeout path in Fuzz() can
@@ -29,60 +56,123 @@ CSVFuzzer::CSVFuzzer(pid_t target_pid, std::string fuzzer_mutation_path) {
   // used the local arg and left _target_pid default-initialized — the
   // SIGKILL on timeout was therefore aimed at pid 0.
   this->_target_pid = target_pid;
-  mutated_file_ptr =
-      std::fopen((fuzzer_mutation_path + "/fuzz.csv").c_str(), "wb");
-
-  if (!mutated_file_ptr) {
-    std::cerr << "Could not create or open file for writing mutations: "
-              << fuzzer_mutation_path << std::endl;
-    perror("fopen");
-    kill(target_pid, SIGKILL);
-    exit(1);
-  }
-
+  mutated_file_path = fuzzer_mutation_path + "/fuzz.csv";
   radamsa_init();
 }
 
 int8_t CSVFuzzer::Fuzz(std::vector<std::string> &queries, std::string &db_url,
                        corpus_buffer &input_corpus, char *&radamsa_buffer,
                        size_t &execs, CURL *curl) {
-  srand(seed_generator()); // seeding rand()
-
   if (input_corpus.empty()) {
     std::cerr << "csv fuzzer: input corpus is empty; aborting round\n";
     return -1;
   }
+  fit_capacity(input_corpus);
+  // before the mutator pool forks, so every mutator inherits the index
+  index_corpus(input_corpus);
+
+  // --batch: K files per query round instead of the A/B slots
+  if (batch > 1 && !replay && !coverage) {
+    return fuzz_batches(mutated_file_path, queries, db_url, input_corpus,
+                        radamsa_buffer, execs, curl);
+  }
+
+  // First round only: a round resumed after a target restart keeps the
+  // slots and iteration counter of the previous one.
+  if (_slots.empty()) {
+    open_mutation_slots(mutated_file_path, queries, radamsa_buffer);
+    start_mutators(input_corpus);
+  }
+  auto &queue = dispatcher(curl, db_url);
 
   while (1) {
-    size_t rand_ = rand() % input_corpus.size();
-    auto output_size = radamsa(
-        reinterpret_cast<uint8_t *>(input_corpus[rand_].corpus),
-        input_corpus[rand_].size, reinterpret_cast<uint8_t *>(radamsa_buffer),
-        RADAMSA_BUFFER_SIZE, seed_generator());
+    const size_t iteration = replay ? replay->iteration : _iteration++;
+    auto &slot = _slots[iteration % _slots.size()];
+    // The target may still be reading this slot's file: reap its queries
+    // before overwriting it. Other slots keep running meanwhile.
+    auto ret_code = queue.wait_slot(slot.id);
+    if (ret_code != CURLE_OK) {
+      return slot_failed(slot, ret_code, radamsa_buffer);
+    }
+    // every query for the slot's previous mutation has completed
+    collect_coverage(slot.buffer, slot.size, input_corpus, ".csv");
+    slot.origin = {iteration, 0, 0, input_corpus.size(), 0};
+    next_mutation(iteration, input_corpus, slot);
 
-    write_radamsa_mutation(radamsa_buffer, mutated_file_ptr, output_size);
+    publish_mutation(slot);
 
-    // send query
-    for (auto const &query : queries) {
+    // send queries (completed asynchronously, see QueryDispatcher)
+    reset_coverage();
+    for (auto const &query : slot.queries) {
       execs++;
-      std::cout << "\nQuery : " << query << "\n" << std::endl;
-      auto ret_code = send_query(curl, query, db_url, "");
-      if (ret_code != CURLE_OK) {
-        if (ret_code == CURLE_OPERATION_TIMEDOUT){
-          std::cerr << "Target timed out, kill child and stop fuzzing"
-                    << std::endl;
-          kill(this->_target_pid, SIGKILL);
-          exit(1);
-        }
-        // save size of the crash file
-        crash_input_size = output_size;
-        return -1;
-      } else
-        continue;
+      queue.submit(query, slot.id);
+    }
+    // on the wire before the next mutation is generated
+    queue.progress();
+    if (replay) {
+      return finish_replay(queue, slot, radamsa_buffer);
     }
-    // clear the buffer for next iteration
-    memset(radamsa_buffer, 0, output_size);
   }
   return 0;
 }
+
+void CSVFuzzer::index_corpus(const corpus_buffer &corpus) {
+  if (!(modes & kCsvGrammar)) {
+    return;
+  }
+  const bool first = _indexes.empty();
+  std::map<std::string, size_t> dialects;
+  for (size_t i = _indexes.size(); i < corpus.size(); ++i) {
+    _indexes.emplace_back();
+    if (index_csv(seed(corpus[i]), corpus[i].size, _indexes.back())) {
+      ++dialects[csv_dialect_name(_indexes.back().dialect)];
+    } else {
+      _indexes.back() = {}; // blob mutations only
+    }
+  }
+  if (!first) {
+    return;
+  }
+  // the most common few
+  std::vector<std::pair<size_t, std::string>> common;
+  for (const auto &[name, count] : dialects) {
+    common.emplace_back(count, name);
+  }
+  std::stable_sort(common.begin(), common.end(),
+                   [](const auto &a, const auto &b) {
+                     return a.first > b.first;
+                   });
+  for (size_t i = 0; i < common.size() && i < 5; ++i) {
+    std::cout << "\033[1;32m[INFO] CSV dialect: \033[0m" << common[i].second
+              << " (" << common[i].first
+              << (common[i].first == 1 ? " seed" : " seeds") << ")"
+              << std::endl;
+  }
+  if (common.size() > 5) {
+    std::cout << "\033[1;32m[INFO]\033[0m ... and " << common.size() - 5
+              << " more CSV dialects" << std::endl;
+  }
+}
+
+size_t CSVFuzzer::mutate(uint64_t iteration, const corpus_buffer &corpus,
+                         char *out, size_t capacity, mutation_tail *tail) {
+  // every random choice below comes from (master_seed, iteration)
+  begin_iteration(iteration);
+  index_corpus(corpus);
+
+  // With a single mode enabled nothing is drawn for it, so a blob-only
+  // session mutates exactly as before modes existed.
+  const bool grammar =
+      (modes & kCsvGrammar) && (!(modes & kCsvBlob) || _rng.below(2));
+  size_t rand_ = _rng.below(corpus.size());
+  const char *data = seed(corpus[rand_]);
+  // Seeds without a single field get a blob mutation instead.
+  if (grammar && !_indexes[rand_].fields.empty()) {
+    return mutate_csv(data, corpus[rand_].size, _indexes[rand_], _rng, out,
+                      capacity);
+  }
+  return radamsa(reinterpret_cast<uint8_t *>(const_cast<char *>(data)),
+                 corpus[rand_].size, reinterpret_cast<uint8_t *>(out),
+                 capacity, _rng.seed32());
+}
 } // namespace fuzzberg
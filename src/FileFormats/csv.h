@@ -24,18 +24,52 @@
 #include <iostream>
 #include <vector>
 
+#include "CsvGrammar.h"
 #include "FileFuzzerBase.h"
 
 namespace fuzzberg {
 
+// --csv-modes: the mutations CSVFuzzer draws from, one per iteration. blob
+// runs radamsa over the whole seed; grammar edits fields and rows of the
+// seed's sniffed dialect (CsvGrammar) and copies the rest.
+enum csv_mode : unsigned {
+  kCsvBlob = 1u << 0,
+  kCsvGrammar = 1u << 1,
+};
+constexpr unsigned kCsvDefaultModes = kCsvBlob | kCsvGrammar;
+
+// "blob,grammar" to a mode mask; false on an unknown name or an empty list.
+bool parse_csv_modes(const std::string &list, unsigned &modes);
+// And back, for the replay log.
+std::string csv_modes_name(unsigned modes);
+
 class CSVFuzzer : public FileFuzzerBase {
 public:
   CSVFuzzer(pid_t target_pid, std::string fuzzer_mutation_path);
   ~CSVFuzzer() = default;
 
-  FILE *mutated_file_ptr = nullptr;
+  std::string mutated_file_path;
   int8_t Fuzz(std::vector<std::string> &queries, std::string &db_url,
               corpus_buffer &input_corpus, char *&radamsa_buffer, size_t &execs,
               CURL *curl) override;
+  size_t mutate(uint64_t iteration, const corpus_buffer &corpus, char *out,
+                size_t capacity, mutation_tail *tail) override;
+
+  unsigned modes = kCsvDefaultModes; // csv_mode bits
+
+protected:
+  // Text: radamsa's repeated lines and insertions about double a file.
+  buffer_policy mutation_policy() const override {
+    return {kMinMutationBytes, 2, size_t{64} << 10, size_t{256} << 20};
+  }
+
+private:
+  // Sniff and index the corpus entries added since the last call, in
+  // grammar mode (all of them the first time, then whatever --coverage
+  // appended).
+  void index_corpus(const corpus_buffer &corpus);
+
+  // one per corpus entry, no fields if it did not index
+  std::vector<csv_index> _indexes;
 };
 } // namespace fuzzberg
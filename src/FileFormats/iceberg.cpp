@@ -53,6 +53,32 @@ IcebergFuzzer::IcebergFuzzer(pid_t target_pid,
   radamsa_init();
 }
 
+void IcebergFuzzer::replay_from(const mutation_origin &at,
+                                corpus_buffer &metadata_corpus) {
+  sequence = at.sequence;
+  if (at.sequence == 1) {
+    return; // sequence 1 draws its seed itself
+  }
+  if (at.seed_index >= metadata_corpus.size()) {
+    std::cerr << "Replay log refers to metadata seed " << at.seed_index
+              << ", but only " << metadata_corpus.size() << " are loaded"
+              << std::endl;
+    exit(1);
+  }
+  _metadata_index = at.seed_index;
+  metadata_json = nlohmann::json::parse(seed(metadata_corpus[at.seed_index]),
+                                        nullptr, false);
+  _structured_iteration = at.iteration;
+  _structured_field = at.step > 0 ? at.step - 1 : 0;
+}
+
+IcebergFuzzer::~IcebergFuzzer() {
+  if (new_metadata_file_ptr)
+    std::fclose(new_metadata_file_ptr);
+  if (new_manifest_file_ptr)
+    std::fclose(new_manifest_file_ptr);
+}
+
 namespace {
 
 // Quote a SQL identifier per ANSI: wrap in double-quotes, double any
@@ -150,23 +176,34 @@ std::vector<std::string> IcebergFuzzer::buildColumnFilterQueries() const {
   return out;
 }
 
-CURLcode IcebergFuzzer::sendQueryAndAccount(CURL *curl,
-                                             const std::string &query,
-                                             const std::string &db_url,
-                                             size_t &execs,
-                                             size_t crash_size_on_failure) {
-  execs++;
-  std::cout << "\nQuery : " << query << std::endl;
-  auto rc = send_query(curl, query, db_url, "");
-  if (rc != CURLE_OK) {
-    if (rc == CURLE_OPERATION_TIMEDOUT) {
-      std::cerr << "Target timed out, kill child and stop fuzzing" << std::endl;
-      kill(this->_target_pid, SIGKILL);
-      exit(1);
-    }
-    crash_input_size = crash_size_on_failure;
+int8_t IcebergFuzzer::sendQueriesAndAccount(
+    CURL *curl, const std::vector<std::string> &queries,
+    const std::string &db_url, size_t &execs, size_t crash_size_on_failure) {
+  // User-supplied queries first, then per-iteration column-filter queries
+  // derived from the mutated schema. They all read the same metadata file,
+  // so they run concurrently (up to --inflight) and are reaped together.
+  auto &queue = dispatcher(curl, db_url);
+  reset_coverage();
+  for (auto const &query : queries) {
+    execs++;
+    queue.submit(query, 0);
+  }
+  for (auto const &query : buildColumnFilterQueries()) {
+    execs++;
+    queue.submit(query, 0);
+  }
+  auto rc = queue.wait_slot(0);
+  if (rc == CURLE_OK) {
+    return 0;
   }
-  return rc;
+  crash_input_size = crash_size_on_failure;
+  crash_origin = _origin;
+  if (rc == CURLE_OPERATION_TIMEDOUT) {
+    std::cerr << "Target timed out, killing child" << std::endl;
+    kill(this->_target_pid, SIGKILL);
+    return -2;
+  }
+  return -1;
 }
 
 // Sequence 1
@@ -183,21 +220,25 @@ int8_t IcebergFuzzer::fuzz_metadata_random(std::vector<std::string> &queries,
     std::cerr << "iceberg fuzzer: metadata corpus is empty; aborting round\n";
     return -1;
   }
+  fit_capacity(metadata_corpus);
+  sequence = 2;
 
-  auto seed = seed_generator();
-  srand(seed);
+  const size_t iteration = replay ? replay->iteration : _iteration++;
+  begin_iteration(iteration);
 
   // pick a random metadata from the Metadata corpus
-  size_t rand_metadata = rand() % metadata_corpus.size();
+  size_t rand_metadata = _rng.below(metadata_corpus.size());
+  _metadata_index = rand_metadata;
+  _origin = {iteration, 0, 1, metadata_corpus.size(), rand_metadata};
 
-  this->metadata_json = nlohmann::json::parse(
-      metadata_corpus[rand_metadata].corpus, nullptr, false);
+  const char *metadata = seed(metadata_corpus[rand_metadata]);
+  this->metadata_json = nlohmann::json::parse(metadata, nullptr, false);
 
-  auto output_size = radamsa(reinterpret_cast<uint8_t *>(const_cast<char *>(
-                                 metadata_corpus[rand_metadata].corpus)),
+  auto output_size = radamsa(reinterpret_cast<uint8_t *>(
+                                 const_cast<char *>(metadata)),
                              metadata_corpus[rand_metadata].size,
                              reinterpret_cast<uint8_t *>(radamsa_buffer),
-                             RADAMSA_BUFFER_SIZE, seed);
+                             mutation_capacity(), _rng.seed32());
 
   write_radamsa_mutation(radamsa_buffer, new_metadata_file_ptr, output_size);
 
@@ -209,25 +250,19 @@ int8_t IcebergFuzzer::fuzz_metadata_random(std::vector<std::string> &queries,
   // queries derived from the mutated schema. The latter list is empty
   // when add_column_filters is off, or when the mutation produced an
   // unparseable / schema-less metadata (sequence 1 mutates raw bytes).
-  for (auto const &query : queries) {
-    if (sendQueryAndAccount(curl, query, db_url, execs, output_size) !=
-        CURLE_OK) {
-      std::fclose(new_metadata_file_ptr);
-      std::fclose(new_manifest_file_ptr);
-      return -1;
-    }
+  auto status =
+      sendQueriesAndAccount(curl, queries, db_url, execs, output_size);
+  if (status != 0) {
+    return status;
   }
-  for (auto const &query : buildColumnFilterQueries()) {
-    if (sendQueryAndAccount(curl, query, db_url, execs, output_size) !=
-        CURLE_OK) {
-      std::fclose(new_metadata_file_ptr);
-      std::fclose(new_manifest_file_ptr);
-      return -1;
-    }
+  // Sequence 2 walks the seed picked here as a JSON object, so only
+  // mutations that still parse as one can become metadata seeds.
+  if (coverage && nlohmann::json::parse(radamsa_buffer,
+                                        radamsa_buffer + output_size, nullptr,
+                                        false)
+                      .is_object()) {
+    collect_coverage(radamsa_buffer, output_size, metadata_corpus, ".json");
   }
-  // clear the buffer for next iteration
-  memset(radamsa_buffer, 0, output_size);
-  output_size = 0;
   return 0;
 }
 
@@ -240,7 +275,12 @@ int8_t IcebergFuzzer::fuzz_metadata_structured(
                "*********\033[0m\n\n"
             << std::endl;
 
-  srand(seed_generator());
+  // One iteration covers all fields, each drawing from its own step stream;
+  // a resumed call keeps the iteration number of the interrupted one.
+  if (_structured_field == 0 && !replay) {
+    _structured_iteration = _iteration++;
+  }
+  size_t field_index = 0;
   std::string field_str = "";
   int nested_array_index = 0;
   std::string nested_key = "";
@@ -249,10 +289,20 @@ int8_t IcebergFuzzer::fuzz_metadata_structured(
   std::string _key = "";
 
   for (const auto &[key, value] : this->metadata_json.items()) {
+    // fields before the one that failed were done before the restart
+    if (field_index++ < _structured_field) {
+      continue;
+    }
+    if (replay && field_index > replay->step) {
+      return 0; // only the replayed field
+    }
+    begin_iteration(_structured_iteration, field_index);
+    _origin = {_structured_iteration, field_index, 2, 0, _metadata_index};
+
     // to restore original value post-mutation
     auto tmp = this->metadata_json[key];
 
-    auto rand_ = rand() % 10;
+    auto rand_ = _rng.below(10);
 
     // Mutate nested fields with a probability of < 50%
     if (rand_ < 5) {
@@ -261,7 +311,7 @@ int8_t IcebergFuzzer::fuzz_metadata_structured(
             << "\033[1;33mField is an object, descending further..\033[0m\n"
             << std::endl;
         nlohmann::json::iterator iter = value.begin();
-        int object_index = rand() % value.size();
+        int object_index = _rng.below(value.size());
         std::advance(iter, object_index);
         nested_key = iter.key();
         _key = nested_key;
@@ -270,11 +320,11 @@ int8_t IcebergFuzzer::fuzz_metadata_structured(
         std::cout
             << "\033[1;33mField is an array, traversing further..\033[0m\n"
             << std::endl;
-        nested_array_index = rand() % value.size();
+        nested_array_index = _rng.below(value.size());
         if (value[nested_array_index].is_object() &&
             value[nested_array_index].size() > 0) {
           is_nested_object = true;
-          int object_index = rand() % value[nested_array_index].size();
+          int object_index = _rng.below(value[nested_array_index].size());
           nlohmann::json::iterator iter = value[nested_array_index].begin();
           std::advance(iter, object_index);
           nested_key = iter.key();
@@ -306,15 +356,13 @@ int8_t IcebergFuzzer::fuzz_metadata_structured(
     auto output_size = radamsa(
         reinterpret_cast<uint8_t *>(const_cast<char *>(field_str.c_str())),
         field_str.size(), reinterpret_cast<uint8_t *>(radamsa_buffer),
-        RADAMSA_BUFFER_SIZE - 1, seed_generator());
+        mutation_capacity() - 1, _rng.seed32());
 
     radamsa_buffer[output_size] = '\0';
 
     auto parsed_value = nlohmann::json::parse(radamsa_buffer, nullptr, false);
 
     if (parsed_value.is_discarded()) {
-
-      memset(radamsa_buffer, 0, output_size);
       output_size = 0;
       // try mutating the same field again
       if (++mutate_retries < kMaxMutateRetries) {
@@ -368,28 +416,20 @@ int8_t IcebergFuzzer::fuzz_metadata_structured(
     // from the active (mutated) schema. Sequence 2's mutation targets
     // one field at a time and keeps the rest of metadata_json intact,
     // so the filters reliably reference live columns.
-    for (auto const &query : queries) {
-      if (sendQueryAndAccount(curl, query, db_url, execs, output_size) !=
-          CURLE_OK) {
-        std::fclose(new_metadata_file_ptr);
-        std::fclose(new_manifest_file_ptr);
-        return -1;
-      }
-    }
-    for (auto const &query : buildColumnFilterQueries()) {
-      if (sendQueryAndAccount(curl, query, db_url, execs, output_size) !=
-          CURLE_OK) {
-        std::fclose(new_metadata_file_ptr);
-        std::fclose(new_manifest_file_ptr);
-        return -1;
-      }
-    }
+    auto status =
+        sendQueriesAndAccount(curl, queries, db_url, execs, output_size);
     // restore original key value
     metadata_json[key] = tmp;
-    // clear the buffer for next iteration
-    memset(radamsa_buffer, 0, output_size);
-    output_size = 0;
+    if (status != 0) {
+      _structured_field = field_index; // resume at the next field
+      return status;
+    }
+    if (replay) {
+      return 0;
+    }
   }
+  _structured_field = 0;
+  sequence = 3;
   return 0;
 }
 
@@ -401,6 +441,7 @@ int8_t IcebergFuzzer::fuzz_manifest_list_structured(
   std::cout << "\n\n\033[1;34m********* Starting manifest list fuzzing "
                "*********\033[0m\n\n"
             << std::endl;
+  sequence = 1; // whatever happens below, the next round starts over
 
   // Same empty-corpus guard as sequence 1. _load_corpus silently
   // drops non-OBJ1 avro; without this, rand() % 0 SIGFPEs the fuzzer
@@ -409,6 +450,7 @@ int8_t IcebergFuzzer::fuzz_manifest_list_structured(
     std::cerr << "iceberg fuzzer: manifest corpus is empty; skipping sequence 3\n";
     return 0;
   }
+  fit_capacity(manifest_corpus);
 
   // Write updated metadata file
   if (!new_metadata_file_ptr) {
@@ -423,9 +465,10 @@ int8_t IcebergFuzzer::fuzz_manifest_list_structured(
               new_metadata_file_ptr);
   std::fflush(new_metadata_file_ptr);
 
-  auto seed = seed_generator();
-  srand(seed);
-  size_t rand_manifest = rand() % manifest_corpus.size();
+  const size_t iteration = replay ? replay->iteration : _iteration++;
+  begin_iteration(iteration);
+  size_t rand_manifest = _rng.below(manifest_corpus.size());
+  _origin = {iteration, 0, 3, manifest_corpus.size(), _metadata_index};
 
   // Guard against an Avro entry shorter than the 4-byte "OBJ1"
   // header. Without this, `size - 4` wraps as size_t to ~2^64-1 and
@@ -439,14 +482,15 @@ int8_t IcebergFuzzer::fuzz_manifest_list_structured(
   }
 
   // Retain "OBJ1" header
-  std::memcpy(radamsa_buffer, manifest_corpus[rand_manifest].corpus, 4);
+  const char *manifest = seed(manifest_corpus[rand_manifest]);
+  std::memcpy(radamsa_buffer, manifest, 4);
 
   // Mutate Avro file (excluding header)
   auto manifest_size = manifest_corpus[rand_manifest].size - 4;
   auto output_size = radamsa(
-      reinterpret_cast<uint8_t *>(manifest_corpus[rand_manifest].corpus + 4),
+      reinterpret_cast<uint8_t *>(const_cast<char *>(manifest) + 4),
       manifest_size, reinterpret_cast<uint8_t *>(radamsa_buffer + 4),
-      RADAMSA_BUFFER_SIZE - 4, seed);
+      mutation_capacity() - 4, _rng.seed32());
 
   // --- Enhanced Avro fuzzing logic ---
 
@@ -454,28 +498,29 @@ int8_t IcebergFuzzer::fuzz_manifest_list_structured(
                             "\"fields\":[{\"name\":\"x\",\"type\":\"int\"}]}";
 
   // 1. Corrupt sync marker (last 16 bytes and after header)
-  if (rand() % 10 < 3 && output_size + 4 > 20) {
+  if (_rng.below(10) < 3 && output_size + 4 > 20) {
     size_t sync_offset = output_size + 4 - 16;
     for (size_t i = 0; i < 16; ++i)
-      if (rand() % 10 < 3)
-        radamsa_buffer[sync_offset + i] = static_cast<char>(rand() % 256);
+      if (_rng.below(10) < 3)
+        radamsa_buffer[sync_offset + i] = static_cast<char>(_rng.below(256));
     size_t sync_marker_pos = 5;
     for (size_t i = 0; i < 16 && (sync_marker_pos + i) < output_size + 4; ++i)
-      if (rand() % 10 < 3)
-        radamsa_buffer[sync_marker_pos + i] = static_cast<char>(rand() % 256);
+      if (_rng.below(10) < 3)
+        radamsa_buffer[sync_marker_pos + i] =
+            static_cast<char>(_rng.below(256));
   }
 
   // 2. Mutate block count/length fields
-  if (rand() % 10 < 3 && output_size > 24) {
-    size_t block_meta_pos = 4 + 8 + rand() % 8;
-    radamsa_buffer[block_meta_pos] = static_cast<char>(rand() % 256);
+  if (_rng.below(10) < 3 && output_size > 24) {
+    size_t block_meta_pos = 4 + 8 + _rng.below(8);
+    radamsa_buffer[block_meta_pos] = static_cast<char>(_rng.below(256));
   }
 
   // 3. Insert random Avro schema fragments
 
-  if (rand() % 10 < 3) {
+  if (_rng.below(10) < 3) {
 
-    size_t insert_pos = 100 + rand() % 100;
+    size_t insert_pos = 100 + _rng.below(100);
     size_t schema_len = strlen(fake_schema);
     // We will possibly miss fake schema insertions if Radamsa mutations <
     // 199 + strlen(fake_schema) bytes, but that's fine
@@ -485,31 +530,31 @@ int8_t IcebergFuzzer::fuzz_manifest_list_structured(
   }
 
   // 4. Truncate or pad file
-  if (rand() % 2 == 0 && output_size > 32) {
-    output_size -= rand() % 16;
-  } else if (output_size + 16 < RADAMSA_BUFFER_SIZE - 4) {
+  if (_rng.below(2) == 0 && output_size > 32) {
+    output_size -= _rng.below(16);
+  } else if (output_size + 16 < mutation_capacity() - 4) {
     memset(radamsa_buffer + output_size + 4, 0x00, 16);
     output_size += 16;
   }
 
   // 5. Flip random bits in Avro blocks (simulate bit-level corruption)
-  if (rand() % 10 < 3 && output_size > 64) {
+  if (_rng.below(10) < 3 && output_size > 64) {
     for (int i = 0; i < 8; ++i) {
-      size_t pos = 4 + rand() % (output_size - 4);
-      radamsa_buffer[pos] ^= (1 << (rand() % 8));
+      size_t pos = 4 + _rng.below(output_size - 4);
+      radamsa_buffer[pos] ^= (1 << _rng.below(8));
     }
   }
 
   // 6. Randomly duplicate or reorder blocks (simulate block-level confusion)
-  if (output_size > 128 && (rand() % 10) < 2) {
-    size_t block_start = 4 + rand() % (output_size / 2);
-    size_t block_len = 16 + rand() % 32;
+  if (output_size > 128 && _rng.below(10) < 2) {
+    size_t block_start = 4 + _rng.below(output_size / 2);
+    size_t block_len = 16 + _rng.below(32);
     // block_start + block_len < output_size: guards against overflows if
     // output_size is too small
-    // output_size + block_len < RADAMSA_BUFFER_SIZE - 4: ensures we don't
+    // output_size + block_len < mutation_capacity() - 4: ensures we don't
     // exceed buffer limits
     if ((block_start + block_len < output_size) &&
-        (output_size + block_len < RADAMSA_BUFFER_SIZE - 4)) {
+        (output_size + block_len < mutation_capacity() - 4)) {
       memmove(radamsa_buffer + block_start + block_len,
               radamsa_buffer + block_start, block_len);
       if (block_start + block_len + block_len > output_size)
@@ -524,24 +569,12 @@ int8_t IcebergFuzzer::fuzz_manifest_list_structured(
   // from the metadata's current schema. Sequence 3 rewrites metadata
   // from metadata_json (kept intact across iterations) and mutates
   // only the manifest-list Avro, so the filters always match.
-  for (auto const &query : queries) {
-    if (sendQueryAndAccount(curl, query, db_url, execs, output_size) !=
-        CURLE_OK) {
-      std::fclose(new_metadata_file_ptr);
-      std::fclose(new_manifest_file_ptr);
-      return -1;
-    }
-  }
-  for (auto const &query : buildColumnFilterQueries()) {
-    if (sendQueryAndAccount(curl, query, db_url, execs, output_size) !=
-        CURLE_OK) {
-      std::fclose(new_metadata_file_ptr);
-      std::fclose(new_manifest_file_ptr);
-      return -1;
-    }
+  auto status =
+      sendQueriesAndAccount(curl, queries, db_url, execs, output_size);
+  if (status != 0) {
+    return status;
   }
-  memset(radamsa_buffer, 0, output_size);
-  output_size = 0;
+  collect_coverage(radamsa_buffer, output_size + 4, manifest_corpus, ".avro");
   metadata_json.clear();
 
   // TODO:
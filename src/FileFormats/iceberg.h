@@ -32,7 +32,7 @@ namespace fuzzberg {
 class IcebergFuzzer : public FileFuzzerBase {
 public:
   IcebergFuzzer(pid_t target_pid, std::string &fuzzer_mutation_path);
-  ~IcebergFuzzer() = default;
+  ~IcebergFuzzer();
 
   int8_t fuzz_metadata_random(std::vector<std::string> &queries,
                               std::string &db_url, char *&radamsa_buffer,
@@ -55,6 +55,15 @@ public:
   FILE *new_manifest_file_ptr = nullptr;
   nlohmann::json metadata_json;
 
+  // Next sequence to run (1-3). The backend loop dispatches on it, and each
+  // fuzz_* moves it on, so a session resumed after a target restart
+  // continues after the step that failed instead of starting over.
+  int sequence = 1;
+
+  // --replay: position the fuzzer at `at` (sequence, metadata seed, field),
+  // so the next fuzz_* call regenerates that step.
+  void replay_from(const mutation_origin &at, corpus_buffer &metadata_corpus);
+
   // When non-empty, FuzzBerg synthesizes one additional `SELECT *` per
   // primitive column in the just-mutated schema and runs it alongside
   // the user-supplied queries. Each generated query is of the form:
@@ -77,6 +86,13 @@ public:
   std::string table_expr_for_column_filters;
   bool add_column_filters = false;
 
+protected:
+  // Metadata JSON and manifest lists, which the fuzzer itself re-parses:
+  // well below what a data file may reach.
+  buffer_policy mutation_policy() const override {
+    return {kMinMutationBytes, 2, size_t{64} << 10, size_t{64} << 20};
+  }
+
 private:
   // Build the per-iteration WHERE-bearing queries from the current
   // metadata_json (sequence 1/2/3 all leave it as the just-written
@@ -84,14 +100,22 @@ private:
   // the schema can't be located, or no primitive columns are present.
   std::vector<std::string> buildColumnFilterQueries() const;
 
-  // Send a single query through curl; encapsulates the per-query
-  // bookkeeping (execs++ , timeout-kills-target, crash-size capture)
-  // that was previously duplicated across the three fuzz_* sequences.
-  // Returns CURLE_OK on success, the underlying curl code otherwise.
-  // `crash_size_on_failure` is recorded into crash_input_size if the
-  // send fails for a non-timeout reason.
-  CURLcode sendQueryAndAccount(CURL *curl, const std::string &query,
+  // Send the user queries plus the column-filter queries for the current
+  // mutation through the QueryDispatcher and wait for all of them;
+  // encapsulates the per-query bookkeeping (execs++, timeout-kills-target,
+  // crash-size capture) shared by the three fuzz_* sequences.
+  // Returns 0 on success, -1 if a query failed and -2 if the target timed
+  // out (it is killed). `crash_size_on_failure` is recorded into
+  // crash_input_size on either failure.
+  int8_t sendQueriesAndAccount(CURL *curl,
+                               const std::vector<std::string> &queries,
                                const std::string &db_url, size_t &execs,
                                size_t crash_size_on_failure);
+
+  // Sequence 2 resumes at this metadata field after a target restart.
+  size_t _structured_field = 0;
+  size_t _structured_iteration = 0; // iteration number of that sequence 2
+  size_t _metadata_index = 0; // metadata seed picked by the last sequence 1
+  mutation_origin _origin;    // step whose queries are in flight
 };
 } // namespace fuzzberg
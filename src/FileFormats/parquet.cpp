@@ -19,28 +19,70 @@
 
 */
 
-// Fuzz Parquet as follows:
+// Fuzz Parquet as follows, one of these per iteration (--parquet-modes):
+// blob:
 // 1. Retain the Parquet file format (header, footer, file metadata..)
 // 2. Mutate only the data pages using Radamsa
 // 3. Re-generate a valid Parquet file format with mutated data pages
+// footer:
+// 1. Retain the magic and data pages
+// 2. Decode the FileMetaData (Thrift compact) and edit typed fields: row
+//    counts, page offsets, statistics, encodings, schema elements
+// 3. Re-encode it and write the new footer length, so the reader gets
+//    past the magic / length checks into its planning and pruning code
+// pages:
+// 1. Walk the PageHeaders of every column chunk (indexed once per seed)
+// 2. Mutate the payloads of one to three pages using Radamsa, SNAPPY and
+//    GZIP pages decompressed first and recompressed after (PageCodec)
+// 3. Rewrite their headers' page sizes, and the offsets and sizes in the
+//    footer that the new lengths moved, so the reader gets to the values
+// With --parquet-scale the seeds are set aside: every iteration writes a
+// synthesized file of up to the given size (ParquetScale) and records how
+// long the target took to read it and how much memory that took.
 
 #include "parquet.h"
 
+#include <chrono>
+#include <cstring>
+#include <string>
+
+#include "PageCodec.h"
+#include "ParquetEncoding.h"
+
 namespace fuzzberg {
+namespace {
+constexpr mode_name kModeNames[] = {
+    {"blob", kParquetBlob},
+    {"footer", kParquetFooter},
+    {"pages", kParquetPages},
+};
+
+// Write `footer`, its length and the closing magic at `at`; returns the
+// bytes written.
+size_t write_footer(char *at, const std::string &footer) {
+  memcpy(at, footer.data(), footer.size());
+  unsigned char *length = reinterpret_cast<unsigned char *>(at) + footer.size();
+  for (int i = 0; i < 4; ++i) {
+    length[i] = static_cast<unsigned char>(footer.size() >> (8 * i));
+  }
+  memcpy(length + 4, kParquetMagic, 4);
+  return footer.size() + 8;
+}
+} // namespace
+
+bool parse_parquet_modes(const std::string &list, unsigned &modes) {
+  return parse_mode_list(list, kModeNames, modes);
+}
+
+std::string parquet_modes_name(unsigned modes) {
+  return mode_list_name(modes, kModeNames);
+}
+
 ParquetFuzzer::ParquetFuzzer(pid_t target_pid,
                              std::string &fuzzer_mutation_path) {
   std::cout << "Entered Parquet fuzzer: " << fuzzer_mutation_path << std::endl;
 
-  mutated_file_ptr =
-      std::fopen((fuzzer_mutation_path + "/fuzz.parquet").c_str(), "wb");
-
-  if (!mutated_file_ptr) {
-    std::cerr << "Could not create or open file for writing mutations: "
-              << fuzzer_mutation_path << std::endl;
-    perror("fopen");
-    kill(target_pid, SIGKILL);
-    exit(1);
-  }
+  mutated_file_path = fuzzer_mutation_path + "/fuzz.parquet";
   this->_target_pid = target_pid;
   radamsa_init();
 }
@@ -49,123 +91,415 @@ int8_t ParquetFuzzer::Fuzz(std::vector<std::string> &queries,
                            std::string &db_url, corpus_buffer &input_corpus,
                            char *&radamsa_buffer, size_t &execs, CURL *curl) {
 
-  srand(seed_generator());
-
+  // Synthesized files draw nothing from the corpus: it may be empty.
+  if (scale_bytes) {
+    return fuzz_scale(queries, db_url, input_corpus, radamsa_buffer, execs,
+                      curl);
+  }
   if (input_corpus.empty()) {
     std::cerr << "parquet fuzzer: input corpus is empty; aborting round\n";
     return -1;
   }
+  // before the mutator pool forks, so every mutator inherits the index
+  // and sizes its cells for the largest seed
+  fit_capacity(input_corpus);
+  index_corpus(input_corpus);
+  if (_mutable.empty()) {
+    std::cerr << "parquet fuzzer: no seed fits a " << mutation_capacity()
+              << "-byte mutation buffer; aborting round\n";
+    return -1;
+  }
+
+  // --batch: K files per query round instead of the A/B slots
+  if (batch > 1 && !replay && !coverage) {
+    return fuzz_batches(mutated_file_path, queries, db_url, input_corpus,
+                        radamsa_buffer, execs, curl);
+  }
 
-  char *data_pages = nullptr;
-  char *footer_length_field = nullptr;
-  char *file_metadata_start = nullptr;
-  char *page_start = nullptr;
-  uint32_t meta_size = 0;
+  // First round only: a round resumed after a target restart keeps the
+  // slots and iteration counter of the previous one.
+  if (_slots.empty()) {
+    open_mutation_slots(mutated_file_path, queries, radamsa_buffer);
+    start_mutators(input_corpus);
+  }
+  auto &queue = dispatcher(curl, db_url);
 
   while (1) {
-  rand:
-    uint64_t rand_ = rand() % input_corpus.size();
-
-    // Retain Parquet file format (excluding pages),
-    // and mutate only Pages as per Parquet spec
-    // (https://github.com/apache/parquet-format/tree/master?tab=readme-ov-file#file-format)
-
-    if (input_corpus[rand_].size <
-        12) { // 4 * 2 magic bytes + 4 bytes of metadata size field
-      std::cout
-          << "Selected corpus is too small to contain valid Parquet data.\n"
-          << std::endl;
-      goto rand; // Pick a new random corpus
-    }
-
-    // Page header metadata starts after the first 4 magic bytes
-    page_start = input_corpus[rand_].corpus + 4;
-
-    // Locate footer length field (4 bytes before the last 4 magic bytes)
-    footer_length_field =
-        input_corpus[rand_].corpus + input_corpus[rand_].size - 8;
-
-    // Read 4 bytes (little endian) from footer length to get file metadata size
-    meta_size = 0;
-    meta_size |= static_cast<unsigned char>(footer_length_field[0]);
-    meta_size |= static_cast<unsigned char>(footer_length_field[1]) << 8;
-    meta_size |= static_cast<unsigned char>(footer_length_field[2]) << 16;
-    meta_size |= static_cast<unsigned char>(footer_length_field[3]) << 24;
-
-    // check for invalid file metadata sizes to avoid bad allocations
-    // 1. metadata size should be positive
-    // 2. metadata size should be < total file size - 12 (4 * 2 magic bytes + 4
-    // bytes of metadata size field)
-    // 3. RADAMSA_BUFFER_SIZE should be > metadata size + 12
-    if (meta_size <= 0 || meta_size > input_corpus[rand_].size - 12 ||
-        meta_size > (RADAMSA_BUFFER_SIZE - 12)) {
-      // std::cout << "Invalid metadata size: " << meta_size << "\n" <<
-      // std::endl;
-      goto rand; // Pick a new random corpus
-    }
-
-    // Start address of file metadata
-    file_metadata_start = footer_length_field - meta_size;
-    // one last boundary check, although meta_size has been validated above
-    if (file_metadata_start < input_corpus[rand_].corpus + 4) {
-      goto rand; // Pick a new random corpus
-    }
-
-    // There should be at least 1 byte of page data that we can mutate
-    if (file_metadata_start - page_start > 0) {
-      data_pages = new char[file_metadata_start - page_start];
-      if (!data_pages) {
-        std::cout << "Memory allocation failed\n" << std::endl;
-        goto rand;
-      }
-    } else {
-      goto rand;
-    }
-    // copy only the data pages into buffer for Radamsa mutation
-    std::memcpy(data_pages, page_start, file_metadata_start - page_start);
-
-    // We trust Radamsa to keep output_size <= RADAMSA_BUFFER_SIZE - (meta_size
-    // + 12)
-    auto output_size =
-        radamsa(reinterpret_cast<uint8_t *>(data_pages),
-                file_metadata_start - page_start,
-                reinterpret_cast<uint8_t *>(radamsa_buffer) + 4,
-                RADAMSA_BUFFER_SIZE - (meta_size + 12), seed_generator());
-
-    // recreate Parquet format with Radamsa mutations
-    memcpy(radamsa_buffer, "PAR1", 4);
-    memcpy(radamsa_buffer + 4 + output_size, file_metadata_start, meta_size);
-    memcpy(radamsa_buffer + 4 + output_size + meta_size, footer_length_field,
-           4);
-    memcpy(radamsa_buffer + 4 + output_size + meta_size + 4, "PAR1", 4);
-
-    write_radamsa_mutation(radamsa_buffer, mutated_file_ptr,
-                           4 + output_size + meta_size + 4 + 4);
-
-    // send query
+    const size_t iteration = replay ? replay->iteration : _iteration++;
+    auto &slot = _slots[iteration % _slots.size()];
+    // The target may still be reading this slot's file: reap its queries
+    // before overwriting it. Other slots keep running meanwhile.
+    auto ret_code = queue.wait_slot(slot.id);
+    if (ret_code != CURLE_OK) {
+      return slot_failed(slot, ret_code, radamsa_buffer);
+    }
+    // every query for the slot's previous mutation has completed
+    collect_coverage(slot.buffer, slot.size, input_corpus, ".parquet");
+    slot.origin = {iteration, 0, 0, input_corpus.size(), 0};
+    next_mutation(iteration, input_corpus, slot);
+
+    publish_mutation(slot);
+
+    // send queries (completed asynchronously, see QueryDispatcher)
+    reset_coverage();
+    for (auto const &query : slot.queries) {
+      execs++;
+      queue.submit(query, slot.id);
+    }
+    // on the wire before the next mutation is generated
+    queue.progress();
+    if (replay) {
+      return finish_replay(queue, slot, radamsa_buffer);
+    }
+  }
+
+  return 0;
+}
+
+int8_t ParquetFuzzer::fuzz_scale(std::vector<std::string> &queries,
+                                  std::string &db_url,
+                                  const corpus_buffer &input_corpus,
+                                  char *radamsa_buffer, size_t &execs,
+                                  CURL *curl) {
+  if (!_scale) {
+    _scale = std::make_unique<scale_monitor>(replay ? "" : scale_report);
+  }
+  auto &queue = dispatcher(curl, db_url);
+
+  while (1) {
+    const size_t iteration = replay ? replay->iteration : _iteration++;
+    begin_iteration(iteration);
+    const parquet_shape shape = draw_parquet_shape(_rng, scale_bytes);
+    std::cout << "\n[INFO] Synthesizing " << parquet_shape_name(shape)
+              << std::endl;
+    // No staging copy: the queries of the previous file have completed,
+    // so nothing reads this one while it is rewritten in place, and a
+    // multi-GB file is not written twice.
+    const uint64_t bytes = write_parquet(mutated_file_path, shape, _rng);
+    if (!bytes) {
+      std::cerr << "Could not write synthesized Parquet file: "
+                << mutated_file_path << std::endl;
+      perror("write");
+      kill(this->_target_pid, SIGKILL);
+      exit(1);
+    }
+    // The file does not fit radamsa_buffer, so a failure is reported with
+    // its recipe instead; the replay log next to it regenerates the file.
+    const std::string recipe =
+        "parquet-scale: " + parquet_shape_name(shape) + ", " +
+        std::to_string(bytes) + " bytes, iteration " +
+        std::to_string(iteration) +
+        "\nThe file itself is not kept: --replay <this file>.replay.json "
+        "regenerates it.\n";
+    std::memcpy(radamsa_buffer, recipe.data(), recipe.size());
+    crash_input_size = recipe.size();
+    crash_origin = {iteration, 0, 0, input_corpus.size(), 0};
+
+    // One query at a time, so the time and the peak are this file's.
+    reset_peak_memory(this->_target_pid);
+    const process_memory before = read_process_memory(this->_target_pid);
+    const auto start = std::chrono::steady_clock::now();
+    CURLcode ret_code = CURLE_OK;
     for (auto const &query : queries) {
       execs++;
-      std::cout << "\nQuery : " << query << "\n" << std::endl;
-      auto ret_code = send_query(curl, query, db_url, "");
+      queue.submit(query, 0);
+      ret_code = queue.wait_slot(0);
       if (ret_code != CURLE_OK) {
-        if (ret_code == CURLE_OPERATION_TIMEDOUT){
-          std::cerr << "Target timed out, kill child and stop fuzzing"
-                    << std::endl;
-          kill(this->_target_pid, SIGKILL);
-          exit(1);
-        }
-        // save size of the crash file
-        crash_input_size = 4 + output_size + meta_size + 4 + 4;
-        delete[] data_pages;
-        data_pages = nullptr;
-        return -1;
-      } else
-        continue;
-    }
-    memset(radamsa_buffer, 0, output_size);
-    delete[] data_pages;
-  }
+        break;
+      }
+    }
+    if (ret_code != CURLE_OK) {
+      std::cout << "\n[INFO] The " << bytes << "-byte file is kept in: "
+                << mutated_file_path << " (--replay regenerates it)"
+                << std::endl;
+      if (ret_code == CURLE_OPERATION_TIMEDOUT) {
+        std::cerr << "Target timed out, killing child" << std::endl;
+        kill(this->_target_pid, SIGKILL);
+        return -2;
+      }
+      return -1;
+    }
 
+    scale_sample sample;
+    sample.profile = shape.profile;
+    sample.iteration = iteration;
+    sample.bytes = bytes;
+    sample.millis = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+    const process_memory after = read_process_memory(this->_target_pid);
+    sample.memory_kb =
+        after.peak_kb > before.rss_kb ? after.peak_kb - before.rss_kb : 0;
+    const std::string grew = _scale->record(sample, shape);
+    std::cout << "[INFO] " << bytes << " bytes read in " << sample.millis
+              << " ms, peak RSS +" << sample.memory_kb << " KiB" << std::endl;
+    if (!grew.empty()) {
+      std::cout << "\033[1;33m[!] Super-linear " << grew << " at iteration "
+                << iteration << " (" << parquet_shape_name(shape) << ")\033[0m"
+                << std::endl;
+    }
+    if (replay) {
+      return 0;
+    }
+  }
   return 0;
 }
+
+void ParquetFuzzer::index_corpus(const corpus_buffer &corpus) {
+  for (size_t i = _layouts.size(); i < corpus.size(); ++i) {
+    parquet_layout layout;
+    // Seeds were validated on load; entries --coverage adds keep their
+    // seed's footer, but check anyway. The footer is copied, not mutated,
+    // so it has to leave room for page data in the buffer (only a seed
+    // past the format's maximum can fail that).
+    const char *data = seed(corpus[i]);
+    if (parse_parquet_layout(data, corpus[i].size, layout) &&
+        layout.footer_size + 12 < mutation_capacity()) {
+      _mutable.push_back(i);
+    }
+    _layouts.push_back(layout);
+    // Seeds whose pages do not index get blob mutations in pages mode.
+    _pages.emplace_back();
+    if ((modes & kParquetPages) && layout.footer_size &&
+        !index_parquet_pages(data, layout, _pages.back())) {
+      _pages.back().clear();
+    }
+  }
+}
+
+size_t ParquetFuzzer::mutate(uint64_t iteration, const corpus_buffer &corpus,
+                             char *out, size_t capacity, mutation_tail *tail) {
+  // every random choice below comes from (master_seed, iteration)
+  begin_iteration(iteration);
+  index_corpus(corpus);
+  if (_mutable.empty()) {
+    return 0;
+  }
+
+  // With a single mode enabled nothing is drawn for it, so a blob-only
+  // session mutates exactly as before modes existed.
+  unsigned enabled[std::size(kModeNames)];
+  size_t enabled_count = 0;
+  for (const auto &[name, bit] : kModeNames) {
+    if (modes & bit) {
+      enabled[enabled_count++] = bit;
+    }
+  }
+  unsigned mode = enabled_count ? enabled[0] : kParquetBlob;
+  if (enabled_count > 1) {
+    mode = enabled[_rng.below(enabled_count)];
+  }
+
+  const size_t rand_ = _mutable[_rng.below(_mutable.size())];
+  const parquet_layout &layout = _layouts[rand_];
+  const char *data = seed(corpus[rand_]);
+
+  // Seeds whose footer does not decode (or grows past the buffer) get a
+  // blob mutation instead.
+  if (mode == kParquetFooter) {
+    const size_t size = mutate_metadata(data, layout, out, capacity);
+    if (size) {
+      return size;
+    }
+  } else if (mode == kParquetPages) {
+    const size_t size = mutate_pages(data, rand_, out, capacity);
+    if (size) {
+      return size;
+    }
+  }
+
+  // Retain Parquet file format (excluding pages), and mutate only Pages as
+  // per Parquet spec: radamsa reads the seed's page region in place. Room
+  // for the footer is still left in `out`: crash reports hold the whole
+  // file in one buffer of the same size.
+  const size_t trailer = layout.footer_size + 8; // metadata, length, magic
+  auto output_size = radamsa(
+      reinterpret_cast<uint8_t *>(const_cast<char *>(data) +
+                                  layout.pages_offset),
+      layout.pages_size, reinterpret_cast<uint8_t *>(out) + 4,
+      capacity - (trailer + 4), _rng.seed32());
+
+  // recreate Parquet format with Radamsa mutations. The footer of a seed
+  // held inflated in memory (heap or corpus pack) is written from there;
+  // an inflated copy of a compressed seed may be evicted, so copy that one.
+  memcpy(out, kParquetMagic, 4);
+  if (tail && corpus[rand_].stored == 0) {
+    *tail = {data + layout.footer_offset, trailer};
+    return 4 + output_size;
+  }
+  memcpy(out + 4 + output_size, data + layout.footer_offset, trailer);
+  return 4 + output_size + trailer;
+}
+
+size_t ParquetFuzzer::mutate_metadata(const char *data,
+                                      const parquet_layout &layout, char *out,
+                                      size_t capacity) {
+  thrift_value meta;
+  if (thrift_decode_struct(data + layout.footer_offset, layout.footer_size,
+                           meta) == 0) {
+    return 0;
+  }
+  mutate_footer(meta, _rng, layout.footer_offset + layout.footer_size + 8);
+  std::string footer;
+  thrift_encode_struct(meta, footer);
+
+  const size_t size = layout.footer_offset + footer.size() + 8;
+  if (size > capacity || footer.size() > UINT32_MAX) {
+    return 0;
+  }
+  // magic and pages as they are, then the new footer with its length
+  memcpy(out, data, layout.footer_offset);
+  write_footer(out + layout.footer_offset, footer);
+  return size;
+}
+
+size_t ParquetFuzzer::mutate_pages(const char *data, size_t index, char *out,
+                                   size_t capacity) {
+  const parquet_layout &layout = _layouts[index];
+  const std::vector<parquet_page> &pages = _pages[index];
+  thrift_value meta;
+  if (pages.empty() || thrift_decode_struct(data + layout.footer_offset,
+                                            layout.footer_size, meta) == 0) {
+    return 0;
+  }
+  // One to three pages, mutated in file order
+  std::vector<size_t> picks(1 + _rng.below(std::min<size_t>(3, pages.size())));
+  for (auto &pick : picks) {
+    pick = _rng.below(pages.size());
+  }
+  std::sort(picks.begin(), picks.end());
+  picks.erase(std::unique(picks.begin(), picks.end()), picks.end());
+
+  // The payloads go to scratch first: where they land in `out` depends on
+  // the size of the headers before them. Together they may grow by what
+  // the buffer has left after the seed, less some slack for headers and
+  // footer offsets whose varints get longer.
+  const size_t file_size = layout.footer_offset + layout.footer_size + 8;
+  const size_t slack = 64 * (picks.size() + 1);
+  if (file_size + slack >= capacity) {
+    return 0;
+  }
+  size_t room = capacity - file_size - slack;
+  _payloads.grow(capacity);
+
+  std::vector<page_edit> edits;
+  std::vector<std::string> headers;
+  std::vector<size_t> payload_sizes;
+  size_t used = 0;
+  for (size_t pick : picks) {
+    const parquet_page &page = pages[pick];
+    if (page.payload_size == 0) {
+      continue;
+    }
+    char *payload = _payloads.data() + used;
+    size_t uncompressed = 0;
+    const size_t size = mutate_page(data, page, payload,
+                                    page.payload_size + room, uncompressed);
+    if (size == SIZE_MAX) {
+      continue;
+    }
+    room -= std::min(room, size - std::min<size_t>(size, page.payload_size));
+    headers.emplace_back();
+    rewrite_page_header(data, page, payload, size, uncompressed,
+                        headers.back());
+    const int64_t header_delta =
+        static_cast<int64_t>(headers.back().size()) - page.header_size;
+    edits.push_back(
+        {&page,
+         header_delta + static_cast<int64_t>(size) - page.payload_size,
+         header_delta + static_cast<int64_t>(uncompressed) -
+             page.uncompressed_size});
+    payload_sizes.push_back(size);
+    used += size;
+  }
+  if (edits.empty()) {
+    return 0;
+  }
+  relocate_footer(meta, edits);
+  std::string footer;
+  thrift_encode_struct(meta, footer);
+
+  int64_t size = static_cast<int64_t>(layout.footer_offset + footer.size() + 8);
+  for (const auto &edit : edits) {
+    size += edit.delta;
+  }
+  if (static_cast<size_t>(size) > capacity || footer.size() > UINT32_MAX) {
+    return 0;
+  }
+  // the seed up to each edited page, then its new header and payload
+  char *at = out;
+  const char *payload = _payloads.data();
+  size_t pos = 0;
+  for (size_t i = 0; i < edits.size(); ++i) {
+    const parquet_page &page = *edits[i].page;
+    memcpy(at, data + pos, page.header_offset - pos);
+    at += page.header_offset - pos;
+    memcpy(at, headers[i].data(), headers[i].size());
+    at += headers[i].size();
+    memcpy(at, payload, payload_sizes[i]);
+    at += payload_sizes[i];
+    payload += payload_sizes[i];
+    pos = page.header_offset + page.header_size + page.payload_size;
+  }
+  memcpy(at, data + pos, layout.footer_offset - pos);
+  at += layout.footer_offset - pos;
+  at += write_footer(at, footer);
+  return at - out;
+}
+
+size_t ParquetFuzzer::mutate_page(const char *data, const parquet_page &page,
+                                  char *payload, size_t capacity,
+                                  size_t &uncompressed) {
+  const char *stored = data + page.header_offset + page.header_size;
+  const unsigned int radamsa_seed = _rng.seed32();
+  // half the time a structural edit, if the page's encoding allows one
+  const bool structured = _rng.below(2) == 0;
+
+  // The values are mutated as plaintext: compressed ones are inflated
+  // first and recompressed after, so the target's decompressor accepts
+  // the page and its value and level decoders get the mutation. v2 levels
+  // are copied as they are.
+  const int64_t codec =
+      page.compressed ? page.codec : parquet::kCodecUncompressed;
+  const size_t values = page.payload_size - page.levels_size;
+  const size_t plain_size = page.compressed
+                                ? page.uncompressed_size - page.levels_size
+                                : values;
+  if (page_codec_supported(codec) && page.uncompressed_size > page.levels_size &&
+      plain_size <= capacity &&
+      page_decompress(codec, stored + page.levels_size, values, plain_size,
+                      _plain)) {
+    const char *mutated;
+    size_t size;
+    if (structured && mutate_page_values(_plain, page, _rng)) {
+      mutated = _plain.data();
+      size = _plain.size();
+    } else {
+      _mutated.grow(capacity);
+      size = radamsa(reinterpret_cast<uint8_t *>(_plain.data()), _plain.size(),
+                     reinterpret_cast<uint8_t *>(_mutated.data()),
+                     capacity - page.levels_size, radamsa_seed);
+      mutated = _mutated.data();
+    }
+    if (!page_compress(codec, mutated, size, _packed) ||
+        page.levels_size + _packed.size() > capacity) {
+      return SIZE_MAX;
+    }
+    memcpy(payload, stored, page.levels_size);
+    memcpy(payload + page.levels_size, _packed.data(), _packed.size());
+    uncompressed = page.levels_size + size;
+    return page.levels_size + _packed.size();
+  }
+
+  // Codecs without an implementation here (ZSTD, LZ4, BROTLI, LZO) are
+  // mutated as stored. Their payloads then keep their declared size:
+  // radamsa's output is no longer a valid stream anyway, and the reader
+  // finds that out when it inflates it.
+  const size_t size =
+      radamsa(reinterpret_cast<uint8_t *>(const_cast<char *>(stored)),
+              page.payload_size, reinterpret_cast<uint8_t *>(payload),
+              capacity, radamsa_seed);
+  uncompressed = page.compressed ? page.uncompressed_size : size;
+  return size;
+}
 } // namespace fuzzberg
@@ -24,17 +24,93 @@
 #include <iostream>
 
 #include "FileFuzzerBase.h"
+#include "ParquetIndex.h"
+#include "ParquetMetadata.h"
+#include "ParquetScale.h"
 
 namespace fuzzberg {
 
+// --parquet-modes: the mutations ParquetFuzzer draws from, one per
+// iteration. blob runs radamsa over everything between the magic and the
+// footer; footer decodes the seed's FileMetaData and edits typed fields;
+// pages runs radamsa over single page payloads and keeps page headers and
+// footer consistent with the new sizes.
+enum parquet_mode : unsigned {
+  kParquetBlob = 1u << 0,
+  kParquetFooter = 1u << 1,
+  kParquetPages = 1u << 2,
+};
+constexpr unsigned kParquetDefaultModes =
+    kParquetBlob | kParquetFooter | kParquetPages;
+
+// "blob,footer,pages" to a mode mask; false on an unknown name or an empty
+// list.
+bool parse_parquet_modes(const std::string &list, unsigned &modes);
+// And back, for the replay log.
+std::string parquet_modes_name(unsigned modes);
+
 class ParquetFuzzer : public FileFuzzerBase {
 public:
   ParquetFuzzer(pid_t target_pid, std::string &fuzzer_mutation_path);
   ~ParquetFuzzer() = default;
 
-  FILE *mutated_file_ptr = nullptr;
+  std::string mutated_file_path;
   int8_t Fuzz(std::vector<std::string> &queries, std::string &db_url,
               corpus_buffer &input_corpus, char *&radamsa_buffer, size_t &execs,
               CURL *curl) override;
+  size_t mutate(uint64_t iteration, const corpus_buffer &corpus, char *out,
+                size_t capacity, mutation_tail *tail) override;
+
+  unsigned modes = kParquetDefaultModes; // parquet_mode bits
+  // --parquet-scale: synthesize files of up to this many bytes instead of
+  // mutating seeds (0 = off), and append what each cost the target to
+  // `scale_report` (none if empty).
+  uint64_t scale_bytes = 0;
+  std::string scale_report;
+
+protected:
+  // Whole files, up to the reservation; pages mode spends the room past
+  // the seed on growing payloads.
+  buffer_policy mutation_policy() const override {
+    return {kMinMutationBytes, 2, size_t{64} << 10, kMaxMutationBytes};
+  }
+
+private:
+  // The --parquet-scale loop: one synthesized file per iteration, its
+  // queries run one at a time so their latency and the target's peak RSS
+  // belong to that file alone.
+  int8_t fuzz_scale(std::vector<std::string> &queries, std::string &db_url,
+                    const corpus_buffer &input_corpus, char *radamsa_buffer,
+                    size_t &execs, CURL *curl);
+
+  // The seed's pages as they are, then its FileMetaData mutated and
+  // re-encoded under a matching length field. 0 if the footer does not
+  // decode or the result does not fit `capacity`.
+  size_t mutate_metadata(const char *data, const parquet_layout &layout,
+                         char *out, size_t capacity);
+  // Corpus entry `index` with a few page payloads mutated, their headers
+  // and the footer rewritten to match. 0 if the seed has no page index or
+  // the result does not fit `capacity`.
+  size_t mutate_pages(const char *data, size_t index, char *out,
+                      size_t capacity);
+  // Mutate one page payload into `payload` (at most `capacity` bytes):
+  // through its codec when it is compressed with one PageCodec supports,
+  // as stored otherwise. Returns the payload size and sets `uncompressed`
+  // to its size decompressed; SIZE_MAX if it was dropped.
+  size_t mutate_page(const char *data, const parquet_page &page,
+                     char *payload, size_t capacity, size_t &uncompressed);
+
+  // Index the corpus entries added since the last call (all of them the
+  // first time, then whatever --coverage appended).
+  void index_corpus(const corpus_buffer &corpus);
+
+  std::vector<parquet_layout> _layouts; // one per corpus entry
+  std::vector<size_t> _mutable; // entries whose layout fits a slot buffer
+  // pages mode: every entry's pages, empty if they did not index
+  std::vector<std::vector<parquet_page>> _pages;
+  MutationBuffer _payloads;    // mutated page payloads, before assembly
+  std::string _plain, _packed; // page values decompressed / recompressed
+  MutationBuffer _mutated;     // mutated plaintext
+  std::unique_ptr<scale_monitor> _scale;
 };
 } // namespace fuzzberg
@@ -0,0 +1,68 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+// Coverage shim for FuzzBerg's --coverage mode. Compile it into the target
+// next to code built with -fsanitize-coverage=trace-pc-guard:
+//
+//   clang -O2 -c src/Runtime/coverage-shim.c -o coverage-shim.o
+//
+// Each instrumented edge gets a slot in the fuzzer's shared-memory map
+// (its id is passed in FUZZBERG_SHM_ID) and bumps it when executed. Without
+// the variable the counters go to a private dummy map, so an instrumented
+// target still runs outside the fuzzer.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/shm.h>
+
+// Must match kCoverageMapSize in src/Session/Coverage.h
+#define FUZZBERG_MAP_SIZE (1 << 16)
+
+static uint8_t fuzzberg_dummy_map[FUZZBERG_MAP_SIZE];
+static uint8_t *fuzzberg_map = fuzzberg_dummy_map;
+static uint32_t fuzzberg_next_guard = 1;
+
+static void fuzzberg_attach(void) {
+  const char *id = getenv("FUZZBERG_SHM_ID");
+  if (!id || fuzzberg_map != fuzzberg_dummy_map)
+    return;
+  void *mem = shmat(atoi(id), NULL, 0);
+  if (mem != (void *)-1)
+    fuzzberg_map = (uint8_t *)mem;
+}
+
+// Called once per instrumented module (the main binary and every shared
+// library) before any guard fires.
+void __sanitizer_cov_trace_pc_guard_init(uint32_t *start, uint32_t *stop) {
+  if (start == stop || *start)
+    return; // empty module, or already initialized
+  fuzzberg_attach();
+  // Guard 0 would disable the edge; with more edges than slots they wrap
+  // and share.
+  for (uint32_t *guard = start; guard < stop; ++guard)
+    *guard = 1 + (fuzzberg_next_guard++ % (FUZZBERG_MAP_SIZE - 1));
+}
+
+// Hot path: one byte per edge, no atomics. Racing threads may lose a count,
+// which only affects the hit-count buckets.
+void __sanitizer_cov_trace_pc_guard(uint32_t *guard) {
+  fuzzberg_map[*guard]++;
+}
@@ -0,0 +1,192 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#include "CorpusPack.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace fuzzberg {
+
+namespace {
+
+constexpr uint32_t kPackVersion = 1;
+constexpr size_t kPackAlign = 64;
+
+void write_all(FILE *fp, const void *data, size_t size, const std::string &out) {
+  if (size && std::fwrite(data, 1, size, fp) != size) {
+    std::cerr << "Could not write corpus pack: " << out << std::endl;
+    perror("fwrite");
+    exit(1);
+  }
+}
+
+void pad_to(FILE *fp, uint64_t &offset, size_t align, const std::string &out) {
+  static const char zeros[kPackAlign] = {};
+  size_t pad = (align - offset % align) % align;
+  write_all(fp, zeros, pad, out);
+  offset += pad;
+}
+
+[[noreturn]] void invalid_pack(const std::string &path, const char *why) {
+  std::cerr << "Invalid corpus pack " << path << ": " << why << std::endl;
+  exit(1);
+}
+
+} // namespace
+
+size_t write_corpus_pack(const std::string &out, nlohmann::json info,
+                         const std::vector<pack_source> &sources,
+                         std::vector<corpus_stat> entries) {
+  // Written under a temporary name, so a fuzzer never maps half a pack.
+  const std::string tmp = out + ".tmp";
+  FILE *fp = std::fopen(tmp.c_str(), "wb");
+  if (!fp) {
+    std::cerr << "Could not create corpus pack: " << tmp << std::endl;
+    perror("fopen");
+    exit(1);
+  }
+
+  pack_header header = {};
+  std::memcpy(header.magic, kPackMagic, sizeof(kPackMagic));
+  header.version = kPackVersion;
+  write_all(fp, &header, sizeof(header), out);
+  uint64_t offset = sizeof(header);
+
+  std::vector<pack_entry> index;
+  info["paths"] = nlohmann::json::array();
+  for (size_t i = 0; i < sources.size(); ++i) {
+    const auto &source = sources[i];
+    corpus_stat stat = entries[i];
+    if (stat.corpus == nullptr || stat.size == 0) {
+      delete[] stat.corpus;
+      continue;
+    }
+    pad_to(fp, offset, kPackAlign, out);
+    index.push_back({offset, stat.size, source.kind, 0});
+    write_all(fp, stat.corpus, stat.size, out);
+    write_all(fp, "", 1, out); // NUL: JSON entries are parsed as C strings
+    offset += stat.size + 1;
+    delete[] stat.corpus;
+    info["paths"].push_back(source.path.string());
+  }
+
+  pad_to(fp, offset, alignof(pack_entry), out);
+  header.count = static_cast<uint32_t>(index.size());
+  header.index_offset = offset;
+  write_all(fp, index.data(), index.size() * sizeof(pack_entry), out);
+  offset += index.size() * sizeof(pack_entry);
+
+  const std::string dumped = info.dump();
+  header.info_offset = offset;
+  header.info_size = dumped.size();
+  write_all(fp, dumped.data(), dumped.size(), out);
+
+  std::rewind(fp);
+  write_all(fp, &header, sizeof(header), out);
+  if (std::fclose(fp) != 0 || std::rename(tmp.c_str(), out.c_str()) != 0) {
+    std::cerr << "Could not finish corpus pack: " << out << std::endl;
+    perror("rename");
+    exit(1);
+  }
+  return index.size();
+}
+
+bool CorpusPack::is_pack(const std::string &path) {
+  std::error_code ec;
+  if (!std::filesystem::is_regular_file(path, ec))
+    return false;
+  char magic[sizeof(kPackMagic)] = {};
+  FILE *fp = std::fopen(path.c_str(), "rb");
+  if (!fp)
+    return false;
+  size_t n = std::fread(magic, 1, sizeof(magic), fp);
+  std::fclose(fp);
+  return n == sizeof(magic) &&
+         std::memcmp(magic, kPackMagic, sizeof(magic)) == 0;
+}
+
+CorpusPack::CorpusPack(const std::string &path) : _path(path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    std::cerr << "Could not open corpus pack: " << path << std::endl;
+    perror("open");
+    exit(1);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(pack_header)) {
+    close(fd);
+    invalid_pack(path, "truncated header");
+  }
+  _length = static_cast<size_t>(st.st_size);
+  void *mem = mmap(nullptr, _length, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd); // the mapping keeps the file
+  if (mem == MAP_FAILED) {
+    perror("mmap");
+    exit(1);
+  }
+  _base = static_cast<const char *>(mem);
+
+  pack_header header;
+  std::memcpy(&header, _base, sizeof(header));
+  if (std::memcmp(header.magic, kPackMagic, sizeof(kPackMagic)) != 0)
+    invalid_pack(path, "bad magic");
+  if (header.version != kPackVersion)
+    invalid_pack(path, "unsupported version, re-run fuzzberg pack");
+  if (header.index_offset > _length ||
+      header.count > (_length - header.index_offset) / sizeof(pack_entry) ||
+      header.info_offset > _length ||
+      header.info_size > _length - header.info_offset)
+    invalid_pack(path, "index out of bounds");
+  _index = reinterpret_cast<const pack_entry *>(_base + header.index_offset);
+  _count = header.count;
+  for (size_t i = 0; i < _count; ++i) {
+    if (_index[i].offset > header.index_offset ||
+        _index[i].size >= header.index_offset - _index[i].offset)
+      invalid_pack(path, "entry out of bounds");
+  }
+  _info = nlohmann::json::parse(_base + header.info_offset,
+                                _base + header.info_offset + header.info_size,
+                                nullptr, false);
+  if (!_info.is_object())
+    invalid_pack(path, "bad description");
+}
+
+CorpusPack::~CorpusPack() {
+  if (_base)
+    munmap(const_cast<char *>(_base), _length);
+}
+
+corpus_stat CorpusPack::entry(size_t i) const {
+  // radamsa() and the Iceberg fuzzer take char *, but only read from it;
+  // the mapping is PROT_READ, so a stray write faults instead of
+  // corrupting the shared corpus.
+  return {_index[i].size, const_cast<char *>(_base + _index[i].offset), false};
+}
+
+} // namespace fuzzberg
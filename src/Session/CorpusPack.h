@@ -0,0 +1,110 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#pragma once
+
+#include <FileFormats/FileFuzzerBase.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+// Packed corpus (`fuzzberg pack`). A corpus directory is loaded once into a
+// single file: every entry (Iceberg metadata checked and without its logs,
+// but with its locations as they were) is stored back to back,
+// NUL-terminated and 64-byte aligned, behind an index of offsets, sizes and
+// kinds. Loading it is an mmap: corpus entries become read-only views into
+// the page cache, shared by every worker and fuzzer on the box instead of
+// being read into each process's heap. Only Iceberg metadata is copied on
+// load, to point it at the session's table.
+//
+// Layout: pack_header | entries ... | pack_entry[count] | JSON description
+// (format, checked at load time, and source paths).
+
+namespace fuzzberg {
+
+constexpr char kPackMagic[8] = {'F', 'Z', 'P', 'A', 'C', 'K', '0', '1'};
+
+enum class pack_kind : uint32_t {
+  input = 0,    // CSV / Parquet file
+  metadata = 1, // Iceberg metadata JSON
+  manifest = 2, // Iceberg manifest list
+};
+
+struct pack_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t count;         // entries in the index
+  uint64_t index_offset;  // pack_entry[count]
+  uint64_t info_offset;   // JSON description
+  uint64_t info_size;
+};
+
+struct pack_entry {
+  uint64_t offset;
+  uint64_t size; // without the trailing NUL
+  pack_kind kind;
+  uint32_t reserved;
+};
+
+struct pack_source {
+  pack_kind kind;
+  std::filesystem::path path;
+};
+
+// Write `sources` to `out`; `entries[i]` is sources[i] as load_corpus()
+// returned it ({0, nullptr} to skip it) and is freed here. `info` is stored
+// as the description, plus the list of packed paths. Returns the number of
+// entries written; exits on I/O errors.
+size_t write_corpus_pack(const std::string &out, nlohmann::json info,
+                         const std::vector<pack_source> &sources,
+                         std::vector<corpus_stat> entries);
+
+class CorpusPack {
+public:
+  // Whether `path` is a regular file starting with the pack magic.
+  static bool is_pack(const std::string &path);
+
+  // Map `path` read-only; exits if it isn't a valid pack.
+  explicit CorpusPack(const std::string &path);
+  ~CorpusPack();
+
+  CorpusPack(const CorpusPack &) = delete;
+  CorpusPack &operator=(const CorpusPack &) = delete;
+
+  const nlohmann::json &info() const { return _info; }
+  size_t size() const { return _count; }
+  pack_kind kind(size_t i) const { return _index[i].kind; }
+  // A view into the mapping (owned = false), valid while the pack lives.
+  corpus_stat entry(size_t i) const;
+
+private:
+  std::string _path;
+  const char *_base = nullptr;
+  size_t _length = 0;
+  const pack_entry *_index = nullptr;
+  size_t _count = 0;
+  nlohmann::json _info;
+};
+
+} // namespace fuzzberg
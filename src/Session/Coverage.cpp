@@ -0,0 +1,170 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#include "Coverage.h"
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace fuzzberg {
+
+namespace {
+
+// Hit counts are compared in buckets (1, 2, 3, 4-7, 8-15, 16-31, 32-127,
+// 128+), one bit each, so loop-count jitter doesn't look like progress.
+uint8_t bucket(uint8_t hits) {
+  if (hits == 0)
+    return 0;
+  if (hits <= 3)
+    return static_cast<uint8_t>(1 << (hits - 1));
+  if (hits <= 7)
+    return 8;
+  if (hits <= 15)
+    return 16;
+  if (hits <= 31)
+    return 32;
+  if (hits <= 127)
+    return 64;
+  return 128;
+}
+
+} // namespace
+
+CoverageMap::CoverageMap(std::string queue_dir)
+    : _queue_dir(std::move(queue_dir)) {
+  _shm_id = shmget(IPC_PRIVATE, kCoverageMapSize, IPC_CREAT | IPC_EXCL | 0600);
+  if (_shm_id < 0) {
+    perror("shmget");
+    exit(1);
+  }
+  void *mem = shmat(_shm_id, nullptr, 0);
+  if (mem == reinterpret_cast<void *>(-1)) {
+    perror("shmat");
+    shmctl(_shm_id, IPC_RMID, nullptr);
+    exit(1);
+  }
+  // Marked for removal right away: the segment lives while it is attached
+  // (by us or a target) and can't leak if the fuzzer is killed.
+  shmctl(_shm_id, IPC_RMID, nullptr);
+  _trace = static_cast<uint8_t *>(mem);
+  std::memset(_trace, 0, kCoverageMapSize);
+  std::memset(_virgin, 0xff, kCoverageMapSize);
+
+  setenv(kCoverageShmEnv, std::to_string(_shm_id).c_str(), 1);
+
+  std::error_code ec;
+  std::filesystem::create_directories(_queue_dir, ec);
+  if (ec) {
+    std::cerr << "Could not create queue directory " << _queue_dir << ": "
+              << ec.message() << std::endl;
+    exit(1);
+  }
+  // A resumed session must not overwrite the queue of the previous one.
+  for (const auto &entry :
+       std::filesystem::directory_iterator(_queue_dir, ec)) {
+    size_t id;
+    if (entry.is_regular_file() && queue_entry_id(entry.path(), id) &&
+        id >= _first_id)
+      _first_id = id + 1;
+  }
+}
+
+CoverageMap::~CoverageMap() {
+  if (_trace)
+    shmdt(_trace);
+  unsetenv(kCoverageShmEnv);
+}
+
+void CoverageMap::reset() { std::memset(_trace, 0, kCoverageMapSize); }
+
+int CoverageMap::has_new_bits() {
+  int ret = 0;
+  // Most of the map is zero on any given run: skip it a word at a time.
+  const uint64_t *words = reinterpret_cast<const uint64_t *>(_trace);
+  for (size_t w = 0; w < kCoverageMapSize / sizeof(uint64_t); ++w) {
+    if (!words[w])
+      continue;
+    for (size_t i = w * sizeof(uint64_t); i < (w + 1) * sizeof(uint64_t);
+         ++i) {
+      uint8_t bits = bucket(_trace[i]);
+      if (!(bits & _virgin[i]))
+        continue;
+      if (_virgin[i] == 0xff) {
+        ++_edges;
+        ret = 2;
+      } else if (ret == 0) {
+        ret = 1;
+      }
+      _virgin[i] &= static_cast<uint8_t>(~bits);
+    }
+  }
+  return ret;
+}
+
+uint64_t CoverageMap::trace_digest() const {
+  uint64_t hash = 0xcbf29ce484222325ULL; // FNV-1a over the hit edge indices
+  const uint64_t *words = reinterpret_cast<const uint64_t *>(_trace);
+  for (size_t w = 0; w < kCoverageMapSize / sizeof(uint64_t); ++w) {
+    if (!words[w])
+      continue;
+    for (size_t i = w * sizeof(uint64_t); i < (w + 1) * sizeof(uint64_t);
+         ++i) {
+      if (!_trace[i])
+        continue;
+      for (int shift = 0; shift < 32; shift += 8) {
+        hash ^= (i >> shift) & 0xff;
+        hash *= 0x100000001b3ULL;
+      }
+    }
+  }
+  return hash;
+}
+
+void CoverageMap::save(const char *data, size_t size, const char *ext) {
+  char name[32];
+  snprintf(name, sizeof(name), "id-%06zu", _first_id + _queued++);
+  auto path = std::filesystem::path(_queue_dir) / (name + std::string(ext));
+  FILE *fp = std::fopen(path.c_str(), "wb");
+  if (!fp) {
+    perror("fopen");
+    return;
+  }
+  if (std::fwrite(data, 1, size, fp) != size)
+    std::cerr << "Could not write queue entry " << path << std::endl;
+  std::fclose(fp);
+}
+
+bool queue_entry_id(const std::filesystem::path &path, size_t &id) {
+  const std::string stem = path.stem().string();
+  if (stem.size() <= 3 || stem.compare(0, 3, "id-") != 0 ||
+      stem.find_first_not_of("0123456789", 3) != std::string::npos)
+    return false;
+  id = std::stoull(stem.substr(3));
+  return true;
+}
+
+} // namespace fuzzberg
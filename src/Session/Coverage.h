@@ -0,0 +1,90 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// Coverage feedback (--coverage). The fuzzer owns a SysV shared-memory edge
+// map and exports its id to the target as FUZZBERG_SHM_ID; a target built
+// with -fsanitize-coverage=trace-pc-guard and linked against
+// src/Runtime/coverage-shim.c bumps one byte per edge in it. After each
+// mutation has been queried the map is classified against everything seen
+// so far, and inputs that reached new edges (or new hit-count buckets)
+// are kept as seeds.
+
+namespace fuzzberg {
+
+// Must match FUZZBERG_MAP_SIZE in src/Runtime/coverage-shim.c
+constexpr size_t kCoverageMapSize = 1 << 16;
+constexpr const char *kCoverageShmEnv = "FUZZBERG_SHM_ID";
+
+class CoverageMap {
+public:
+  // Creates the segment and exports its id to the environment, so targets
+  // forked afterwards attach to it. `queue_dir` receives promoted inputs,
+  // numbered on from the entries earlier sessions left in it.
+  explicit CoverageMap(std::string queue_dir);
+  ~CoverageMap();
+
+  CoverageMap(const CoverageMap &) = delete;
+  CoverageMap &operator=(const CoverageMap &) = delete;
+
+  // Clear the trace before the queries of the next input are sent.
+  void reset();
+
+  // Classify the trace of the last input. Returns 2 if it hit an edge never
+  // seen before, 1 if only a known edge moved to a new hit-count bucket,
+  // 0 otherwise.
+  int has_new_bits();
+
+  // Digest of the set of edges the last input hit (hit counts ignored),
+  // without touching the virgin map; --minimize keeps a seed's reduction
+  // only if the digest is unchanged.
+  uint64_t trace_digest() const;
+
+  // Persist a promoted input as <queue_dir>/id-NNNNNN<ext>. Ids are zero
+  // padded so the queue sorts in promotion order.
+  void save(const char *data, size_t size, const char *ext);
+
+  size_t edges() const { return _edges; }   // distinct edges seen so far
+  size_t queued() const { return _queued; } // inputs promoted so far
+  // Id of this session's first entry; the replay log records it so a
+  // replay appends only this session's promotions to the corpus.
+  size_t first_id() const { return _first_id; }
+
+private:
+  int _shm_id = -1;
+  uint8_t *_trace = nullptr;
+  uint8_t _virgin[kCoverageMapSize]; // bits not yet seen, per edge
+  std::string _queue_dir;
+  size_t _edges = 0;
+  size_t _first_id = 0;
+  size_t _queued = 0;
+};
+
+// The id of a queue entry named id-NNNNNN<ext>; false for other files.
+bool queue_entry_id(const std::filesystem::path &path, size_t &id);
+
+} // namespace fuzzberg
@@ -0,0 +1,420 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#include "CrashTriage.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace fuzzberg {
+
+// ---------------------------------------------------------------------------
+// StderrCapture
+
+void StderrCapture::open() {
+  stop(); // a previous target's capture, if it was never drained
+  if (pipe2(_fds, O_CLOEXEC) < 0) {
+    perror("pipe2");
+    exit(1);
+  }
+  _stop = false;
+  _eof = false;
+  std::lock_guard<std::mutex> lock(_mutex);
+  _tail.clear();
+}
+
+void StderrCapture::child() {
+  if (_fds[1] >= 0)
+    dup2(_fds[1], STDERR_FILENO); // the dup is not close-on-exec
+}
+
+void StderrCapture::parent() {
+  close(_fds[1]);
+  _fds[1] = -1;
+
+  // main() handles SIGINT with siglongjmp, which must never run on this
+  // thread: start it with every signal blocked (threads inherit the mask).
+  sigset_t all, saved;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &saved);
+  _reader = std::thread([this] {
+    char buf[4096];
+    struct pollfd pfd = {_fds[0], POLLIN, 0};
+    while (!_stop.load(std::memory_order_relaxed)) {
+      if (poll(&pfd, 1, 100) <= 0)
+        continue;
+      ssize_t n = read(_fds[0], buf, sizeof(buf));
+      if (n <= 0) {
+        if (n < 0 && errno == EINTR)
+          continue;
+        break; // EOF: the target (and anything it forked) closed stderr
+      }
+      if (write(STDERR_FILENO, buf, n) < 0) {
+        // our own stderr is gone; keep capturing anyway
+      }
+      std::lock_guard<std::mutex> lock(_mutex);
+      _tail.append(buf, n);
+      if (_tail.size() > 2 * kTailBytes)
+        _tail.erase(0, _tail.size() - kTailBytes);
+    }
+    _eof = true;
+  });
+  pthread_sigmask(SIG_SETMASK, &saved, nullptr);
+}
+
+std::string StderrCapture::drain(long timeout_ms) {
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (_reader.joinable() && !_eof &&
+         std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  stop();
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_tail.size() > kTailBytes)
+    return _tail.substr(_tail.size() - kTailBytes);
+  return _tail;
+}
+
+void StderrCapture::stop() {
+  _stop = true;
+  if (_reader.joinable())
+    _reader.join();
+  for (int &fd : _fds) {
+    if (fd >= 0)
+      close(fd);
+    fd = -1;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Signatures
+
+namespace {
+
+uint64_t fnv1a(const std::string &data, uint64_t hash = 0xcbf29ce484222325ULL) {
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+std::string trim(const std::string &s) {
+  size_t begin = s.find_first_not_of(" \t\r");
+  if (begin == std::string::npos)
+    return "";
+  size_t end = s.find_last_not_of(" \t\r");
+  return s.substr(begin, end - begin + 1);
+}
+
+// Frames that say where the sanitizer or libc noticed the bug, not where it
+// is. Prefix match on the normalized function name.
+bool is_noise_frame(const std::string &function) {
+  static const char *const kPrefixes[] = {
+      "__asan",       "__ubsan",   "__msan",          "__tsan",
+      "__lsan",       "__sanitizer", "__interceptor_", "__GI_",
+      "__libc_",      "__cxa_",    "malloc",          "calloc",
+      "realloc",      "free",      "operator new",    "operator delete",
+      "abort",        "raise",     "__assert_fail",   "__pthread_kill",
+      "pthread_kill", "std::terminate", "__gnu_cxx::__verbose_terminate"};
+  for (const char *prefix : kPrefixes) {
+    if (function.rfind(prefix, 0) == 0)
+      return true;
+  }
+  return false;
+}
+
+// "foo::bar(int, char const*) const" -> "foo::bar"
+std::string strip_arguments(std::string function) {
+  if (function.size() > 6 &&
+      function.compare(function.size() - 6, 6, " const") == 0)
+    function.resize(function.size() - 6);
+  if (function.empty() || function.back() != ')')
+    return function;
+  int depth = 0;
+  for (size_t i = function.size(); i-- > 0;) {
+    if (function[i] == ')')
+      ++depth;
+    else if (function[i] == '(' && --depth == 0)
+      return function.substr(0, i);
+  }
+  return function;
+}
+
+// One "#N 0xADDR in function location" line of a sanitizer stack. Returns
+// false for anything else; `index` receives N, `frame` the normalized
+// function (or module+offset for frames without symbols).
+bool parse_frame(const std::string &raw, int &index, std::string &frame) {
+  std::string line = trim(raw);
+  if (line.size() < 2 || line[0] != '#' || !isdigit(line[1]))
+    return false;
+  index = atoi(line.c_str() + 1);
+  size_t addr = line.find(" 0x");
+  if (addr == std::string::npos)
+    return false;
+  size_t rest = line.find(' ', addr + 1);
+  if (rest == std::string::npos)
+    return false;
+  std::string tail = trim(line.substr(rest));
+
+  if (tail.rfind("in ", 0) == 0) {
+    tail = tail.substr(3);
+    // the location is the last token: "/src/file.cc:12:3" or "(lib.so+0x..)"
+    size_t loc = tail.rfind(" /");
+    if (loc == std::string::npos)
+      loc = tail.rfind(" (");
+    frame = strip_arguments(loc == std::string::npos ? tail
+                                                     : tail.substr(0, loc));
+    return true;
+  }
+  // "(/path/to/binary+0x1234)": keep the module name and offset
+  size_t slash = tail.rfind('/');
+  frame = (slash == std::string::npos) ? tail : tail.substr(slash + 1);
+  if (!frame.empty() && frame.back() == ')')
+    frame.pop_back();
+  if (!frame.empty() && frame.front() == '(')
+    frame.erase(0, 1);
+  return true;
+}
+
+// "signed integer overflow: 2147483647 + 1 cannot be ..." ->
+// "signed integer overflow"; the operands would split one bug into many.
+std::string ubsan_kind(const std::string &message) {
+  std::string kind = message.substr(0, message.find(':'));
+  std::istringstream words(kind);
+  std::string word, out;
+  while (words >> word) {
+    if (word.find_first_of("0123456789") != std::string::npos)
+      break;
+    out += (out.empty() ? "" : " ") + word;
+  }
+  return out;
+}
+
+// "Address" (from "AddressSanitizer") -> "asan"
+std::string sanitizer_prefix(const std::string &name) {
+  if (name == "UndefinedBehavior")
+    return "ubsan";
+  std::string prefix = "san";
+  if (!name.empty())
+    prefix.insert(prefix.begin(), static_cast<char>(tolower(name[0])));
+  return prefix;
+}
+
+} // namespace
+
+std::string crash_signature::id() const {
+  char buf[17];
+  snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(hash));
+  return buf;
+}
+
+crash_signature parse_crash_report(const std::string &report, int status,
+                                   size_t max_frames) {
+  crash_signature sig;
+  std::string ubsan_location;
+  bool in_stack = false;
+
+  std::istringstream lines(report);
+  std::string line;
+  while (std::getline(lines, line)) {
+    if (sig.kind.empty()) {
+      // "==123==ERROR: AddressSanitizer: heap-use-after-free on address ..."
+      size_t tool = line.find("Sanitizer: ");
+      if (tool != std::string::npos &&
+          (line.find("ERROR: ") != std::string::npos ||
+           line.find("WARNING: ") != std::string::npos)) {
+        size_t name_start = line.rfind(' ', tool);
+        std::string name = line.substr(name_start + 1, tool - name_start - 1);
+        std::string rest = line.substr(tool + 11);
+        sig.kind = sanitizer_prefix(name) + ":" + rest.substr(0, rest.find(' '));
+        continue;
+      }
+      // "/src/file.cc:12:5: runtime error: signed integer overflow: ..."
+      size_t runtime = line.find(": runtime error: ");
+      if (runtime != std::string::npos) {
+        sig.kind = "ubsan:" + ubsan_kind(line.substr(runtime + 17));
+        std::string location = line.substr(0, runtime);
+        size_t slash = location.rfind('/');
+        ubsan_location =
+            slash == std::string::npos ? location : location.substr(slash + 1);
+        continue;
+      }
+    }
+
+    int index = 0;
+    std::string frame;
+    if (!parse_frame(line, index, frame)) {
+      if (in_stack && trim(line).empty())
+        break; // end of the first stack
+      continue;
+    }
+    if (in_stack && index == 0)
+      break; // "freed by thread ..." and later stacks describe context
+    in_stack = true;
+    if (!is_noise_frame(frame) && sig.frames.size() < max_frames)
+      sig.frames.push_back(frame);
+  }
+
+  if (sig.frames.empty() && !ubsan_location.empty())
+    sig.frames.push_back(ubsan_location);
+  if (sig.kind.empty()) {
+    if (WIFSIGNALED(status)) {
+      const char *name = sigabbrev_np(WTERMSIG(status));
+      sig.kind = std::string("signal:SIG") +
+                 (name ? name : std::to_string(WTERMSIG(status)).c_str());
+    } else if (WIFEXITED(status)) {
+      sig.kind = "exit:" + std::to_string(WEXITSTATUS(status));
+    } else {
+      sig.kind = "unknown";
+    }
+  }
+
+  sig.hash = fnv1a(sig.kind);
+  for (const auto &frame : sig.frames)
+    sig.hash = fnv1a("\n" + frame, sig.hash);
+  return sig;
+}
+
+void crash_signature::tag(const std::string &prefix) {
+  kind = prefix + ":" + kind;
+  hash = fnv1a(kind);
+  for (const auto &frame : frames)
+    hash = fnv1a("\n" + frame, hash);
+}
+
+// ---------------------------------------------------------------------------
+// Buckets
+
+namespace {
+
+bool write_file(const std::filesystem::path &path, const char *data,
+                size_t size) {
+  // write + rename: another worker never sees a half-written artifact
+  auto tmp = path;
+  tmp += ".tmp." + std::to_string(getpid());
+  FILE *fp = std::fopen(tmp.c_str(), "wb");
+  if (!fp)
+    return false;
+  bool ok = std::fwrite(data, 1, size, fp) == size;
+  ok = (std::fclose(fp) == 0) && ok;
+  if (ok)
+    ok = std::rename(tmp.c_str(), path.c_str()) == 0;
+  if (!ok)
+    std::remove(tmp.c_str());
+  return ok;
+}
+
+} // namespace
+
+CrashBuckets::CrashBuckets(std::string crash_dir)
+    : _crash_dir(std::move(crash_dir)) {}
+
+namespace {
+
+nlohmann::json read_index(const std::filesystem::path &path) {
+  std::ifstream in(path);
+  if (in.is_open()) {
+    auto parsed = nlohmann::json::parse(in, nullptr, false);
+    if (parsed.is_object())
+      return parsed;
+  }
+  return nlohmann::json::object();
+}
+
+} // namespace
+
+size_t CrashBuckets::size() const {
+  return read_index(std::filesystem::path(_crash_dir) / "crashes.json").size();
+}
+
+CrashBuckets::verdict CrashBuckets::record(const crash_signature &sig,
+                                           const char *data, size_t size,
+                                           const std::string &report,
+                                           const nlohmann::json *replay_log) {
+  namespace fs = std::filesystem;
+  verdict result;
+  std::error_code ec;
+  fs::create_directories(_crash_dir, ec);
+  const fs::path dir(_crash_dir);
+  const std::string id = sig.id();
+  const fs::path artifact = dir / ("crash-" + id + ".bin");
+  result.artifact = artifact.string();
+
+  // Serialize the read-modify-write of the index across --jobs workers.
+  int lock_fd = ::open((dir / ".crashes.lock").c_str(),
+                       O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (lock_fd >= 0)
+    flock(lock_fd, LOCK_EX);
+
+  const fs::path index_path = dir / "crashes.json";
+  nlohmann::json index = read_index(index_path);
+
+  const long now = static_cast<long>(time(nullptr));
+  auto &bucket = index[id];
+  result.is_new = !bucket.is_object() || !fs::exists(artifact);
+  // An empty input never replaces a real one, however small.
+  bool keep_input =
+      result.is_new ||
+      (size > 0 && size < bucket.value("size", static_cast<size_t>(-1)));
+  if (!bucket.is_object()) {
+    bucket = {{"kind", sig.kind}, {"frames", sig.frames}, {"count", 0},
+              {"first_seen", now}};
+  }
+  bucket["count"] = bucket.value("count", size_t{0}) + 1;
+  bucket["last_seen"] = now;
+  result.count = bucket["count"].get<size_t>();
+
+  if (keep_input && write_file(artifact, data, size)) {
+    bucket["size"] = size;
+    write_file(dir / ("crash-" + id + ".txt"), report.data(), report.size());
+    if (replay_log) {
+      std::string log = replay_log->dump(2) + "\n";
+      fs::path log_path = artifact;
+      log_path += ".replay.json";
+      write_file(log_path, log.data(), log.size());
+    }
+  }
+
+  std::string dumped = index.dump(2) + "\n";
+  write_file(index_path, dumped.data(), dumped.size());
+  if (lock_fd >= 0) {
+    flock(lock_fd, LOCK_UN);
+    close(lock_fd);
+  }
+  return result;
+}
+
+} // namespace fuzzberg
@@ -0,0 +1,118 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Crash triage: the target's stderr is captured through a pipe, sanitizer
+// reports in it are reduced to a signature (bug kind plus the top stack
+// frames), and crashes are filed into one bucket per signature. Only one
+// representative input is kept per bucket, with a hit counter, so the
+// crash directory grows with unique bugs rather than with crash count.
+
+namespace fuzzberg {
+
+// Tees the target's stderr to ours and keeps its tail for crash triage.
+// Use: open() before fork(), child() in the child before execv(), parent()
+// in the parent, drain() once the target has been reaped.
+class StderrCapture {
+public:
+  StderrCapture() = default;
+  ~StderrCapture() { stop(); }
+
+  StderrCapture(const StderrCapture &) = delete;
+  StderrCapture &operator=(const StderrCapture &) = delete;
+
+  void open();
+  void child();
+  void parent();
+
+  // Wait (bounded) until the target's end of the pipe is closed, stop
+  // capturing and return what was kept: the last kTailBytes of output.
+  std::string drain(long timeout_ms = 1000);
+  void stop();
+
+  static constexpr size_t kTailBytes = 256 * 1024;
+
+private:
+  int _fds[2] = {-1, -1};
+  std::thread _reader;
+  std::atomic<bool> _stop{false};
+  std::atomic<bool> _eof{false};
+  std::mutex _mutex;
+  std::string _tail; // guarded by _mutex
+};
+
+struct crash_signature {
+  // "asan:heap-use-after-free", "signal:SIGSEGV"
+  std::string kind;
+  std::vector<std::string> frames; // normalized, innermost first
+  uint64_t hash = 0;
+
+  std::string id() const; // hash as 16 hex digits
+  // File under a bucket of its own: "<prefix>:" before the kind, and the
+  // hash recomputed to match.
+  void tag(const std::string &prefix);
+};
+
+// Reduce a target's stderr and wait status to a signature. Uses the first
+// stack of an ASan/MSan/TSan/LSan report (or a UBSan runtime error), skips
+// sanitizer, allocator and abort frames, and keeps `max_frames` frames
+// with argument lists and addresses stripped. Without a report, the
+// signature is only the signal (or exit code).
+crash_signature parse_crash_report(const std::string &report, int status,
+                                   size_t max_frames = 5);
+
+class CrashBuckets {
+public:
+  explicit CrashBuckets(std::string crash_dir);
+
+  struct verdict {
+    bool is_new = false; // first crash with this signature
+    size_t count = 0;    // crashes with this signature so far
+    std::string artifact;
+  };
+
+  // File a crash: the first input of a bucket, or a smaller non-empty one,
+  // becomes crash-<id>.bin with the sanitizer report (crash-<id>.txt) and
+  // replay log next to it. Every hit is counted in <crash_dir>/crashes.json,
+  // which concurrent --jobs workers update under a lock.
+  verdict record(const crash_signature &sig, const char *data, size_t size,
+                 const std::string &report,
+                 const nlohmann::json *replay_log);
+
+  // Buckets in crashes.json, across every worker and earlier session.
+  size_t size() const;
+
+private:
+  std::string _crash_dir;
+};
+
+} // namespace fuzzberg
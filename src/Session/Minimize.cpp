@@ -0,0 +1,398 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#include "Minimize.h"
+
+#include <Session/TargetProcess.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace fuzzberg {
+
+Minimizer::Minimizer(DatabaseHandler &target, CoverageMap *coverage,
+                     volatile sig_atomic_t &interrupted)
+    : _target(target), _coverage(coverage), _interrupted(interrupted) {}
+
+Minimizer::~Minimizer() = default; // the dispatcher goes before curl
+
+std::string Minimizer::mutation_file(const std::string &data) const {
+  // Where the format fuzzer writes its mutation, so the queries read it.
+  const std::string &dir = _target.fuzzer_mutation_path;
+  if (_target.file_format == "csv")
+    return dir + "/fuzz.csv";
+  if (_target.file_format == "parquet")
+    return dir + "/fuzz.parquet";
+  // Iceberg artifacts are either table metadata or a manifest list
+  auto json = nlohmann::json::parse(data, nullptr, false);
+  return dir + (json.is_object() ? "/v3.metadata.json" : "/manifest_list.avro");
+}
+
+void Minimizer::restart_target() {
+  _queue.reset();
+  _target.RestartTarget();
+}
+
+Minimizer::outcome Minimizer::execute(const std::string &data) {
+  outcome result;
+  std::string path = mutation_file(data);
+  FILE *fp = std::fopen(path.c_str(), "wb");
+  if (!fp || std::fwrite(data.data(), 1, data.size(), fp) != data.size()) {
+    std::cerr << "Could not write minimization candidate to " << path
+              << std::endl;
+    perror("fwrite");
+    exit(1);
+  }
+  std::fclose(fp);
+
+  if (!_queue) {
+    _queue = std::make_unique<QueryDispatcher>(_target.curl, _target.db_url, 1,
+                                               _target.http_options);
+  }
+  if (_coverage)
+    _coverage->reset();
+  for (const auto &query : _target.queries) {
+    _queue->submit(query, 0);
+    ++_execs;
+  }
+  CURLcode rc = _queue->wait_slot(0);
+  if (rc == CURLE_OK) {
+    if (_coverage)
+      result.trace = _coverage->trace_digest();
+    return result;
+  }
+
+  int status = 0;
+  pid_t pid = _target.target_pid;
+  if (rc == CURLE_OPERATION_TIMEDOUT) {
+    kill(pid, SIGKILL);
+    waitpid(pid, &status, 0);
+    result.kind = outcome::hung;
+    restart_target();
+    return result;
+  }
+  if (wait_for_exit(pid, status, kCrashExitGraceMs)) {
+    result.kind = outcome::crashed;
+    result.signature =
+        parse_crash_report(_target.target_stderr.drain(), status);
+    restart_target();
+    return result;
+  }
+  result.kind = outcome::failed; // rejected the query, still serving
+  return result;
+}
+
+bool Minimizer::interesting(const std::string &data) {
+  outcome result = execute(data);
+  if (_want_crash)
+    return result.kind == outcome::crashed &&
+           result.signature.hash == _want;
+  return result.kind == outcome::passed && result.trace == _want;
+}
+
+std::vector<std::string> Minimizer::ddmin(std::vector<std::string> units,
+                                          const assembler &assemble) {
+  size_t n = 2;
+  while (units.size() >= 2 && !_interrupted) {
+    const size_t chunk = (units.size() + n - 1) / n;
+    bool reduced = false;
+    for (size_t start = 0; start < units.size() && !_interrupted;
+         start += chunk) {
+      const size_t stop = std::min(start + chunk, units.size());
+      std::vector<std::string> kept(units.begin(), units.begin() + start);
+      kept.insert(kept.end(), units.begin() + stop, units.end());
+      if (interesting(assemble(kept))) {
+        units = std::move(kept);
+        n = std::max<size_t>(n - 1, 2);
+        reduced = true;
+        break;
+      }
+    }
+    if (reduced)
+      continue;
+    if (chunk == 1)
+      break; // every single unit is needed
+    n = std::min(n * 2, units.size());
+  }
+  // ddmin never tries the empty complement; one unit left may still go
+  if (units.size() == 1 && !_interrupted && interesting(assemble({})))
+    units.clear();
+  return units;
+}
+
+namespace {
+
+std::string join(const std::vector<std::string> &units) {
+  std::string out;
+  for (const auto &unit : units)
+    out += unit;
+  return out;
+}
+
+// Rows with their line ending, so joining them restores the file.
+std::vector<std::string> split_lines(const std::string &data) {
+  std::vector<std::string> lines;
+  size_t start = 0;
+  while (start < data.size()) {
+    size_t end = data.find('\n', start);
+    end = (end == std::string::npos) ? data.size() : end + 1;
+    lines.push_back(data.substr(start, end - start));
+    start = end;
+  }
+  return lines;
+}
+
+// Fields of one row, each but the first with its leading comma; commas
+// inside double quotes don't split.
+std::vector<std::string> split_fields(const std::string &row) {
+  std::vector<std::string> fields;
+  bool quoted = false;
+  size_t start = 0;
+  for (size_t i = 0; i < row.size(); ++i) {
+    if (row[i] == '"')
+      quoted = !quoted;
+    else if (row[i] == ',' && !quoted && i > start) {
+      fields.push_back(row.substr(start, i - start));
+      start = i;
+    }
+  }
+  fields.push_back(row.substr(start));
+  return fields;
+}
+
+uint32_t read_le32(const std::string &data, size_t at) {
+  return static_cast<uint32_t>(static_cast<uint8_t>(data[at])) |
+         static_cast<uint32_t>(static_cast<uint8_t>(data[at + 1])) << 8 |
+         static_cast<uint32_t>(static_cast<uint8_t>(data[at + 2])) << 16 |
+         static_cast<uint32_t>(static_cast<uint8_t>(data[at + 3])) << 24;
+}
+
+std::string dump(const nlohmann::json &json) {
+  // as load_corpus serializes Iceberg metadata
+  return json.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+}
+
+} // namespace
+
+std::string Minimizer::reduce_csv(const std::string &input) {
+  std::vector<std::string> lines = ddmin(split_lines(input), join);
+  for (size_t row = 0; row < lines.size() && !_interrupted; ++row) {
+    auto fields = ddmin(split_fields(lines[row]),
+                        [&](const std::vector<std::string> &kept) {
+                          auto candidate = lines;
+                          candidate[row] = join(kept);
+                          return join(candidate);
+                        });
+    lines[row] = join(fields);
+  }
+  return join(lines);
+}
+
+std::string Minimizer::reduce_parquet(const std::string &input) {
+  // "PAR1" <pages...> <footer> <footer length: le32> "PAR1"
+  const size_t size = input.size();
+  if (size < 12 || input.compare(0, 4, "PAR1") != 0 ||
+      input.compare(size - 4, 4, "PAR1") != 0)
+    return reduce_bytes(input, 0, size);
+  const size_t footer = read_le32(input, size - 8);
+  if (footer + 12 > size)
+    return reduce_bytes(input, 0, size);
+  return reduce_bytes(input, 4, size - 8 - footer);
+}
+
+std::string Minimizer::reduce_bytes(const std::string &input, size_t begin,
+                                    size_t end) {
+  const std::string head = input.substr(0, begin);
+  const std::string tail = input.substr(end);
+  std::string body = input.substr(begin, end - begin);
+
+  // Coarse chunks first: per-byte ddmin over a megabyte would take
+  // millions of executions. Bytes only once the body is small.
+  size_t grain = std::max<size_t>(body.size() / 256, 1);
+  while (!_interrupted && !body.empty()) {
+    std::vector<std::string> units;
+    for (size_t at = 0; at < body.size(); at += grain)
+      units.push_back(body.substr(at, grain));
+    body = join(ddmin(std::move(units),
+                      [&](const std::vector<std::string> &kept) {
+                        return head + join(kept) + tail;
+                      }));
+    if (grain == 1)
+      break;
+    grain = (body.size() <= 4096) ? 1 : std::max<size_t>(grain / 16, 1);
+  }
+  return head + body + tail;
+}
+
+std::string Minimizer::reduce_json(const nlohmann::json &input) {
+  nlohmann::json root = input;
+  // Breadth-first over containers, so whole subtrees go before their
+  // leaves are looked at.
+  std::vector<nlohmann::json::json_pointer> pending{
+      nlohmann::json::json_pointer()};
+  for (size_t next = 0; next < pending.size() && !_interrupted; ++next) {
+    const auto at = pending[next];
+    const nlohmann::json node = root[at];
+    if (!node.is_structured() || node.empty())
+      continue;
+
+    std::vector<std::string> units; // object keys, or array indices
+    if (node.is_object()) {
+      for (auto it = node.begin(); it != node.end(); ++it)
+        units.push_back(it.key());
+    } else {
+      for (size_t i = 0; i < node.size(); ++i)
+        units.push_back(std::to_string(i));
+    }
+    auto rebuild = [&](const std::vector<std::string> &kept) {
+      nlohmann::json reduced = node.is_object() ? nlohmann::json::object()
+                                                : nlohmann::json::array();
+      for (const auto &unit : kept) {
+        if (node.is_object())
+          reduced[unit] = node[unit];
+        else
+          reduced.push_back(node[std::stoul(unit)]);
+      }
+      return reduced;
+    };
+    auto kept = ddmin(units, [&](const std::vector<std::string> &kept) {
+      nlohmann::json candidate = root;
+      candidate[at] = rebuild(kept);
+      return dump(candidate);
+    });
+    root[at] = rebuild(kept);
+
+    const auto &reduced = root[at];
+    if (reduced.is_object()) {
+      for (auto it = reduced.begin(); it != reduced.end(); ++it)
+        pending.push_back(at / it.key());
+    } else {
+      for (size_t i = 0; i < reduced.size(); ++i)
+        pending.push_back(at / i);
+    }
+  }
+  return dump(root);
+}
+
+bool Minimizer::minimize(const std::string &input, std::string &output) {
+  // The behaviour to preserve is whatever the input does now.
+  outcome baseline = execute(input);
+  if (baseline.kind == outcome::crashed) {
+    _want_crash = true;
+    _want = baseline.signature.hash;
+    std::cout << "\033[1;33m[INFO] Preserving crash "
+              << baseline.signature.id() << "\033[0m ("
+              << baseline.signature.kind << ")\n";
+  } else if (baseline.kind == outcome::passed && _coverage) {
+    _want_crash = false;
+    _want = baseline.trace;
+    // A flaky trace would reject every candidate: check it once more.
+    if (!interesting(input)) {
+      std::cerr << "\033[1;33m[WARN] Coverage of this input is not "
+                   "deterministic; skipping it\033[0m\n";
+      return false;
+    }
+    std::cout << "\033[1;33m[INFO] Preserving coverage\033[0m (trace 0x"
+              << std::hex << _want << std::dec << ")\n";
+  } else {
+    std::cerr << "\033[1;33m[WARN] Input "
+              << (baseline.kind == outcome::hung     ? "hangs the target"
+                  : baseline.kind == outcome::failed ? "fails its queries"
+                                                     : "does not crash")
+              << (_coverage ? "" : "; seeds need --coverage")
+              << ", nothing to preserve\033[0m\n";
+    return false;
+  }
+
+  const size_t before = _execs;
+  if (_target.file_format == "csv") {
+    output = reduce_csv(input);
+  } else if (_target.file_format == "parquet") {
+    output = reduce_parquet(input);
+  } else {
+    auto json = nlohmann::json::parse(input, nullptr, false);
+    output = json.is_structured() ? reduce_json(json)
+                                  : reduce_bytes(input, 0, input.size());
+  }
+  std::cout << "\033[1;32m[+]\033[0m " << input.size() << " -> "
+            << output.size() << " bytes in " << (_execs - before)
+            << " executions" << (_interrupted ? " (interrupted)" : "")
+            << std::endl;
+  return true;
+}
+
+size_t minimize_inputs(Minimizer &minimizer, const std::string &path) {
+  namespace fs = std::filesystem;
+  std::vector<std::pair<fs::path, fs::path>> jobs; // input, output
+  if (fs::is_directory(path)) {
+    fs::path dir = fs::path(path).lexically_normal();
+    if (dir.filename().empty())
+      dir = dir.parent_path();
+    fs::path out_dir = dir;
+    out_dir += ".min";
+    fs::create_directories(out_dir);
+    for (const auto &entry : fs::directory_iterator(dir)) {
+      if (entry.is_regular_file())
+        jobs.emplace_back(entry.path(), out_dir / entry.path().filename());
+    }
+    std::sort(jobs.begin(), jobs.end());
+  } else if (fs::is_regular_file(path)) {
+    fs::path in(path);
+    jobs.emplace_back(in, in.parent_path() / (in.stem().string() + ".min" +
+                                              in.extension().string()));
+  } else {
+    std::cerr << "Nothing to minimize at " << path << std::endl;
+    exit(1);
+  }
+
+  size_t failed = 0;
+  for (const auto &[in, out] : jobs) {
+    if (minimizer.interrupted())
+      break;
+    std::ifstream file(in, std::ios::binary);
+    std::string input((std::istreambuf_iterator<char>(file)),
+                      std::istreambuf_iterator<char>());
+    std::cout << "\n[INFO] Minimizing " << in.string() << " (" << input.size()
+              << " bytes)\n";
+    std::string output;
+    if (!minimizer.minimize(input, output)) {
+      ++failed;
+      continue;
+    }
+    std::ofstream result(out, std::ios::binary | std::ios::trunc);
+    result.write(output.data(), output.size());
+    if (result) {
+      std::cout << "Minimized input written to: " << out.string() << "\n";
+    } else {
+      std::cerr << "Could not write " << out.string() << std::endl;
+      ++failed;
+    }
+  }
+  return failed;
+}
+
+} // namespace fuzzberg
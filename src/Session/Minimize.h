@@ -0,0 +1,106 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#pragma once
+
+#include <Databases/Database.h>
+#include <Session/Coverage.h>
+#include <Session/CrashTriage.h>
+
+#include <csignal>
+#include <functional>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+// Test-case minimization (--minimize). An input is run against the target
+// through the session's own queries, and delta debugging (ddmin) removes
+// pieces of it for as long as the behaviour worth keeping survives: the
+// same crash signature (see CrashTriage.h) for crash artifacts, or, with
+// --coverage, the same set of edges for corpus seeds. The pieces follow the
+// format, so reductions stay parseable: CSV rows and then fields, Parquet
+// bytes between the "PAR1" header and the footer, Iceberg metadata keys and
+// array elements. Anything else is reduced as plain bytes.
+
+namespace fuzzberg {
+
+class Minimizer {
+public:
+  // `target` must already be running (ForkTarget). `interrupted` is polled
+  // between executions; an interrupted run returns the smallest input
+  // found so far.
+  Minimizer(DatabaseHandler &target, CoverageMap *coverage,
+            volatile sig_atomic_t &interrupted);
+  ~Minimizer();
+
+  // Reduce `input` into `output`. Returns false, with `output` untouched,
+  // if the input has nothing to preserve: it doesn't crash the target and
+  // there is no coverage map to compare against.
+  bool minimize(const std::string &input, std::string &output);
+
+  size_t execs() const { return _execs; }
+  bool interrupted() const { return _interrupted; }
+
+private:
+  struct outcome {
+    enum { passed, crashed, hung, failed } kind = passed;
+    crash_signature signature; // crashed
+    uint64_t trace = 0;        // passed, with coverage
+  };
+
+  // Write `data` where the queries read it, send them all and classify how
+  // the target took it. A dead or hung target is replaced by a new one.
+  outcome execute(const std::string &data);
+  bool interesting(const std::string &data);
+  void restart_target();
+  std::string mutation_file(const std::string &data) const;
+
+  // ddmin over `units`: drop 1/n of them at a time while `assemble(kept)`
+  // stays interesting, doubling n when no chunk can go.
+  using assembler =
+      std::function<std::string(const std::vector<std::string> &)>;
+  std::vector<std::string> ddmin(std::vector<std::string> units,
+                                 const assembler &assemble);
+
+  std::string reduce_csv(const std::string &input);
+  std::string reduce_parquet(const std::string &input);
+  std::string reduce_json(const nlohmann::json &input);
+  // Bytes in [begin, end) of `input`, coarse chunks first.
+  std::string reduce_bytes(const std::string &input, size_t begin,
+                           size_t end);
+
+  DatabaseHandler &_target;
+  CoverageMap *_coverage;
+  volatile sig_atomic_t &_interrupted;
+  std::unique_ptr<QueryDispatcher> _queue;
+
+  bool _want_crash = false; // else: same edges, without crashing
+  uint64_t _want = 0;       // signature hash or trace digest
+  size_t _execs = 0;
+};
+
+// --minimize PATH: a file is reduced to <stem>.min<ext> next to it; every
+// regular file in a directory is reduced into <dir>.min/. Returns the
+// number of inputs that could not be minimized.
+size_t minimize_inputs(Minimizer &minimizer, const std::string &path);
+
+} // namespace fuzzberg
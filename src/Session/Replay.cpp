@@ -0,0 +1,184 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#include "Replay.h"
+#include "Coverage.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace fuzzberg {
+
+namespace {
+
+std::string hex64(uint64_t value) {
+  char buf[19];
+  snprintf(buf, sizeof(buf), "0x%016llx",
+           static_cast<unsigned long long>(value));
+  return buf;
+}
+
+[[noreturn]] void bad_log(const std::string &path, const std::string &why) {
+  std::cerr << "Error: invalid replay log " << path << ": " << why
+            << std::endl;
+  exit(1);
+}
+
+// Queue entries are raw mutations: load them byte for byte (NUL-terminated
+// like promoted entries), without the Iceberg metadata rewriting that seed
+// corpus loading does.
+void append_queue_entry(const std::filesystem::path &path,
+                        corpus_buffer &corpus) {
+  std::ifstream in(path, std::ios::binary);
+  std::vector<char> bytes((std::istreambuf_iterator<char>(in)),
+                          std::istreambuf_iterator<char>());
+  if (bytes.empty())
+    return;
+  char *entry = new char[bytes.size() + 1];
+  std::copy(bytes.begin(), bytes.end(), entry);
+  entry[bytes.size()] = '\0';
+  corpus.push_back({bytes.size(), entry});
+}
+
+void trim(corpus_buffer &corpus, size_t size, const char *name) {
+  if (corpus.size() < size) {
+    std::cerr << "Error: the replayed iteration saw " << size << " " << name
+              << " entries, only " << corpus.size() << " are loaded"
+              << std::endl;
+    exit(1);
+  }
+  for (size_t i = size; i < corpus.size(); ++i) {
+    if (corpus[i].owned)
+      delete[] corpus[i].corpus;
+  }
+  corpus.resize(size);
+}
+
+} // namespace
+
+nlohmann::json replay_log(const DatabaseHandler &target) {
+  mutation_origin origin;
+  if (target.fuzzer)
+    origin = target.fuzzer->crash_origin;
+  return {{"master_seed", hex64(target.master_seed)},
+          {"format", target.file_format},
+          {"iteration", origin.iteration},
+          {"sequence", origin.sequence},
+          {"step", origin.step},
+          {"corpus_size", origin.corpus_size},
+          {"seed_index", origin.seed_index},
+          {"shard_index", target.shard_index},
+          {"shard_count", target.shard_count},
+          {"coverage", target.coverage != nullptr},
+          {"queue_start", target.coverage ? target.coverage->first_id() : 0},
+          {"parquet_modes", parquet_modes_name(target.parquet_modes)},
+          {"csv_modes", csv_modes_name(target.csv_modes)},
+          {"parquet_scale", target.parquet_scale}};
+}
+
+replay_session load_replay_log(const std::string &path,
+                               DatabaseHandler &target) {
+  std::ifstream in(path);
+  if (!in.is_open())
+    bad_log(path, "cannot open");
+  auto log = nlohmann::json::parse(in, nullptr, false);
+  if (log.is_discarded() || !log.is_object())
+    bad_log(path, "not a JSON object");
+
+  try {
+    if (log.at("format").get<std::string>() != target.file_format)
+      bad_log(path, "written for --format " +
+                        log.at("format").get<std::string>());
+    target.master_seed =
+        std::stoull(log.at("master_seed").get<std::string>(), nullptr, 0);
+
+    mutation_origin origin;
+    origin.iteration = log.at("iteration").get<uint64_t>();
+    origin.sequence = log.at("sequence").get<int>();
+    origin.step = log.at("step").get<uint64_t>();
+    origin.corpus_size = log.at("corpus_size").get<size_t>();
+    origin.seed_index = log.at("seed_index").get<size_t>();
+    if (target.file_format == "iceberg" &&
+        (origin.sequence < 1 || origin.sequence > 3))
+      bad_log(path, "no Iceberg sequence recorded");
+    target.replay = origin;
+    // Logs from before --parquet-modes existed were all blob mutations.
+    if (target.file_format == "parquet" &&
+        !parse_parquet_modes(log.value("parquet_modes", "blob"),
+                             target.parquet_modes))
+      bad_log(path, "unknown --parquet-modes");
+    // Likewise for CSV before --csv-modes.
+    if (target.file_format == "csv" &&
+        !parse_csv_modes(log.value("csv_modes", "blob"), target.csv_modes))
+      bad_log(path, "unknown --csv-modes");
+    target.parquet_scale = log.value("parquet_scale", size_t{0});
+
+    replay_session session;
+    session.shard_index = log.value("shard_index", size_t{0});
+    session.shard_count = log.value("shard_count", size_t{1});
+    session.coverage = log.value("coverage", false);
+    // Earlier logs: every session numbered its queue from 0.
+    session.queue_start = log.value("queue_start", size_t{0});
+    return session;
+  } catch (const std::exception &e) {
+    bad_log(path, e.what());
+  }
+}
+
+void prepare_replay_corpus(DatabaseHandler &target,
+                           const replay_session &session,
+                           const std::string &queue_dir) {
+  if (session.coverage && std::filesystem::is_directory(queue_dir)) {
+    // Entries of earlier sessions (lower ids) were not in its corpus.
+    std::vector<std::pair<size_t, std::filesystem::path>> entries;
+    for (const auto &entry : std::filesystem::directory_iterator(queue_dir)) {
+      size_t id;
+      if (entry.is_regular_file() && queue_entry_id(entry.path(), id) &&
+          id >= session.queue_start)
+        entries.emplace_back(id, entry.path());
+    }
+    std::sort(entries.begin(), entries.end());
+    for (const auto &[id, path] : entries) {
+      auto ext = path.extension();
+      if (target.file_format != "iceberg")
+        append_queue_entry(path, target.input_corpus);
+      else if (ext == ".json")
+        append_queue_entry(path, target.metadata_corpus);
+      else if (ext == ".avro")
+        append_queue_entry(path, target.manifest_corpus);
+    }
+  }
+
+  const auto &at = *target.replay;
+  if (target.file_format != "iceberg")
+    trim(target.input_corpus, at.corpus_size, "corpus");
+  else if (at.sequence == 1)
+    trim(target.metadata_corpus, at.corpus_size, "metadata");
+  else if (at.sequence == 3)
+    trim(target.manifest_corpus, at.corpus_size, "manifest list");
+}
+
+} // namespace fuzzberg
@@ -0,0 +1,61 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#pragma once
+
+#include <Databases/Database.h>
+
+#include <nlohmann/json.hpp>
+#include <string>
+
+// Deterministic replay (--replay). Every crash / hang artifact gets a
+// <artifact>.replay.json next to it, holding the master seed and the origin
+// of the mutation (iteration, Iceberg sequence / field / metadata seed, and
+// the corpus size it was drawn from). Since every random choice of an
+// iteration derives from (master seed, iteration), replaying the log
+// regenerates the identical mutated files and queries against a fresh
+// target, without re-running the iterations before it.
+
+namespace fuzzberg {
+
+// The log for `target`'s last failing mutation.
+nlohmann::json replay_log(const DatabaseHandler &target);
+
+// Read `path` into target.master_seed / target.replay, and return the
+// session details needed to rebuild the same corpus. Exits on a malformed
+// log or one written for another file format.
+struct replay_session {
+  size_t shard_index = 0;
+  size_t shard_count = 1;
+  bool coverage = false; // the corpus had grown from the coverage queue
+  size_t queue_start = 0; // id of the session's first queue entry
+};
+replay_session load_replay_log(const std::string &path,
+                               DatabaseHandler &target);
+
+// Rebuild the corpus as the iteration saw it: append the session's part of
+// the coverage queue in promotion order (if it used --coverage), then drop
+// later entries so seed picks draw from the same range.
+void prepare_replay_corpus(DatabaseHandler &target,
+                           const replay_session &session,
+                           const std::string &queue_dir);
+
+} // namespace fuzzberg
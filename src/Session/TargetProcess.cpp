@@ -0,0 +1,99 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#include "TargetProcess.h"
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+
+namespace fuzzberg {
+
+namespace {
+
+constexpr long kPollIntervalMs = 50;
+
+long now_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void sleep_ms(long ms) {
+  struct timespec ts = {ms / 1000, (ms % 1000) * 1000000};
+  nanosleep(&ts, nullptr);
+}
+
+} // namespace
+
+bool wait_for_exit(pid_t pid, int &status, long timeout_ms) {
+  if (pid <= 0)
+    return false;
+  const long deadline = now_ms() + timeout_ms;
+  while (true) {
+    pid_t ret = waitpid(pid, &status, WNOHANG);
+    if (ret == pid)
+      return true;
+    if (ret < 0 || now_ms() >= deadline)
+      return false;
+    sleep_ms(kPollIntervalMs);
+  }
+}
+
+bool wait_for_flush(pid_t pid, const char *flush_file, long timeout_ms,
+                    int &status, bool &exited) {
+  exited = false;
+  if (pid <= 0)
+    return false;
+
+  // Baseline taken right after SIGUSR1 was sent: the flush is only complete
+  // once the file differs from what was there before.
+  struct stat before = {};
+  bool existed = flush_file && stat(flush_file, &before) == 0;
+  off_t last_size = -1;
+
+  const long deadline = now_ms() + timeout_ms;
+  while (true) {
+    pid_t ret = waitpid(pid, &status, WNOHANG);
+    if (ret == pid) {
+      exited = true;
+      return true;
+    }
+    if (ret < 0)
+      return false;
+
+    struct stat st;
+    if (flush_file && stat(flush_file, &st) == 0) {
+      bool changed = !existed || st.st_mtim.tv_sec != before.st_mtim.tv_sec ||
+                     st.st_mtim.tv_nsec != before.st_mtim.tv_nsec ||
+                     st.st_size != before.st_size;
+      if (changed && st.st_size == last_size)
+        return true;
+      last_size = changed ? st.st_size : -1;
+    }
+
+    if (now_ms() >= deadline)
+      return false;
+    sleep_ms(kPollIntervalMs);
+  }
+}
+
+} // namespace fuzzberg
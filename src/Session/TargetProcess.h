@@ -0,0 +1,48 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#pragma once
+
+#include <sys/types.h>
+
+// Bounded waits on the target process, used instead of fixed sleeps. Only
+// async-signal-safe calls are used, so these can run inside the SIGINT
+// handler.
+
+namespace fuzzberg {
+
+// How long a target that failed a query gets to finish dying (sanitizer
+// reports can take a while to symbolize) before it counts as still alive.
+constexpr long kCrashExitGraceMs = 5000;
+
+// Poll until `pid` exits (reaping it into `status`) or `timeout_ms` passes.
+// Returns true if the child was reaped.
+bool wait_for_exit(pid_t pid, int &status, long timeout_ms);
+
+// After SIGUSR1: wait until the target either exits, or has finished writing
+// `flush_file` (it appeared or changed, and its size held still for one poll
+// interval). `flush_file` may be null. Returns true if the flush completed
+// or the child exited; `exited` tells which (the child is reaped into
+// `status` in that case).
+bool wait_for_flush(pid_t pid, const char *flush_file, long timeout_ms,
+                    int &status, bool &exited);
+
+} // namespace fuzzberg
@@ -0,0 +1,332 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#include "Workers.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <new>
+
+namespace fuzzberg {
+
+namespace {
+
+// Returns `url` with its explicit port shifted by `offset` and stores the new
+// port in `port`. Returns an empty string if the URL carries no port (workers
+// can't share one listener, so the caller treats that as fatal).
+std::string shift_url_port(const std::string &url, size_t offset, int &port) {
+  size_t host_start = url.find("://");
+  host_start = (host_start == std::string::npos) ? 0 : host_start + 3;
+  size_t host_end = url.find_first_of("/?#", host_start);
+  if (host_end == std::string::npos)
+    host_end = url.size();
+
+  size_t colon = url.rfind(':', host_end - 1);
+  if (colon == std::string::npos || colon < host_start)
+    return "";
+  // "[::1]" without a port: the last colon belongs to the IPv6 literal
+  size_t bracket = url.find(']', host_start);
+  if (bracket != std::string::npos && bracket < host_end && colon < bracket)
+    return "";
+
+  std::string digits = url.substr(colon + 1, host_end - colon - 1);
+  if (digits.empty() ||
+      digits.find_first_not_of("0123456789") != std::string::npos)
+    return "";
+
+  long shifted = std::stol(digits) + static_cast<long>(offset);
+  if (shifted > 65535)
+    return "";
+  port = static_cast<int>(shifted);
+  return url.substr(0, colon + 1) + std::to_string(port) + url.substr(host_end);
+}
+
+} // namespace
+
+WorkerPool::WorkerPool(size_t jobs, std::string crash_dir)
+    : _jobs(jobs), _crash_dir(std::move(crash_dir)) {
+  void *mem = mmap(nullptr, sizeof(worker_stats) * _jobs,
+                   PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (mem == MAP_FAILED) {
+    perror("mmap");
+    exit(1);
+  }
+  _stats = static_cast<worker_stats *>(mem);
+  for (size_t i = 0; i < _jobs; ++i)
+    new (&_stats[i]) worker_stats();
+}
+
+WorkerPool::~WorkerPool() {
+  if (_reporter.joinable()) {
+    _reporting = false;
+    _reporter.join();
+  }
+  if (_stats) {
+    munmap(_stats, sizeof(worker_stats) * _jobs);
+    _stats = nullptr;
+  }
+}
+
+int WorkerPool::spawn() {
+  std::filesystem::path log_dir = std::filesystem::path(_crash_dir) / "workers";
+  std::filesystem::create_directories(log_dir);
+
+  std::cout << "\033[1;32m[+]\033[0m Spawning \033[1;36m" << _jobs
+            << "\033[0m workers, logs in: " << log_dir.string() << "\n"
+            << std::endl;
+
+  pid_t parent = getpid();
+  for (size_t i = 0; i < _jobs; ++i) {
+    pid_t pid = fork();
+    if (pid < 0) {
+      perror("fork failed");
+      exit(1);
+    } else if (pid == 0) {
+      _index = static_cast<int>(i);
+      // Don't outlive the parent, and leave the terminal's process group so
+      // a Ctrl+C reaches the parent only; it forwards SIGINT exactly once.
+      prctl(PR_SET_PDEATHSIG, SIGINT);
+      if (getppid() != parent)
+        exit(1);
+      setpgid(0, 0);
+      _stats[i].pid = getpid();
+
+      // Interleaved per-query output from N workers (and their targets) is
+      // unreadable, so each worker logs to its own file.
+      std::string log_path =
+          (log_dir / ("w" + std::to_string(i) + ".log")).string();
+      int log_fd = open(log_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (log_fd < 0) {
+        perror("open worker log");
+        exit(1);
+      }
+      fflush(stdout);
+      dup2(log_fd, STDOUT_FILENO);
+      dup2(log_fd, STDERR_FILENO);
+      close(log_fd);
+      return _index;
+    }
+    _stats[i].pid = pid;
+  }
+  return -1;
+}
+
+void WorkerPool::configure_worker(DatabaseHandler &target, size_t index,
+                                  const std::vector<std::string> &arg_strings) {
+  const std::string worker = "w" + std::to_string(index);
+
+  int port = 0;
+  std::string url = shift_url_port(target.db_url, index, port);
+  if (url.empty()) {
+    std::cerr << "--jobs requires an explicit port in --url (got: "
+              << target.db_url << ")" << std::endl;
+    exit(1);
+  }
+  target.db_url = url;
+
+  // The target must listen on the worker's port: substitute placeholders in
+  // its argv, and export them for launchers that read the environment
+  // (e.g. getenv('FUZZBERG_PORT') in a DuckDB init script).
+  setenv("FUZZBERG_WORKER", std::to_string(index).c_str(), 1);
+  setenv("FUZZBERG_PORT", std::to_string(port).c_str(), 1);
+  _worker_args = arg_strings;
+  for (auto &arg : _worker_args) {
+    replace_all(arg, "{port}", std::to_string(port));
+    replace_all(arg, "{worker}", std::to_string(index));
+  }
+  target.execv_args.clear();
+  for (auto &arg : _worker_args)
+    target.execv_args.push_back(const_cast<char *>(arg.c_str()));
+  target.execv_args.push_back(nullptr);
+
+  // Each worker writes its mutations under a `w<N>` subdirectory, and every
+  // query (and the column-filter FROM clause) is pointed at it. For Iceberg
+  // the subdirectory goes above `metadata/`, so the rewritten
+  // location/manifest-list URLs keep their /metadata/... suffix.
+  std::filesystem::path mutation_dir(target.fuzzer_mutation_path);
+  if (!mutation_dir.has_filename())
+    mutation_dir = mutation_dir.parent_path();
+
+  std::string from, to;
+  if (target.file_format == "iceberg") {
+    std::string metadata_dir = mutation_dir.filename().string();
+    from = "/" + metadata_dir + "/v3.metadata.json";
+    to = "/" + worker + from;
+    mutation_dir = mutation_dir.parent_path() / worker / metadata_dir;
+    if (target.s3_bucket && *target.s3_bucket != "file")
+      target.s3_bucket = *target.s3_bucket + "/" + worker;
+  } else {
+    from = "/fuzz." + target.file_format;
+    to = "/" + worker + from;
+    mutation_dir = mutation_dir / worker;
+  }
+  std::filesystem::create_directories(mutation_dir);
+  target.fuzzer_mutation_path = mutation_dir.string();
+
+  bool rewritten = false;
+  for (auto &query : target.queries) {
+    std::string original = query;
+    replace_all(query, from, to);
+    rewritten |= (query != original);
+  }
+  replace_all(target.table_expr_for_column_filters, from, to);
+  if (!rewritten) {
+    std::cerr << "\033[1;33m[WARN] No query references " << from.substr(1)
+              << "; all workers will read the same file.\033[0m" << std::endl;
+  }
+
+  std::cout << "\033[1;32m[+]\033[0m Worker " << index << " (pid " << getpid()
+            << "): url=" << target.db_url
+            << ", mutations=" << target.fuzzer_mutation_path << "\n"
+            << std::endl;
+}
+
+void WorkerPool::report_from(const size_t &execs) {
+  if (_index < 0 || _reporter.joinable())
+    return;
+  const size_t *counter = &execs;
+  worker_stats *slot = &_stats[_index];
+  _reporting = true;
+
+  // Signal handlers in this binary siglongjmp back into the main thread,
+  // so the reporter must never be picked to run one: spawn it with every
+  // signal blocked (threads inherit the creator's mask).
+  sigset_t all, saved;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &saved);
+  _reporter = std::thread([this, counter, slot] {
+    while (_reporting.load(std::memory_order_relaxed)) {
+      slot->execs.store(__atomic_load_n(counter, __ATOMIC_RELAXED),
+                        std::memory_order_relaxed);
+      std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+  });
+  pthread_sigmask(SIG_SETMASK, &saved, nullptr);
+}
+
+void WorkerPool::finish_worker(size_t execs) {
+  if (_index < 0)
+    return;
+  if (_reporter.joinable()) {
+    _reporting = false;
+    _reporter.join();
+  }
+  _stats[_index].execs.store(execs);
+}
+
+void WorkerPool::record_crash(bool hang) {
+  if (_index < 0)
+    return;
+  if (hang)
+    _stats[_index].hangs.fetch_add(1);
+  else
+    _stats[_index].crashes.fetch_add(1);
+}
+
+size_t WorkerPool::total_execs() const {
+  size_t total = 0;
+  for (size_t i = 0; i < _jobs; ++i)
+    total += _stats[i].execs.load(std::memory_order_relaxed);
+  return total;
+}
+
+size_t WorkerPool::supervise(volatile sig_atomic_t &stop, size_t &crashes,
+                             size_t &hangs) {
+  using clock = std::chrono::steady_clock;
+  const auto start = clock::now();
+  auto last_report = start;
+  size_t alive = _jobs;
+  bool forwarded = false;
+
+  while (alive > 0) {
+    if (stop && !forwarded) {
+      std::cout << "\033[1;33m\n[INFO] Stopping " << alive
+                << " workers\033[0m\n"
+                << std::endl;
+      for (size_t i = 0; i < _jobs; ++i) {
+        if (_stats[i].pid > 0)
+          kill(_stats[i].pid, SIGINT);
+      }
+      forwarded = true;
+    }
+
+    int status = 0;
+    pid_t pid = waitpid(-1, &status, WNOHANG);
+    if (pid > 0) {
+      for (size_t i = 0; i < _jobs; ++i) {
+        if (_stats[i].pid != pid)
+          continue;
+        _stats[i].pid = 0;
+        --alive;
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 1 &&
+            _stats[i].crashes.load() + _stats[i].hangs.load() > 0) {
+          std::cout << "\033[1;31m[!] Worker " << i
+                    << ": target crashed or hung, artifacts written to "
+                    << _crash_dir << "\033[0m" << std::endl;
+        } else if (WIFSIGNALED(status)) {
+          std::cout << "\033[1;31m[!] Worker " << i << " killed by signal "
+                    << WTERMSIG(status) << "\033[0m" << std::endl;
+        } else {
+          std::cout << "[INFO] Worker " << i << " exited" << std::endl;
+        }
+        break;
+      }
+      continue;
+    }
+    if (pid < 0 && errno == ECHILD)
+      break;
+
+    auto now = clock::now();
+    if (now - last_report >= std::chrono::seconds(5)) {
+      double secs = std::chrono::duration<double>(now - start).count();
+      size_t execs = total_execs();
+      size_t crashed = 0, hung = 0;
+      for (size_t i = 0; i < _jobs; ++i) {
+        crashed += _stats[i].crashes.load(std::memory_order_relaxed);
+        hung += _stats[i].hangs.load(std::memory_order_relaxed);
+      }
+      std::cout << "\033[1;36m[jobs]\033[0m workers: " << alive << "/" << _jobs
+                << "  execs: " << execs
+                << "  execs/s: " << static_cast<size_t>(execs / secs)
+                << "  crashes: " << crashed << "  hangs: " << hung
+                << std::endl;
+      last_report = now;
+    }
+    usleep(100000);
+  }
+
+  crashes = 0;
+  hangs = 0;
+  for (size_t i = 0; i < _jobs; ++i) {
+    crashes += _stats[i].crashes.load();
+    hangs += _stats[i].hangs.load();
+  }
+  return total_execs();
+}
+
+} // namespace fuzzberg
@@ -0,0 +1,96 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+#pragma once
+
+#include <Databases/Database.h>
+#include <sys/types.h>
+
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Multi-instance (--jobs N) fuzzing: the parent forks N workers, each of
+// which runs the regular single-target session against its own target
+// process, port, mutation directory and curl handle. Per-worker counters
+// live in an anonymous shared mapping so the parent can aggregate them.
+
+namespace fuzzberg {
+
+// One slot per worker, placed in MAP_SHARED memory. Only lock-free atomics
+// are used, which are address-free and therefore safe across processes.
+struct worker_stats {
+  std::atomic<uint64_t> execs{0};   // queries executed by the worker
+  std::atomic<uint32_t> crashes{0}; // target crashes detected by the worker
+  std::atomic<uint32_t> hangs{0};   // target timeouts detected by the worker
+  std::atomic<int32_t> pid{0};      // worker pid (0 until forked)
+};
+
+class WorkerPool {
+public:
+  WorkerPool(size_t jobs, std::string crash_dir);
+  ~WorkerPool();
+
+  // Forks all workers. Returns the worker index (0..jobs-1) in a child, and
+  // -1 in the parent.
+  int spawn();
+
+  // Child only: give worker `index` its own port, target args, mutation
+  // directory and query set. `arg_strings` are the user's target argv;
+  // occurrences of {port} and {worker} in them are substituted.
+  void configure_worker(DatabaseHandler &target, size_t index,
+                        const std::vector<std::string> &arg_strings);
+
+  // Child only: mirror the worker's exec counter into its shared slot until
+  // finish_worker() is called.
+  void report_from(const size_t &execs);
+  void finish_worker(size_t execs);
+  // Child only: count a crash (or hang) artifact as soon as it is written,
+  // so the parent's status line stays current with --continue.
+  void record_crash(bool hang = false);
+
+  // Parent only: reap workers, forward `stop` as SIGINT, print periodic
+  // aggregate throughput. Returns the total number of executions; `crashes`
+  // and `hangs` receive the totals reported by all workers.
+  size_t supervise(volatile sig_atomic_t &stop, size_t &crashes,
+                   size_t &hangs);
+
+  size_t jobs() const { return _jobs; }
+
+private:
+  size_t _jobs;
+  std::string _crash_dir;
+  worker_stats *_stats = nullptr; // shared mapping of _jobs slots
+  int _index = -1;                // worker index, -1 in the parent
+
+  // Per-worker target argv; execv_args in DatabaseHandler point into it.
+  std::vector<std::string> _worker_args;
+
+  std::thread _reporter;
+  std::atomic<bool> _reporting{false};
+
+  size_t total_execs() const;
+};
+
+} // namespace fuzzberg
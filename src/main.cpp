@@ -21,13 +21,19 @@
 
 #include <Databases/duckdb/duckdb.h>
 #include <Databases/firebolt-core/firebolt-core.h>
+#include <Session/Minimize.h>
+#include <Session/Replay.h>
+#include <Session/TargetProcess.h>
+#include <Session/Workers.h>
 #include <dirent.h>
 #include <getopt.h>
 #include <time.h>
 #include <unistd.h>
 
+#include <cerrno>
 #include <csetjmp>
 #include <csignal>
+#include <cstring>
 #include <cstdlib>
 #include <exception>
 #include <filesystem>
@@ -47,6 +53,37 @@ static pid_t target_pid;
 
 static struct timeval t1, t2;
 
+// Coverage flush on SIGINT: wait until the target exits or rewrites
+// `flush_file` (e.g. its LLVM_PROFILE_FILE), at most `flush_timeout_ms`.
+static std::string flush_file;
+static long flush_timeout_ms = 10000;
+
+// long-only options
+enum long_option : int {
+  OPT_HTTP_VERSION = 1000,
+  OPT_NO_KEEPALIVE,
+  OPT_NAGLE,
+  OPT_HEALTH_QUERY,
+  OPT_HEALTH_URL,
+  OPT_READY_TIMEOUT,
+  OPT_FLUSH_FILE,
+  OPT_FLUSH_TIMEOUT,
+  OPT_CONTINUE,
+  OPT_MAX_CRASHES,
+  OPT_MAX_HANGS,
+  OPT_COVERAGE,
+  OPT_SEED,
+  OPT_REPLAY,
+  OPT_MINIMIZE,
+  OPT_MUTATORS,
+  OPT_BATCH,
+  OPT_CORPUS_CACHE,
+  OPT_COMPRESS_CORPUS,
+  OPT_PARQUET_MODES,
+  OPT_PARQUET_SCALE,
+  OPT_CSV_MODES,
+};
+
 volatile sig_atomic_t interrupted =
     0; // flag to indicate if the process was interrupted
 
@@ -62,22 +99,138 @@ void interrupt(int signal) {
               << target_pid
               << ") to flush code coverage (if target handles it).\033[0m\n";
     kill(target_pid, SIGUSR1); // Request target to flush code coverage
-    sleep(10);                 // Wait for the target to process the signal
+    // Wait for the target to process the signal
+    int status = 0;
+    bool exited = false;
+    if (!fuzzberg::wait_for_flush(
+            target_pid, flush_file.empty() ? nullptr : flush_file.c_str(),
+            flush_timeout_ms, status, exited)) {
+      std::cout << "\033[1;33m\n[INFO] No coverage flush observed within "
+                << flush_timeout_ms << " ms\033[0m\n";
+    }
 
-    std::cout << "\033[1;31m\n[INFO] Terminating target process (PID: "
-              << target_pid << ")\033[0m\n";
-    kill(target_pid, SIGKILL); // Kill the target process
+    if (!exited) {
+      std::cout << "\033[1;31m\n[INFO] Terminating target process (PID: "
+                << target_pid << ")\033[0m\n";
+      kill(target_pid, SIGKILL); // Kill the target process
+      waitpid(target_pid, &status, 0);
+    }
+    // reaped: a second SIGINT (e.g. sent to the whole process group) must
+    // not signal a pid that may since have been reused
+    target_pid = 0;
   }
   interrupted = 1;
   siglongjmp(env, 1);
 }
 
+// Interrupt handler for the --jobs parent: workers own the targets, so just
+// flag the supervisor loop, which forwards SIGINT to every worker.
+void interrupt_workers(int signal) {
+  if (signal == SIGINT) {
+    interrupted = 1;
+  }
+}
+
+static void print_summary(size_t execs, long elapsedTime, size_t crashes,
+                          size_t hangs) {
+  size_t seconds = elapsedTime % 60;
+  size_t minutes = (elapsedTime / 60) % 60;
+  size_t hours = (elapsedTime / 3600) % 24;
+  size_t days = elapsedTime / (3600 * 24);
+  size_t execs_per_sec = elapsedTime > 0 ? execs / elapsedTime : execs;
+
+  std::cout << "\n"
+            << Yellow << std::left << std::setw(15) << "Crashes:" << Reset
+            << std::right << Green << std::setw(8) << crashes << Reset << "\n"
+            << Yellow << std::left << std::setw(15) << "Hangs:" << Reset
+            << std::right << Green << std::setw(8) << hangs << Reset << "\n"
+            << Yellow << std::left << std::setw(15) << "Executions:" << Reset
+            << std::right << Green << std::setw(8) << execs << Reset << "\n"
+            << Yellow << std::left << std::setw(15) << "Execs/sec:" << Reset
+            << std::right << Green << std::setw(8) << execs_per_sec << Reset
+            << "\n"
+            << Yellow << std::left << std::setw(15) << "Elapsed Time:" << Reset
+            << std::right << Green << std::setw(2) << days << "d "
+            << std::setw(2) << hours << "h " << std::setw(2) << minutes << "m "
+            << std::setw(2) << seconds << "s" << Reset << "\n\n";
+}
+
+// `fuzzberg pack`: load a corpus directory once, the way a fuzzing session
+// with the same -f would, and write it to a single corpus pack that
+// sessions map instead (-i FILE).
+static int pack_corpus(int argc, char *argv[]) {
+  std::string format, corpus_dir, pack_path;
+  static struct option pack_options[] = {
+      {"format", required_argument, NULL, 'f'},
+      {"input", required_argument, NULL, 'i'},
+      {"output", required_argument, NULL, 'o'},
+      {0, 0, 0, 0}};
+  int result = 0;
+  optind = 1;
+  while ((result = getopt_long(argc, argv, "f:i:o:", pack_options, NULL)) !=
+         -1) {
+    switch (result) {
+    case 'f':
+      format = optarg;
+      break;
+    case 'i':
+      corpus_dir = optarg;
+      break;
+    case 'o':
+      pack_path = optarg;
+      break;
+    default:
+      fprintf(stderr,
+              "\nUsage: %s pack -f FORMAT -i DIR -o FILE\n\n"
+              "  -f, --format FORMAT         File format (csv, parquet, "
+              "iceberg)\n"
+              "  -i, --input DIR             Corpus directory to pack\n"
+              "  -o, --output FILE           Corpus pack to write\n",
+              argv[0]);
+      exit(1);
+    }
+  }
+  if (format.empty() || corpus_dir.empty() || pack_path.empty()) {
+    std::cerr << "Error: pack needs -f, -i and -o" << std::endl;
+    exit(1);
+  }
+  if (!std::filesystem::is_directory(corpus_dir)) {
+    std::cerr << "\nCorpus dir does not exist, exiting..\n";
+    exit(1);
+  }
+
+  // Iceberg metadata is checked and stripped of its logs here, but keeps its
+  // locations: each session (and --jobs worker) points them at its own
+  // table when it loads the pack.
+  fuzzberg::FileFuzzerBase fuzzer_base;
+  fuzzer_base._corpus_info = fuzzberg::DatabaseHandler::make_corpus_info(
+      format, std::nullopt, "");
+  nlohmann::json info = {{"format", format}};
+  auto sources = fuzzberg::DatabaseHandler::corpus_sources(corpus_dir, format);
+  std::vector<std::filesystem::path> paths;
+  for (const auto &source : sources) {
+    paths.push_back(source.path);
+  }
+  size_t count = fuzzberg::write_corpus_pack(
+      pack_path, info, sources,
+      fuzzer_base.load_corpus(
+          paths, fuzzberg::DatabaseHandler::corpus_load_threads()));
+
+  std::cout << "\033[1;32m[+]\033[0m Packed \033[1;36m" << count
+            << "\033[0m of " << sources.size() << " files into " << pack_path
+            << std::endl;
+  return count > 0 ? 0 : 1;
+}
+
 int main(int argc, char *argv[]) {
   if (argc <= 1) {
     fprintf(stderr,
             "Please provide all the necessary arguments to fuzz target DB\n\n");
     exit(1);
   }
+  if (std::strcmp(argv[1], "pack") == 0) {
+    return pack_corpus(argc - 1, argv + 1);
+  }
 
   int status;                     // child proc status
   std::signal(SIGINT, interrupt); // register handler for ctrl+c
@@ -93,6 +246,25 @@ int main(int argc, char *argv[]) {
   std::string database; // database name to fuzz (initializes the corresponding
                         // target class)
   std::string queries;  // path to JSON file containing queries to execute
+  size_t jobs = 1;      // number of parallel workers (one target each)
+  size_t inflight = 1;  // concurrent queries per target
+  size_t mutators = 0;  // mutator processes per target (0 = inline)
+  size_t batch = 1;     // mutations (files) per query round
+  fuzzberg::connection_options http_options; // per-session HTTP settings
+  fuzzberg::readiness_options readiness;      // target startup probe
+  bool persistent = false; // --continue: restart the target after findings
+  size_t max_crashes = 0;  // stop after this many crashes (0 = no limit)
+  size_t max_hangs = 0;    // stop after this many hangs (0 = no limit)
+  bool use_coverage = false; // --coverage: shared-memory edge feedback
+  bool have_seed = false;    // --seed given
+  uint64_t master_seed = 0;  // every mutation derives from this
+  std::string replay_path;   // --replay: <artifact>.replay.json
+  std::string minimize_path; // --minimize: crash artifact or seed (dir)
+  std::optional<std::string> corpus_cache; // --corpus-cache DIR or "none"
+  size_t compress_corpus = 0; // --compress-corpus: MiB LRU, 0 = inflated
+  unsigned parquet_modes = fuzzberg::kParquetDefaultModes;
+  unsigned csv_modes = fuzzberg::kCsvDefaultModes;
+  size_t parquet_scale = 0; // --parquet-scale: MiB per synthesized file
 
   std::unique_ptr<fuzzberg::DatabaseHandler> fuzz_target;
 
@@ -107,6 +279,30 @@ int main(int argc, char *argv[]) {
       {"url", required_argument, NULL, 'u'},
       {"queries", required_argument, NULL, 'q'},
       {"bucket", required_argument, NULL, 'B'},
+      {"jobs", required_argument, NULL, 'j'},
+      {"inflight", required_argument, NULL, 'I'},
+      {"http", required_argument, NULL, OPT_HTTP_VERSION},
+      {"no-keepalive", no_argument, NULL, OPT_NO_KEEPALIVE},
+      {"nagle", no_argument, NULL, OPT_NAGLE},
+      {"health-query", required_argument, NULL, OPT_HEALTH_QUERY},
+      {"health-url", required_argument, NULL, OPT_HEALTH_URL},
+      {"ready-timeout", required_argument, NULL, OPT_READY_TIMEOUT},
+      {"flush-file", required_argument, NULL, OPT_FLUSH_FILE},
+      {"flush-timeout", required_argument, NULL, OPT_FLUSH_TIMEOUT},
+      {"continue", no_argument, NULL, OPT_CONTINUE},
+      {"max-crashes", required_argument, NULL, OPT_MAX_CRASHES},
+      {"max-hangs", required_argument, NULL, OPT_MAX_HANGS},
+      {"coverage", no_argument, NULL, OPT_COVERAGE},
+      {"seed", required_argument, NULL, OPT_SEED},
+      {"replay", required_argument, NULL, OPT_REPLAY},
+      {"minimize", required_argument, NULL, OPT_MINIMIZE},
+      {"mutators", required_argument, NULL, OPT_MUTATORS},
+      {"batch", required_argument, NULL, OPT_BATCH},
+      {"corpus-cache", required_argument, NULL, OPT_CORPUS_CACHE},
+      {"compress-corpus", required_argument, NULL, OPT_COMPRESS_CORPUS},
+      {"parquet-modes", required_argument, NULL, OPT_PARQUET_MODES},
+      {"parquet-scale", required_argument, NULL, OPT_PARQUET_SCALE},
+      {"csv-modes", required_argument, NULL, OPT_CSV_MODES},
       {0, 0, 0, 0}};
   int option_index = 0;
   int result = 0;
@@ -114,7 +310,7 @@ int main(int argc, char *argv[]) {
   // Parse all options in a single pass and initialize fuzz_target when database
   // is found
   optind = 1;
-  while ((result = getopt_long(argc, argv, "b:i:o:m:t:f:u:q:B:d:", long_options,
+  while ((result = getopt_long(argc, argv, "b:i:o:m:t:f:u:q:B:d:j:I:", long_options,
                                &option_index)) != -1) {
     switch (result) {
     case 'd':
@@ -185,6 +381,190 @@ int main(int argc, char *argv[]) {
         exit(1);
       }
       break;
+    case 'j':
+      if (optarg) {
+        char *end = nullptr;
+        long n = strtol(optarg, &end, 10);
+        if (*end != '\0' || n < 1) {
+          std::cerr << "\nPlease provide a positive number of jobs\n";
+          exit(1);
+        }
+        jobs = static_cast<size_t>(n);
+      }
+      break;
+    case 'I':
+      if (optarg) {
+        char *end = nullptr;
+        long n = strtol(optarg, &end, 10);
+        if (*end != '\0' || n < 1) {
+          std::cerr << "\nPlease provide a positive number of in-flight "
+                       "queries\n";
+          exit(1);
+        }
+        inflight = static_cast<size_t>(n);
+      }
+      break;
+    case OPT_MUTATORS:
+      if (optarg) {
+        char *end = nullptr;
+        long n = strtol(optarg, &end, 10);
+        if (*end != '\0' || n < 0 || n > 256) {
+          std::cerr << "\nPlease provide 0-256 mutator processes\n";
+          exit(1);
+        }
+        mutators = static_cast<size_t>(n);
+      }
+      break;
+    case OPT_BATCH:
+      if (optarg) {
+        char *end = nullptr;
+        long n = strtol(optarg, &end, 10);
+        if (*end != '\0' || n < 1 || n > 64) {
+          std::cerr << "\nPlease provide a batch size of 1-64\n";
+          exit(1);
+        }
+        batch = static_cast<size_t>(n);
+      }
+      break;
+    case OPT_HTTP_VERSION:
+      if (optarg) {
+        std::string version = optarg;
+        if (version == "auto") {
+          http_options.version =
+              fuzzberg::connection_options::http_version::automatic;
+        } else if (version == "1.1") {
+          http_options.version =
+              fuzzberg::connection_options::http_version::http1_1;
+        } else if (version == "h2c") {
+          http_options.version =
+              fuzzberg::connection_options::http_version::h2c;
+        } else {
+          std::cerr << "\nAllowed HTTP versions: auto, 1.1, h2c\n";
+          exit(1);
+        }
+      }
+      break;
+    case OPT_NO_KEEPALIVE:
+      http_options.keep_alive = false;
+      break;
+    case OPT_NAGLE:
+      http_options.tcp_nodelay = false;
+      break;
+    case OPT_HEALTH_QUERY:
+      if (optarg) {
+        readiness.health_query = optarg;
+      }
+      break;
+    case OPT_HEALTH_URL:
+      if (optarg) {
+        readiness.health_url = optarg;
+      }
+      break;
+    case OPT_READY_TIMEOUT:
+    case OPT_FLUSH_TIMEOUT:
+      if (optarg) {
+        char *end = nullptr;
+        double secs = strtod(optarg, &end);
+        if (*end != '\0' || secs <= 0) {
+          std::cerr << "\nPlease provide a positive timeout in seconds\n";
+          exit(1);
+        }
+        if (result == OPT_READY_TIMEOUT) {
+          readiness.deadline_ms = static_cast<long>(secs * 1000);
+        } else {
+          flush_timeout_ms = static_cast<long>(secs * 1000);
+        }
+      }
+      break;
+    case OPT_FLUSH_FILE:
+      if (optarg) {
+        flush_file = optarg;
+      }
+      break;
+    case OPT_CONTINUE:
+      persistent = true;
+      break;
+    case OPT_COVERAGE:
+      use_coverage = true;
+      break;
+    case OPT_SEED:
+      if (optarg) {
+        char *end = nullptr;
+        errno = 0;
+        master_seed = strtoull(optarg, &end, 0);
+        if (*end != '\0' || errno != 0) {
+          std::cerr << "\nPlease provide a numeric seed (decimal or 0x...)\n";
+          exit(1);
+        }
+        have_seed = true;
+      }
+      break;
+    case OPT_REPLAY:
+      if (optarg) {
+        replay_path = optarg;
+      }
+      break;
+    case OPT_MINIMIZE:
+      if (optarg) {
+        minimize_path = optarg;
+      }
+      break;
+    case OPT_CORPUS_CACHE:
+      if (optarg) {
+        corpus_cache = optarg;
+      }
+      break;
+    case OPT_COMPRESS_CORPUS:
+      if (optarg) {
+        char *end = nullptr;
+        long n = strtol(optarg, &end, 10);
+        if (*end != '\0' || n < 1 || n > 65536) {
+          std::cerr << "\nPlease provide --compress-corpus in MiB "
+                       "(1-65536)\n";
+          exit(1);
+        }
+        compress_corpus = static_cast<size_t>(n);
+      }
+      break;
+    case OPT_PARQUET_MODES:
+      if (optarg && !fuzzberg::parse_parquet_modes(optarg, parquet_modes)) {
+        std::cerr << "\nPlease provide --parquet-modes as a comma-separated "
+                     "list of: blob, footer, pages\n";
+        exit(1);
+      }
+      break;
+    case OPT_PARQUET_SCALE:
+      if (optarg) {
+        char *end = nullptr;
+        long n = strtol(optarg, &end, 10);
+        if (*end != '\0' || n < 1 || n > (1 << 20)) {
+          std::cerr << "\nPlease provide --parquet-scale in MiB "
+                       "(1-1048576)\n";
+          exit(1);
+        }
+        parquet_scale = static_cast<size_t>(n);
+      }
+      break;
+    case OPT_CSV_MODES:
+      if (optarg && !fuzzberg::parse_csv_modes(optarg, csv_modes)) {
+        std::cerr << "\nPlease provide --csv-modes as a comma-separated "
+                     "list of: blob, grammar\n";
+        exit(1);
+      }
+      break;
+    case OPT_MAX_CRASHES:
+    case OPT_MAX_HANGS:
+      if (optarg) {
+        char *end = nullptr;
+        long n = strtol(optarg, &end, 10);
+        if (*end != '\0' || n < 0) {
+          std::cerr << "\nPlease provide a non-negative crash/hang budget\n";
+          exit(1);
+        }
+        (result == OPT_MAX_CRASHES ? max_crashes : max_hangs) =
+            static_cast<size_t>(n);
+      }
+      break;
     case 'q':
       if (optarg) {
         queries = optarg;
@@ -203,7 +583,9 @@ int main(int argc, char *argv[]) {
           "firebolt)\n"
           "  -f, --format FORMAT         File format (csv, parquet, iceberg)\n"
           "  -u, --url URL               Database server URL\n"
-          "  -i, --input DIR             Input corpus directory\n"
+          "  -i, --input DIR             Input corpus directory, or a "
+          "corpus pack\n"
+          "                              (see `%s pack`)\n"
           "  -o, --output DIR            Output (crash) directory\n"
           "  -b, --bin PATH              Path to the target binary\n"
           "  -m, --mutate FILE           Mutation payload file\n"
@@ -214,8 +596,88 @@ int main(int argc, char *argv[]) {
           "literal\n"
           "                              \"file\" to write file:// URLs into "
           "metadata\n"
-          "                              (required if --format=iceberg)\n",
-          argv[0]);
+          "                              (required if --format=iceberg)\n"
+          "  -j, --jobs N                Run N workers, each with its own "
+          "target;\n"
+          "                              ports are --url's port + worker "
+          "index, and\n"
+          "                              {port} / {worker} in target args are "
+          "substituted\n"
+          "  -I, --inflight N            Keep up to N queries in flight per "
+          "target (the\n"
+          "                              next mutation is always prepared in a "
+          "second\n"
+          "                              file slot, fuzz.1.<ext>, meanwhile)\n"
+          "      --mutators N            Generate CSV / Parquet mutations "
+          "ahead in N\n"
+          "                              processes (default 0: in the fuzz "
+          "loop)\n"
+          "      --batch K               Write K mutations per round "
+          "(fuzz_000.<ext> ...)\n"
+          "                              and query them through one glob; "
+          "failures are\n"
+          "                              bisected to the culprit file\n"
+          "      --corpus-cache DIR      Cache preprocessed Iceberg metadata "
+          "in DIR\n"
+          "                              (default: <output>/.corpus-cache; "
+          "\"none\" disables)\n"
+          "      --compress-corpus MB    Keep seeds deflated in memory, with "
+          "up to MB MiB\n"
+          "                              of recently used ones inflated\n"
+          "      --parquet-modes LIST    Parquet mutations to draw from: blob, "
+          "footer,\n"
+          "                              pages (default: all three)\n"
+          "      --parquet-scale MB      Synthesize Parquet files of up to "
+          "MB MiB instead\n"
+          "                              of mutating seeds, and flag "
+          "super-linear latency\n"
+          "                              or memory growth in the target\n"
+          "      --csv-modes LIST        CSV mutations to draw from: blob, "
+          "grammar\n"
+          "                              (default: both)\n"
+          "      --http VERSION          auto (default; h2 only over TLS), "
+          "1.1 or h2c\n"
+          "      --no-keepalive          Open a new connection for every "
+          "query\n"
+          "      --nagle                 Leave Nagle's algorithm on "
+          "(TCP_NODELAY off)\n"
+          "      --health-query SQL      Target is ready once this query "
+          "returns 2xx\n"
+          "      --health-url URL        Target is ready once GET URL returns "
+          "2xx\n"
+          "                              (default: a TCP connect to --url)\n"
+          "      --ready-timeout SECS    Startup deadline (default 60)\n"
+          "      --flush-file PATH       On Ctrl+C, wait for the target to "
+          "rewrite PATH\n"
+          "                              (coverage dump) instead of exiting\n"
+          "      --flush-timeout SECS    Upper bound for that wait (default "
+          "10)\n"
+          "      --continue              Keep fuzzing after a crash or hang: "
+          "save the\n"
+          "                              artifact and restart the target\n"
+          "      --max-crashes N         With --continue, stop after N "
+          "crashes (0 = no limit)\n"
+          "      --max-hangs N           With --continue, stop after N hangs "
+          "(0 = no limit)\n"
+          "      --coverage              Keep inputs that reach new edges "
+          "(target built with\n"
+          "                              trace-pc-guard + "
+          "src/Runtime/coverage-shim.c);\n"
+          "                              they are also written to "
+          "<output>/queue\n"
+          "      --seed N                Master seed (default: random, "
+          "printed at startup)\n"
+          "      --replay LOG            Regenerate the mutation recorded in "
+          "LOG\n"
+          "                              (<artifact>.replay.json) against a "
+          "fresh target\n"
+          "      --minimize PATH         Shrink a crash input (same crash "
+          "signature) or,\n"
+          "                              with --coverage, a seed (same "
+          "edges); a directory\n"
+          "                              is minimized file by file into "
+          "PATH.min/\n",
+          argv[0], argv[0]);
       exit(1);
     }
     }
@@ -277,6 +739,66 @@ int main(int argc, char *argv[]) {
   fuzz_target->fuzzer_mutation_path =
       fuzzer_mutation_path;              // store mutation_file_path in fuzzer
   fuzz_target->_auth_token = auth_token; // store auth token in fuzzer
+  fuzz_target->max_inflight = inflight;
+  fuzz_target->mutators = mutators;
+  fuzz_target->batch = batch;
+  // The cache key covers --bucket and --mutate, so one cache can serve
+  // every campaign; by default it lives with the campaign's output.
+  if (!corpus_cache) {
+    corpus_cache = crash_dir.empty() ? "" : crash_dir + "/.corpus-cache";
+  }
+  fuzz_target->corpus_cache = (*corpus_cache == "none") ? "" : *corpus_cache;
+  fuzz_target->compress_corpus = compress_corpus;
+  fuzz_target->parquet_modes = parquet_modes;
+  fuzz_target->csv_modes = csv_modes;
+  fuzz_target->parquet_scale = parquet_scale;
+  if (parquet_scale && (format != "parquet" || batch > 1 || use_coverage)) {
+    std::cerr << "Error: --parquet-scale works for parquet, without --batch "
+                 "or --coverage\n";
+    exit(1);
+  }
+  fuzz_target->target_restarted = [](pid_t pid) { target_pid = pid; };
+  if (batch > 1 && (format == "iceberg" || use_coverage)) {
+    std::cerr << "Error: --batch works for csv and parquet, without "
+                 "--coverage\n";
+    exit(1);
+  }
+  http_options.auth_token = auth_token;
+  fuzz_target->http_options = http_options;
+  fuzz_target->readiness = readiness;
+
+  // Replay mode: run the one logged iteration against a fresh target, with
+  // the seed, corpus shard and queue of the session that recorded it.
+  fuzzberg::replay_session replay;
+  if (!replay_path.empty()) {
+    if (jobs > 1) {
+      std::cerr << "Error: --replay runs a single target, drop --jobs\n";
+      exit(1);
+    }
+    replay = fuzzberg::load_replay_log(replay_path, *fuzz_target);
+    master_seed = fuzz_target->master_seed;
+    have_seed = true;
+    fuzz_target->max_inflight = 1; // the mutation goes to the primary file
+    persistent = false;
+    use_coverage = false;
+    std::cout << Green << "[INFO] Replaying iteration " << Reset
+              << fuzz_target->replay->iteration;
+    if (fuzz_target->replay->sequence > 0) {
+      std::cout << " (sequence " << fuzz_target->replay->sequence
+                << ", field " << fuzz_target->replay->step << ")";
+    }
+    std::cout << " from " << replay_path << "\n" << std::endl;
+  }
+
+  // One master seed per session, logged so any iteration can be
+  // regenerated later; with --jobs, worker i runs with seed + i.
+  if (!have_seed) {
+    master_seed = fuzzberg::RandomStream::entropy();
+  }
+  fuzz_target->master_seed = master_seed;
+  std::cout << Green << "[INFO] Master seed: " << Reset << "0x" << std::hex
+            << master_seed << std::dec << "\n"
+            << std::endl;
 
   // Load queries to execute
   std::ifstream query_file(queries);
@@ -331,16 +853,176 @@ int main(int argc, char *argv[]) {
               << std::endl;
   }
 
-  // Load seed corpus
-  std::cout << "Loading seed corpus from: " << corpus_dir << "\n"
-            << std::endl;
-  fuzz_target->_load_corpus(corpus_dir);
+  // Multi-instance mode: fork the workers before loading the corpus, so
+  // each one only loads (and keeps resident) its own shard. The parent
+  // never launches a target; it supervises and aggregates.
+  std::unique_ptr<fuzzberg::WorkerPool> workers;
+  int worker_index = 0;
+  if (jobs > 1) {
+    if (crash_dir.empty()) {
+      std::cerr << "Error: --jobs requires an output (crash) directory\n";
+      exit(1);
+    }
+    workers = std::make_unique<fuzzberg::WorkerPool>(jobs, crash_dir);
+    std::signal(SIGINT, interrupt_workers);
+    gettimeofday(&t1, NULL);
+    worker_index = workers->spawn();
+    if (worker_index < 0) {
+      size_t crashes = 0, hangs = 0;
+      _execs = workers->supervise(interrupted, crashes, hangs);
+      gettimeofday(&t2, NULL);
+      print_summary(_execs, t2.tv_sec - t1.tv_sec, crashes, hangs);
+      if (crashes > 0) {
+        std::cout << Yellow << std::left << std::setw(15)
+                  << "Buckets:" << Reset << std::right << Green << std::setw(8)
+                  << fuzzberg::CrashBuckets(crash_dir).size() << Reset
+                  << "\n\n";
+      }
+      return crashes + hangs > 0 ? 1 : 0;
+    }
+    std::signal(SIGINT, interrupt);
+    workers->configure_worker(*fuzz_target, worker_index, arg_strings);
+    fuzz_target->master_seed = master_seed + worker_index;
+    std::cout << Green << "[INFO] Worker seed: " << Reset << "0x" << std::hex
+              << fuzz_target->master_seed << std::dec << "\n"
+              << std::endl;
+  }
+
+  // --parquet-scale: what each synthesized file cost the target is
+  // appended to <output>/scale.csv, one report per worker with --jobs.
+  if (parquet_scale && !crash_dir.empty()) {
+    std::error_code ec;
+    std::filesystem::create_directories(crash_dir, ec);
+    fuzz_target->scale_report =
+        crash_dir + "/scale" +
+        (workers ? "-w" + std::to_string(worker_index) : "") + ".csv";
+  }
+
+  // Coverage map: created before the target is forked so the target
+  // inherits its id, one per worker with --jobs.
+  std::unique_ptr<fuzzberg::CoverageMap> coverage;
+  if (use_coverage) {
+    if (crash_dir.empty()) {
+      std::cerr << "Error: --coverage requires an output (crash) directory\n";
+      exit(1);
+    }
+    std::string queue_dir = crash_dir + "/queue";
+    if (workers) {
+      queue_dir += "/w" + std::to_string(worker_index);
+    }
+    coverage = std::make_unique<fuzzberg::CoverageMap>(queue_dir);
+    fuzz_target->coverage = coverage.get();
+    std::cout << Green << "[INFO] Coverage feedback enabled, queue: " << Reset
+              << queue_dir << "\n"
+              << std::endl;
+  }
+
+  // Minimize mode: no corpus and no fuzzing, only the target and the
+  // queries. Ctrl+C stops between executions and keeps the best so far.
+  if (!minimize_path.empty()) {
+    if (workers || !replay_path.empty()) {
+      std::cerr << "Error: --minimize can't be combined with --jobs or "
+                   "--replay\n";
+      exit(1);
+    }
+    std::signal(SIGINT, interrupt_workers);
+    fuzz_target->max_inflight = 1;
+    target_pid = fuzz_target->ForkTarget();
+    size_t failed = 0;
+    {
+      fuzzberg::Minimizer minimizer(*fuzz_target, coverage.get(),
+                                    interrupted);
+      failed = fuzzberg::minimize_inputs(minimizer, minimize_path);
+      std::cout << "\n"
+                << Yellow << std::left << std::setw(15)
+                << "Executions:" << Reset << std::right << Green
+                << std::setw(8) << minimizer.execs() << Reset << "\n\n";
+    }
+    kill(fuzz_target->target_pid, SIGKILL);
+    waitpid(fuzz_target->target_pid, &status, 0);
+    target_pid = 0;
+    fuzz_target->cleanup();
+    return failed > 0 ? 1 : 0;
+  }
 
-  // Track whether the cleanup path observed a crash so main() can
-  // propagate it as a non-zero exit. Without this, main always
-  // returned 0 even after detecting a real SIGSEGV/SIGABRT from the
-  // target — orchestrators / CI gating on the exit code never tripped.
-  bool target_crashed = false;
+  // Load seed corpus; --parquet-scale synthesizes its files and runs
+  // without one.
+  if (parquet_scale && corpus_dir.empty()) {
+    std::cout << "No seed corpus: --parquet-scale synthesizes every file\n"
+              << std::endl;
+  } else if (fuzz_target->replay) {
+    std::cout << "Loading seed corpus from: " << corpus_dir << "\n"
+              << std::endl;
+    fuzz_target->_load_corpus(corpus_dir, replay.shard_index,
+                              replay.shard_count);
+    std::string queue_dir = crash_dir + "/queue";
+    if (replay.shard_count > 1) {
+      queue_dir += "/w" + std::to_string(replay.shard_index);
+    }
+    fuzzberg::prepare_replay_corpus(*fuzz_target, replay, queue_dir);
+  } else {
+    std::cout << "Loading seed corpus from: " << corpus_dir << "\n"
+              << std::endl;
+    fuzz_target->_load_corpus(corpus_dir, worker_index, jobs);
+  }
+
+  // Count what the cleanup path observed so main() can propagate it as
+  // a non-zero exit. Without this, main always returned 0 even after
+  // detecting a real SIGSEGV/SIGABRT from the target — orchestrators / CI
+  // gating on the exit code never tripped. volatile because both are
+  // bumped after sigsetjmp() below and read again once SIGINT longjmps
+  // back to interrupt:, where a register copy would be stale.
+  volatile size_t crashes = 0;
+  volatile size_t hangs = 0;
+  bool found_crash = false; // set by cleanup_inspect for this target
+  int8_t fuzz_status = 0;
+
+  // Crashes are filed by signature (see Session/CrashTriage.h), so a bug
+  // hit a thousand times keeps one input; hangs carry no stack to bucket
+  // on and are written individually. A replay only reports.
+  fuzzberg::CrashBuckets buckets(crash_dir);
+  auto record_finding = [&](const char *kind, int wait_status) {
+    std::string report = fuzz_target->target_stderr.drain();
+    bool is_crash = std::strcmp(kind, "crash") == 0;
+    fuzzberg::crash_signature sig;
+    if (is_crash) {
+      sig = fuzzberg::parse_crash_report(report, wait_status);
+      // --parquet-scale keeps a recipe, not the input: a bucket of its own
+      // so it never stands in for a mutated file with the same stack.
+      if (fuzz_target->parquet_scale) {
+        sig.tag("scale");
+      }
+    }
+    if (fuzz_target->replay) {
+      std::cout << "\033[1;31m[!] Reproduced (" << kind;
+      if (is_crash) {
+        std::cout << " " << sig.id() << ", " << sig.kind;
+      }
+      std::cout << ")\033[0m\n";
+      return;
+    }
+    auto log = fuzzberg::replay_log(*fuzz_target);
+    if (!is_crash) {
+      std::cout << "Writing " << kind << " data to: " << crash_dir << "\n\n";
+      fuzz_target->_write_crash(fuzz_target->radamsa_output, crash_dir, kind,
+                                &log);
+      return;
+    }
+    auto verdict = buckets.record(sig, fuzz_target->radamsa_output,
+                                  fuzz_target->crash_size, report, &log);
+    std::string where = sig.frames.empty() ? "" : " in " + sig.frames[0];
+    if (verdict.is_new) {
+      std::cout << "\033[1;31m[!] New crash bucket " << sig.id() << "\033[0m ("
+                << sig.kind << where << ")\n"
+                << "Crash data written to: " << verdict.artifact << "\n"
+                << "Replay with: --replay " << verdict.artifact
+                << ".replay.json\n\n";
+    } else {
+      std::cout << "\033[1;33m[-] Known crash " << sig.id() << "\033[0m ("
+                << sig.kind << where << ", seen " << verdict.count
+                << " times)\n\n";
+    }
+  };
 
   if (sigsetjmp(env, 1) != 0) {
     // jumps to interrupt: from SIGHANDLER
@@ -349,31 +1031,69 @@ int main(int argc, char *argv[]) {
 
   // Fork and exec the target database
   target_pid = fuzz_target->ForkTarget();
+  if (workers) {
+    workers->report_from(fuzz_target->execs);
+  }
 
   // call fuzzer
   gettimeofday(&t1, NULL);
 fuzz:
-  if (fuzz_target->fuzz() == -1) {
+  fuzz_status = fuzz_target->fuzz();
+  if (fuzz_target->replay && fuzz_status == 0) {
+    std::cout << Green << "\n[INFO] Replayed iteration completed, the target "
+              << "survived" << Reset << "\n";
+    kill(fuzz_target->target_pid, SIGKILL);
+    waitpid(fuzz_target->target_pid, &status, 0);
+    target_pid = 0;
+    goto interrupt;
+  }
+  if (fuzz_status == -2) {
+    // The target stopped answering and the fuzzer has already SIGKILLed
+    // it; this used to end the whole session.
+    waitpid(fuzz_target->target_pid, &status, 0);
+    target_pid = 0;
+    std::cout << "\nTarget timed out\n\n";
+    record_finding("hang", status);
+    hangs++;
+    if (workers) {
+      workers->record_crash(true);
+    }
+    if (persistent) {
+      if (max_hangs == 0 || hangs < max_hangs) {
+        goto restart;
+      }
+      std::cout << "\033[1;33m[INFO] Hang budget exhausted\033[0m\n";
+    }
+    goto interrupt;
+  }
+  if (fuzz_status == -1) {
     // When fuzz() returns -1, the target server may either be already
     // dead (real crash — curl couldn't connect because the engine
     // SEGV'd / aborted) or still healthy (harness error — empty
-    // corpus, transport hiccup, file-system error). Distinguish via
-    // WNOHANG:
+    // corpus, transport hiccup, file-system error). Distinguish by
+    // giving the target a bounded grace period to finish dying:
     //
-    //   * still alive (WNOHANG returns 0) → harness error; SIGKILL the
+    //   * still alive after the grace period → harness error; SIGKILL the
     //     target, reap with blocking waitpid, and route past the
     //     crash-detection logic via the `interrupt` label so we don't
     //     write a bogus crash artifact for the SIGKILL we sent.
-    //   * already dead (WNOHANG returns child_pid) → real crash;
+    //   * dead (reaped within the grace period) → real crash;
     //     feed its status into the crash-detection logic.
-    //   * WNOHANG < 0 (ECHILD) → fall through to cleanup as-is.
+    //   * neither (ECHILD) → fall through to cleanup as-is.
     //
     // Without this distinguisher the previous behavior (unconditional
     // blocking waitpid) stalls for the outer timeout budget on harness
     // errors and masks them as long silent runs.
+    // A single immediate WNOHANG raced the target's own teardown: curl
+    // sees the connection drop before the kernel has reaped the crashing
+    // process, so real crashes were misreported as harness errors.
     int wn_status = 0;
-    pid_t wn = waitpid(fuzz_target->target_pid, &wn_status, WNOHANG);
-    if (wn == 0) {
+    if (fuzzberg::wait_for_exit(fuzz_target->target_pid, wn_status,
+                                fuzzberg::kCrashExitGraceMs)) {
+      status = wn_status;
+      goto cleanup_inspect;
+    }
+    if (kill(fuzz_target->target_pid, 0) == 0) {
       std::cerr << "fuzz() returned -1 but target still running — "
                    "treating as harness error, not crash\n";
       if (fuzz_target->target_pid > 0) {
@@ -382,10 +1102,6 @@ fuzz:
       }
       goto interrupt;
     }
-    if (wn > 0) {
-      status = wn_status;
-      goto cleanup_inspect;
-    }
     goto cleanup;
   }
 
@@ -394,6 +1110,8 @@ cleanup:
     std::perror("waitpid failed");
   }
 cleanup_inspect:
+  target_pid = 0; // reaped
+  found_crash = false;
   if (WIFSIGNALED(status)) {
     int signal = WTERMSIG(status);
     if (signal == SIGSEGV) {
@@ -401,9 +1119,8 @@ cleanup_inspect:
     } else if (signal == SIGABRT) {
       std::cout << "\nTarget crashed with SIGABRT\n\n" << std::endl;
     }
-    std::cout << "Writing crash data to: " << crash_dir << "\n\n";
-    fuzz_target->_write_crash(fuzz_target->radamsa_output, crash_dir);
-    target_crashed = true;
+    record_finding("crash", status);
+    found_crash = true;
   } else if (WIFEXITED(status)) {
     // WEXITSTATUS is only defined when WIFEXITED is true; reading it
     // after WIFSIGNALED / WIFSTOPPED is UB. With default waitpid
@@ -411,30 +1128,53 @@ cleanup_inspect:
     // mostly a robustness improvement against future option changes.
     if (WEXITSTATUS(status) != 0) {
       std::cout << "Target process exited abnormally\n";
-      fuzz_target->_write_crash(fuzz_target->radamsa_output, crash_dir);
-      target_crashed = true;
+      record_finding("crash", status);
+      found_crash = true;
     }
   }
+  if (found_crash) {
+    crashes++;
+    if (workers) {
+      workers->record_crash();
+    }
+    if (persistent) {
+      if (max_crashes == 0 || crashes < max_crashes) {
+        goto restart;
+      }
+      std::cout << "\033[1;33m[INFO] Crash budget exhausted\033[0m\n";
+    }
+  }
+  goto interrupt;
+
+restart: // --continue: same fuzzer state, fresh target and curl handle
+  std::cout << "\033[1;33m[INFO] Restarting target (crashes: " << crashes
+            << ", hangs: " << hangs << ")\033[0m\n"
+            << std::endl;
+  target_pid = fuzz_target->RestartTarget();
+  goto fuzz;
 
 interrupt:                     // section executed on receiving SIGINT
   _execs = fuzz_target->execs; // get number of queries executed by fuzzer
+  if (workers) {
+    workers->finish_worker(_execs);
+  }
 
   fuzz_target->cleanup(); // cleanup fuzzer state
   gettimeofday(&t2, NULL);
-  auto elapsedTime = (t2.tv_sec - t1.tv_sec);
-
-  size_t seconds = elapsedTime % 60;
-  size_t minutes = (elapsedTime / 60) % 60;
-  size_t hours = (elapsedTime / 3600) % 24;
-  size_t days = elapsedTime / (3600 * 24);
-
-  std::cout << "\n"
-            << Yellow << std::left << std::setw(15) << "Executions:" << Reset
-            << std::right << Green << std::setw(8) << _execs << Reset << "\n"
-            << Yellow << std::left << std::setw(15) << "Elapsed Time:" << Reset
-            << std::right << Green << std::setw(2) << days << "d "
-            << std::setw(2) << hours << "h " << std::setw(2) << minutes << "m "
-            << std::setw(2) << seconds << "s" << Reset << "\n\n";
+  print_summary(_execs, t2.tv_sec - t1.tv_sec, crashes, hangs);
+  if (crashes > 0 && !fuzz_target->replay) {
+    std::cout << Yellow << std::left << std::setw(15) << "Buckets:" << Reset
+              << std::right << Green << std::setw(8) << buckets.size() << Reset
+              << "\n\n";
+  }
+  if (coverage) {
+    std::cout << Yellow << std::left << std::setw(15) << "Edges:" << Reset
+              << std::right << Green << std::setw(8) << coverage->edges()
+              << Reset << "\n"
+              << Yellow << std::left << std::setw(15) << "Queued:" << Reset
+              << std::right << Green << std::setw(8) << coverage->queued()
+              << Reset << "\n\n";
+  }
 
-  return target_crashed ? 1 : 0;
+  return crashes + hangs > 0 ? 1 : 0;
 }
\ No newline at end of file
@@ -0,0 +1,87 @@
+/*
+
+  Fuzzberg - a fuzzer for Iceberg and other file-format readers
+  --------------------------------------------------------------
+
+  Copyright 2025 [Firebolt Analytics, Inc.]. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+*/
+
+
+// Regression tests for the Thrift compact decoder, which runs on mutated
+// footers and page headers. Returns non-zero on the first failure.
+
+#include <FileFormats/Thrift.h>
+
+#include <iostream>
+#include <string>
+
+using namespace fuzzberg;
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+  if (!ok) {
+    std::cerr << "FAILED: " << what << std::endl;
+    ++failures;
+  }
+}
+
+// Field 1 of a struct: `levels` lists, each holding the next one, the
+// innermost empty.
+std::string nested_lists(size_t levels) {
+  std::string data(1, '\x19');     // field 1, a list
+  data.append(levels - 1, '\x19'); // of one element, a list
+  data += '\x05';                  // of no elements (i32)
+  data += '\x00';                  // stop
+  return data;
+}
+
+} // namespace
+
+int main() {
+  // Within the limit: decodes and re-encodes to the same bytes.
+  {
+    const std::string data = nested_lists(16);
+    thrift_value value;
+    check(thrift_decode_struct(data.data(), data.size(), value) ==
+              data.size(),
+          "16 nested lists decode");
+    std::string encoded;
+    thrift_encode_struct(value, encoded);
+    check(encoded == data, "16 nested lists round-trip");
+  }
+  // Containers nest without a struct between them: this used to recurse
+  // once per byte and overflow the stack.
+  {
+    const std::string data = nested_lists(2000000);
+    thrift_value value;
+    check(thrift_decode_struct(data.data(), data.size(), value) == 0,
+          "2000000 nested lists are rejected");
+  }
+  // Maps count towards the same limit.
+  {
+    std::string data(1, '\x1b'); // field 1, a map
+    for (int i = 0; i < 1000; ++i) {
+      data += "\x01\xbb"; // one entry, map keys and values: the key next
+    }
+    thrift_value value;
+    check(thrift_decode_struct(data.data(), data.size(), value) == 0,
+          "deeply nested maps are rejected");
+  }
+  return failures ? 1 : 0;
+}